@@ -1,29 +1,164 @@
+#include <charconv>
+#include <chrono>
+#include <cstdio>
 #include <filesystem>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "EventLoop.hpp"
 #include "InetAddress.hpp"
 #include "Log.hpp"
 #include "http/HttpServer.hpp"
 
+namespace {
+constexpr char kUsage[] =
+    "usage: %s [options] [port] [storageDir] [staticDir]\n"
+    "  port                 TCP port to listen on (default 9200)\n"
+    "  storageDir           directory for uploaded files (default storage)\n"
+    "  staticDir            directory for dashboard assets (default www)\n"
+    "  --busy-poll-us=N     busy-poll window in microseconds (default 0, off)\n"
+    "  --no-io-uring        use the disk I/O thread pool instead of io_uring\n"
+    "  --dedup              store identical content once (content-addressed)\n"
+    "  --hot-tier-mib=N     keep small hot files in an N MiB memory tier\n"
+    "  --memory-only-mib=N  keep all files in N MiB of memory, nothing on disk\n"
+    "  --sharded            hash-sharded layout with a persistent metadata index\n"
+    "  --help               print this message\n";
+
+struct Options {
+    std::string           port{"9200"};
+    std::filesystem::path storageDir{"storage"};
+    std::filesystem::path staticDir{"www"};
+    uint64_t              busyPollUs{0};     // 忙轮询窗口（微秒），0 表示关闭
+    bool                  ioUring{true};     // 为 false 时存储 I/O 改用线程池
+    bool                  dedup{false};      // 内容寻址去重，相同内容只保存一份
+    uint64_t              hotTierMiB{0};     // 内存热层容量，0 表示关闭
+    uint64_t              memoryOnlyMiB{0};  // 文件只保存在内存中（压测用），0 表示关闭
+    bool                  sharded{false};    // 按名字哈希分片存放，元数据保存在持久化索引中
+};
+
+// 整个字符串必须是不超过 max 的十进制数
+bool parseNumber(std::string_view text, uint64_t max, uint64_t& value) {
+    const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return !text.empty() && ec == std::errc{} && ptr == text.data() + text.size() && value <= max;
+}
+
+// "--name=N" 形式的数值选项；不是该选项时返回 false，值无效时置 bad
+bool numberOption(std::string_view arg,
+                  std::string_view name,
+                  uint64_t         max,
+                  uint64_t&        value,
+                  bool&            bad) {
+    if (arg.substr(0, name.size()) != name || arg.substr(name.size(), 1) != "=") {
+        return false;
+    }
+    bad = !parseNumber(arg.substr(name.size() + 1), max, value);
+    return true;
+}
+
+// 解析失败时打印原因，返回 false
+bool parseOptions(int argc, char** argv, Options& options) {
+    constexpr uint64_t       kMaxMiB = 1024 * 1024;  // 1 TiB
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg{argv[i]};
+        bool                   bad = false;
+        if (arg == "--no-io-uring") {
+            options.ioUring = false;
+        } else if (arg == "--dedup") {
+            options.dedup = true;
+        } else if (arg == "--sharded") {
+            options.sharded = true;
+        } else if (numberOption(arg, "--busy-poll-us", 1000000, options.busyPollUs, bad) ||
+                   numberOption(arg, "--hot-tier-mib", kMaxMiB, options.hotTierMiB, bad) ||
+                   numberOption(arg, "--memory-only-mib", kMaxMiB, options.memoryOnlyMiB, bad)) {
+            if (bad) {
+                std::fprintf(stderr, "invalid value in %s\n", argv[i]);
+                return false;
+            }
+        } else if (arg.substr(0, 2) == "--") {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            return false;
+        } else {
+            positional.emplace_back(arg);
+        }
+    }
+    if (positional.size() > 3) {
+        std::fprintf(stderr, "unexpected argument %s\n", positional[3].c_str());
+        return false;
+    }
+    uint64_t port = 0;
+    if (!positional.empty()) {
+        if (!parseNumber(positional[0], 65535, port)) {
+            std::fprintf(stderr, "invalid port %s\n", positional[0].c_str());
+            return false;
+        }
+        options.port = positional[0];
+    }
+    if (positional.size() > 1) {
+        options.storageDir = positional[1];
+    }
+    if (positional.size() > 2) {
+        options.staticDir = positional[2];
+    }
+    if (options.hotTierMiB > 0 && options.memoryOnlyMiB > 0) {
+        std::fprintf(stderr, "--hot-tier-mib and --memory-only-mib are exclusive\n");
+        return false;
+    }
+    return true;
+}
+}  // namespace
+
 int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string_view{argv[i]} == "--help") {
+            std::printf(kUsage, argv[0]);
+            return 0;
+        }
+    }
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, kUsage, argv[0]);
+        return 2;
+    }
+
     Server::initLogger();
 
-    const std::string           port = (argc > 1) ? argv[1] : std::string{"9200"};
-    const std::filesystem::path storageDir =
-        (argc > 2) ? std::filesystem::path{argv[2]} : std::filesystem::path{"storage"};
-    const std::filesystem::path staticDir =
-        (argc > 3) ? std::filesystem::path{argv[3]} : std::filesystem::path{"www"};
+    // 所有连接解析缓冲合计上限，超出后新数据以 503 拒绝
+    Http::HttpParser::setBufferBudget(256 * 1024 * 1024);
 
     Server::EventLoop   loop;
-    Server::InetAddress listenAddr(port);
-    Http::HttpServer    httpServer(&loop, listenAddr, storageDir, staticDir);
+    Server::InetAddress listenAddr(options.port);
+    Http::HttpServer    httpServer(&loop, listenAddr, options.storageDir, options.staticDir);
+    if (options.busyPollUs > 0) {
+        const auto busyPollUs = static_cast<int>(options.busyPollUs);
+        loop.setBusyPollWindow(std::chrono::microseconds{busyPollUs});
+        httpServer.setBusyPoll(busyPollUs, true);
+        LOG_INFO("busy-poll enabled: window={}us", busyPollUs);
+    }
+
+    if (!options.ioUring) {
+        httpServer.setIoUring(false);
+    }
+    if (options.dedup) {
+        httpServer.setDeduplication(true);
+        LOG_INFO("content-addressed deduplication enabled");
+    }
+    if (options.sharded) {
+        httpServer.setShardedStorage(true);
+        LOG_INFO("sharded storage layout enabled");
+    }
+    if (options.memoryOnlyMiB > 0) {
+        httpServer.setMemoryStorage(options.memoryOnlyMiB * 1024 * 1024);
+    } else if (options.hotTierMiB > 0) {
+        httpServer.setHotTier(options.hotTierMiB * 1024 * 1024);
+    }
 
     httpServer.start();
     LOG_INFO("http file server listening on port {} (storage={}, static={})",
-             port,
-             storageDir.string(),
-             staticDir.string());
+             options.port,
+             options.storageDir.string(),
+             options.staticDir.string());
 
     loop.loop(1000);
     return 0;
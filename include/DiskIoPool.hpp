@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Server {
+
+class EventLoop;
+
+// 磁盘 I/O 线程池：阻塞的文件操作（open/read/rename/unlink 等）在工作线程执行，
+// 完成回调经 EventLoop::queueInLoop 回到所属 loop 线程，因此一块慢盘不会拖住所有连接。
+// 排队任务数有上限，超出时 submit 立即返回 false，由调用方拒绝请求（如回复 503）。
+class DiskIoPool {
+  public:
+    using Task = std::function<void()>;
+
+    // 以下统计只在 loop 线程读写（queued 除外，读取时加锁）
+    struct Stats {
+        uint64_t submitted{0};
+        uint64_t completed{0};
+        uint64_t rejected{0};   // 队列已满被拒绝
+        size_t   queued{0};     // 当前排队、尚未开始执行的任务数
+        size_t   inFlight{0};   // 已提交、完成回调尚未执行的任务数（含排队中的）
+        size_t   maxQueued{0};  // 排队深度的历史最大值
+        uint64_t waitNs{0};     // 累计排队时间（提交 → 开始执行）
+        uint64_t serviceNs{0};  // 累计执行时间
+        uint64_t latencyNs{0};  // 累计总延迟（提交 → 完成回调开始）
+        uint64_t maxLatencyNs{0};
+    };
+
+    DiskIoPool(EventLoop* loop, size_t threads, size_t maxQueued);
+    // 丢弃尚未开始的任务并等待执行中的任务结束；它们的完成回调不再执行
+    ~DiskIoPool();
+
+    DiskIoPool(const DiskIoPool&)            = delete;
+    DiskIoPool& operator=(const DiskIoPool&) = delete;
+
+    // 只能在 loop 线程调用。work 在工作线程执行，done 随后在 loop 线程执行
+    bool submit(Task work, Task done);
+
+    [[nodiscard]] Stats  stats() const;
+    [[nodiscard]] size_t threads() const {
+        return workers_.size();
+    }
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Job {
+        Task              work;
+        Task              done;
+        Clock::time_point submitted;
+        Clock::time_point started;
+        Clock::time_point finished;
+    };
+
+    void workerLoop();
+    void complete(const Job& job);
+
+    EventLoop*                       loop_;
+    size_t                           maxQueued_;
+    std::vector<std::thread>         workers_;
+    mutable std::mutex               mutex_;
+    std::condition_variable          cond_;
+    std::deque<std::unique_ptr<Job>> queue_;
+    bool                             stopping_{false};
+    Stats                            stats_;
+    std::shared_ptr<DiskIoPool*>     self_;  // 完成回调持有其 weak_ptr，池析构后不再执行
+};
+
+}  // namespace Server
@@ -1,5 +1,9 @@
 #pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 namespace Server {
@@ -7,9 +11,20 @@ namespace Server {
 class Channel;
 class EpollPoller;
 
+// 事件循环的耗时统计（纳秒累计值），用于评估忙轮询的 CPU 代价与收益
+struct LoopStats {
+    uint64_t iterations{0};  // 循环总轮数
+    uint64_t spinPolls{0};   // 忙轮询阶段 epoll_wait(0) 的次数
+    uint64_t spinNs{0};      // 忙轮询阶段等待事件所花的时间
+    uint64_t blockNs{0};     // 阻塞在 epoll_wait(timeout) 上的时间
+    uint64_t workNs{0};      // 执行 channel 回调（有效工作）的时间
+};
+
 // 对epoll的分装, 对外提供更多的接口, 用来执行channel, 这个类也不拥有channel
 class EventLoop {
   public:
+    using Functor = std::function<void()>;
+
     EventLoop();
     ~EventLoop();
 
@@ -19,9 +34,36 @@ class EventLoop {
     void updateChannel(Channel* channel);
     void removeChannel(Channel* channel);
 
+    // 可在任意线程调用：functor 在 loop 线程处理完本轮事件后执行，必要时唤醒阻塞中的 epoll_wait。
+    // 用于工作线程（如磁盘 I/O 线程池）把完成通知交回 loop 线程
+    void queueInLoop(Functor functor);
+
+    // 混合忙轮询：最近一次有事件后的 window 时间内以 epoll_wait(0) 自旋，之后再阻塞等待。
+    // window 为 0 表示关闭（默认），适合延迟敏感、愿意用 CPU 换 p99 的部署。
+    void setBusyPollWindow(std::chrono::microseconds window) {
+        busyPollWindow_ = window;
+    }
+    [[nodiscard]] std::chrono::microseconds busyPollWindow() const {
+        return busyPollWindow_;
+    }
+
+    [[nodiscard]] const LoopStats& stats() const {
+        return stats_;
+    }
+
   private:
+    void handleWakeup();
+    void doPendingFunctors();
+
     std::unique_ptr<EpollPoller> poller_;
     // std::unordered_map<int, std::shared_ptr<Channel>> channels_;
-    std::vector<Channel*> activeChannels_;
+    std::vector<Channel*>     activeChannels_;
+    std::chrono::microseconds busyPollWindow_{0};
+    LoopStats                 stats_;
+
+    int                      wakeupFd_{-1};  // eventfd
+    std::unique_ptr<Channel> wakeupChannel_;
+    std::mutex               mutex_;  // 保护 pendingFunctors_
+    std::vector<Functor>     pendingFunctors_;
 };
 }  // namespace Server
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <linux/io_uring.h>
+
+#include <cstddef>
+#include <functional>
+
+namespace Server {
+
+// io_uring 的最小封装（直接使用系统调用，不依赖 liburing）：映射提交/完成队列，
+// 取空闲 SQE、提交与收割 CQE。完成通知写入注册的 eventfd，由调用方接入 EventLoop。
+// 内核不支持或已禁用（ENOSYS/EPERM 等）时 valid() 为 false，调用方应退回线程池。
+// 非线程安全，只在所属 loop 线程使用。
+class IoUring {
+  public:
+    explicit IoUring(unsigned entries);
+    ~IoUring();
+
+    IoUring(const IoUring&)            = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    [[nodiscard]] bool valid() const {
+        return ringFd_ >= 0;
+    }
+    // 有完成事件时可读（计数器语义，读出即清零）
+    [[nodiscard]] int eventFd() const {
+        return eventFd_;
+    }
+    [[nodiscard]] unsigned entries() const {
+        return sqEntries_;
+    }
+
+    // 提交队列中还能填写的 SQE 数
+    [[nodiscard]] unsigned space() const;
+    // 取一个已清零的 SQE，提交队列已满时返回 nullptr；填写后由 submit() 一并提交
+    io_uring_sqe* getSqe();
+    // 提交所有已填写、内核尚未取走的 SQE；返回本次提交数，失败返回 -errno
+    int submit();
+    // 依次处理已完成的 CQE，返回处理数。handler 中可以继续 getSqe()/submit()
+    size_t reap(const std::function<void(const io_uring_cqe&)>& handler);
+    // 阻塞直到至少有一个完成事件（用于析构前等待内核释放缓冲区）
+    int wait();
+
+  private:
+    void release();
+
+    int      ringFd_{-1};
+    int      eventFd_{-1};
+    unsigned sqEntries_{0};
+    unsigned sqeTail_{0};  // 已填写到的位置，submit() 时发布给内核
+
+    void*  sqRing_{nullptr};
+    void*  cqRing_{nullptr};  // 内核支持单次映射时与 sqRing_ 相同
+    size_t sqRingBytes_{0};
+    size_t cqRingBytes_{0};
+
+    io_uring_sqe* sqes_{nullptr};
+    size_t        sqesBytes_{0};
+    unsigned*     sqHead_{nullptr};
+    unsigned*     sqTail_{nullptr};
+    unsigned*     sqMask_{nullptr};
+    unsigned*     sqArray_{nullptr};
+    unsigned*     cqHead_{nullptr};
+    unsigned*     cqTail_{nullptr};
+    unsigned*     cqMask_{nullptr};
+    io_uring_cqe* cqes_{nullptr};
+};
+
+}  // namespace Server
@@ -48,6 +48,14 @@ class Socket {
     // 注意：探测间隔/重试次数通常需要通过 TCP 层 sysctl 或 TCP_KEEP* 选项进一步配置。
     void setKeepAlive(bool on = true) const;
 
+    // SO_BUSY_POLL：阻塞读/poll 时在驱动队列上忙轮询 usec 微秒（0 关闭）。
+    // 超过 net.core.busy_read 时需要 CAP_NET_ADMIN；失败仅告警并返回 false，不抛异常，
+    // 因为它通常作用在 accept 得到的连接上，不应影响连接建立。
+    bool setBusyPoll(int usec) const;
+
+    // SO_PREFER_BUSY_POLL（Linux 5.11+）：忙轮询期间优先于软中断处理收包。失败同上。
+    bool setPreferBusyPoll(bool on = true) const;
+
     // for client
     void connect(const InetAddress& serveraddr) const;
     // 便捷重载：内部构造 InetAddress
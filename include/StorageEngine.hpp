@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Server {
+
+class Channel;
+class DiskIoPool;
+class EventLoop;
+class IoUring;
+
+// 存储 I/O 引擎：文件读写优先经 io_uring 异步提交，完成回调在 loop 线程执行；
+// io_uring 不可用（或被关闭）时改由 DiskIoPool 的工作线程执行 pread/pwrite，接口不变。
+// 大块读取按 kChunkSize 拆成多个并发请求；readToSocket 用链接的 read→send 把文件数据
+// 在内核中直接送到套接字。调用方负责在回调之前保持 fd 打开。只在 loop 线程使用。
+class StorageEngine {
+  public:
+    static constexpr size_t kChunkSize = 256 * 1024;
+
+    using ReadCallback  = std::function<void(int err, std::string data)>;  // err 为 0 或 errno
+    using WriteCallback = std::function<void(int err)>;
+    // sent 为已写入套接字的字节数；链在中途断开（短读、套接字缓冲已满）时，
+    // rest 为已从文件读出但未发出的数据，由调用方接着发送
+    using SendCallback = std::function<void(int err, uint64_t sent, std::string rest)>;
+
+    struct Stats {
+        uint64_t reads{0};   // 读请求数（拆分后的块数）
+        uint64_t writes{0};  // 写请求数
+        uint64_t linkedSends{0};
+        uint64_t bytesRead{0};
+        uint64_t bytesWritten{0};
+        uint64_t bytesSent{0};  // 经链接 send 直接写入套接字的字节数
+        uint64_t errors{0};
+        size_t   inFlight{0};  // 已提交、尚未完成的请求数
+        size_t   backlog{0};   // 提交队列已满、等待提交的请求数
+    };
+
+    // useIoUring 为 false 时直接使用线程池（便于对比与排障）；queueDepth 为 io_uring 提交队列深度
+    StorageEngine(EventLoop*  loop,
+                  DiskIoPool* pool,
+                  bool        useIoUring = true,
+                  unsigned    queueDepth = 256);
+    // 等待已提交给内核的请求结束（缓冲区在此之前不能释放），不再执行它们的回调
+    ~StorageEngine();
+
+    StorageEngine(const StorageEngine&)            = delete;
+    StorageEngine& operator=(const StorageEngine&) = delete;
+
+    [[nodiscard]] bool usingIoUring() const {
+        return ring_ != nullptr;
+    }
+    [[nodiscard]] Stats stats() const;
+
+    // 读取 [offset, offset + length)；文件在读取期间被截短时以 EIO 失败
+    void read(int fd, uint64_t offset, size_t length, ReadCallback done);
+    // 在 offset 处写入全部 data
+    void write(int fd, uint64_t offset, std::string data, WriteCallback done);
+    // 把文件 [offset, offset + length) 经链接的 read→send 写入 sockFd（以 kChunkSize 为单位）。
+    // 仅 io_uring 可用时支持，否则返回 false 且不调用 done。调用期间套接字不能有其他写入
+    bool readToSocket(int fd, uint64_t offset, size_t length, int sockFd, SendCallback done);
+
+  private:
+    struct Op;
+    struct ReadJob;
+    struct SendChain;
+
+    void readChunk(const std::shared_ptr<ReadJob>& job, uint64_t offset, size_t pos, size_t len);
+    void writeChunk(int                          fd,
+                    uint64_t                     offset,
+                    std::shared_ptr<std::string> data,
+                    size_t                       pos,
+                    WriteCallback                done);
+    // 成组提交（链接的请求必须连续进入提交队列）；队列不够时整组排进 backlog_
+    void enqueue(std::vector<std::unique_ptr<Op>> group);
+    bool trySubmit(std::vector<std::unique_ptr<Op>>& group);
+    void submit();
+    void handleCompletions();
+    // 在 loop 线程稍后执行，避免在调用方的栈上同步回调
+    void defer(std::function<void()> fn);
+
+    EventLoop*                                    loop_;
+    DiskIoPool*                                   pool_;
+    std::unique_ptr<IoUring>                      ring_;
+    std::unique_ptr<Channel>                      channel_;
+    std::deque<std::vector<std::unique_ptr<Op>>>  backlog_;
+    bool                                          reaping_{false};  // 正在处理完成事件
+    Stats                                         stats_;
+    std::shared_ptr<StorageEngine*>               self_;  // 线程池回调持有其 weak_ptr
+};
+
+}  // namespace Server
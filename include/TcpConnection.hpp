@@ -3,6 +3,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <string_view>
 
 namespace Server {
 
@@ -46,14 +47,29 @@ class TcpConnection : public std::enable_shared_from_this<TcpConnection> {
     void shutdown();
     // 强制立即关闭
     void forceClose();
+    // 暂停 / 恢复读取：上层暂时无法处理更多数据时施加背压，未读数据留在内核缓冲区
+    void stopReading();
+    void startReading();
 
-    // 发送数据（追加到发送缓冲，注册写事件）
-    void send(const std::string& data);
+    // 发送数据（追加到发送缓冲，注册写事件）。more 紧随 data 之后，缓冲为空时两段一起 writev，
+    // 例如响应头与映射中的文件内容
+    void send(std::string_view data, std::string_view more = {});
 
     EventLoop* getLoop() const {
         return loop_;
     }
+    bool connected() const {
+        return state_ == kConnected;
+    }
+    // 发送缓冲中尚未写出的字节数，上层据此做流量控制
+    size_t pendingBytes() const {
+        return outputBuffer_.size();
+    }
     int fd() const;  // 便捷
+    // 便于上层按需调整套接字选项（TCP_NODELAY/SO_BUSY_POLL 等）
+    const Socket& socket() const {
+        return *socket_;
+    }
 
   private:
     enum StateE { kConnecting, kConnected, kDisconnecting, kDisconnected };
@@ -35,6 +35,13 @@ class TcpServer {
         writeCompleteCallback_ = std::move(cb);
     }
 
+    // 对新接受的连接设置 SO_BUSY_POLL（usec>0 时生效）以及可选的 SO_PREFER_BUSY_POLL，
+    // 与 EventLoop::setBusyPollWindow 配合用于低延迟部署
+    void setBusyPoll(int usec, bool prefer = false) {
+        busyPollUsec_   = usec;
+        preferBusyPoll_ = prefer;
+    }
+
     // 开始监听
     void start();
 
@@ -50,5 +57,8 @@ class TcpServer {
     ConnectionCallback    connectionCallback_;  // 用户设置（可能为空）
     MessageCallback       messageCallback_;
     WriteCompleteCallback writeCompleteCallback_;
+
+    int  busyPollUsec_{0};
+    bool preferBusyPoll_{false};
 };
 }  // namespace Server
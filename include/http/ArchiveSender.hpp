@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "DiskIoPool.hpp"
+#include "StorageEngine.hpp"
+#include "TcpConnection.hpp"
+#include "http/Compression.hpp"
+#include "http/FileSender.hpp"
+#include "http/StorageBackend.hpp"
+
+namespace Http {
+
+// 把一组存储的文件打包成 tar 归档，作为 chunked 响应体边生成边发送，内存占用与文件数、大小无关。
+// 文件名由 NameSource 分批给出；对象在磁盘线程池中提前打开至多 kOpenAhead 个，按给出的顺序写入。
+// 不超过 kInlineBytes 的文件在打开时一并读出，与前后条目的头部合并进同一个块；
+// 更大的文件单独成块，由 FileSender 从 fd（链接的 read→send）或映射直接发送。
+// 压缩（gzip）时整个归档经 Deflater 压缩后分块发送，大文件按 StorageEngine::kChunkSize 逐段读取。
+// 连接发送缓冲积压超过 kHighWater 时暂停，由 onWriteComplete() 恢复。已被删除的文件跳过。
+class ArchiveSender : public std::enable_shared_from_this<ArchiveSender> {
+  public:
+    static constexpr size_t kOpenAhead   = 16;
+    static constexpr size_t kInlineBytes = 64 * 1024;
+    static constexpr size_t kFlushBytes  = 64 * 1024;  // 攒够后作为一个块发出
+    static constexpr size_t kHighWater   = FileSender::kHighWater;
+
+    // ok 为 false 表示读文件或写套接字失败，归档已不完整，调用方应关闭连接
+    using Done = FileSender::Done;
+    // 把下一批文件名追加到 names，不追加表示没有了。在 loop 线程调用
+    using NameSource = std::function<void(std::vector<std::string>& names)>;
+
+    // coding 为 IDENTITY 时输出 .tar，为 GZIP 时输出 .tar.gz（响应体本身，而非 Content-Encoding）
+    ArchiveSender(Server::StorageEngine&                  engine,
+                  Server::DiskIoPool&                     pool,
+                  StorageBackend&                         backend,
+                  Server::TcpConnection::TcpConnectionPtr conn,
+                  NameSource                              source,
+                  ContentCoding                           coding,
+                  int                                     level);
+
+    ArchiveSender(const ArchiveSender&)            = delete;
+    ArchiveSender& operator=(const ArchiveSender&) = delete;
+
+    // prefix（chunked 响应头）先于归档发出；done 总在 start() 返回之后调用
+    void start(std::string prefix, Done done);
+    // 连接发送缓冲清空时调用
+    void onWriteComplete();
+
+  private:
+    // 一个文件的打开结果，在线程池中填写
+    struct Entry {
+        std::string            name;
+        bool                   found{false};
+        std::error_code        ec;
+        StorageBackend::Object object;  // 小文件读出后 fd 已关闭
+        std::string            data;    // 小文件的全部内容
+
+        Entry() = default;
+        ~Entry();
+        Entry(const Entry&)            = delete;
+        Entry& operator=(const Entry&) = delete;
+    };
+    using EntryPtr = std::shared_ptr<Entry>;
+
+    void pump();
+    // 补足提前打开的文件；线程池队列已满时返回 false
+    bool openMore();
+    void addEntry(EntryPtr entry);
+    // 压缩模式下的大文件：写入一段，或发起一次读取
+    void pumpBody();
+    void onBodyRead(int err, std::string data);
+    void onBodySent(bool ok);
+    void endEntry(uint64_t size);
+    // 追加归档数据，压缩时先经过 Deflater；攒够 kFlushBytes 后发出
+    void write(std::string_view data);
+    // 把待发的原始字节与攒下的块移入 out
+    void takeChunk(std::string& out);
+    void flush(bool last);
+    void finish(bool ok);
+
+    Server::StorageEngine&                  engine_;
+    Server::DiskIoPool&                     pool_;
+    StorageBackend&                         backend_;
+    Server::TcpConnection::TcpConnectionPtr conn_;
+    NameSource                              source_;
+    std::unique_ptr<Deflater>               deflater_;
+    std::vector<std::string>                names_;         // 当前一批文件名
+    size_t                                  nameIndex_{0};  // names_ 中下一个要打开的
+    bool                                    sourceDone_{false};
+    uint64_t                                issued_{0};   // 已开始打开的文件数（序号）
+    uint64_t                                nextSeq_{0};  // 下一个写入归档的序号
+    std::map<uint64_t, EntryPtr>            opened_;      // 已打开、等待按序写入的文件
+    EntryPtr                                current_;     // 压缩模式下正在逐段读取的大文件
+    uint64_t                                bodyPos_{0};  // current_ 已写入的字节数
+    std::shared_ptr<FileSender>             body_;        // 正在直接发送的大文件
+    std::string                             raw_;         // 须原样发出的字节（响应头、块结尾）
+    std::string                             pending_;     // 尚未成块的归档数据
+    uint64_t                                files_{0};
+    bool                                    reading_{false};
+    bool                                    paused_{false};
+    bool                                    finished_{false};
+    bool                                    starting_{false};  // start() 尚未返回
+    Done                                    done_;
+};
+
+}  // namespace Http
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <system_error>
+
+#include "http/UploadFile.hpp"
+
+namespace Http {
+
+// 内容寻址的去重存储：每份内容在 dir 中只保存一次，文件名为 "<XXH64 十六进制>-<大小>"，
+// storageDir 中的同名文件是指向它的硬链接。inode 的链接数即引用计数，目录本身就是名字 → 内容
+// 的索引：下载、映射缓存、ETag 扩展属性都沿用原路径，不需要额外的查找。
+// 上传边写边算的哈希命中已有内容且逐字节比对一致时（XXH64 不抗碰撞），临时文件不经 fdatasync
+// 直接删除，目标名链接到已有内容，重复的字节通常在写回之前就随页缓存丢弃。
+// 共享同一内容的名字也共享 mtime。服务器只以 rename 替换文件，从不原地修改，因此共享是安全的；
+// 在目录外原地改写其中一个名字会同时改变其他名字。
+// 引用计数降到 1（只剩 dir 中的条目）的内容在删除/覆盖时回收，启动时也会清扫一遍。
+// 除构造函数外的方法都做阻塞 I/O，在磁盘线程池中执行，可以并发调用：
+// 并发的竞争最多让一份内容失去去重（各自保存一份），不会丢失或混淆数据。
+class BlobStore {
+  public:
+    struct Stats {
+        uint64_t hits{0};        // 命中已有内容的提交
+        uint64_t bytesSaved{0};  // 命中的提交不必再保存的字节数
+        uint64_t created{0};     // 新加入的内容
+        uint64_t collected{0};   // 不再被引用而删除的内容
+    };
+
+    // 阻塞：创建 dir，删除已不被任何名字引用的内容与异常退出遗留的临时链接
+    explicit BlobStore(std::filesystem::path dir);
+
+    BlobStore(const BlobStore&)            = delete;
+    BlobStore& operator=(const BlobStore&) = delete;
+
+    // 代替 UploadFile::commit：内容已存在时把 target 链接过去并丢弃临时文件，
+    // 否则正常提交后把 target 加入存储。target 原先引用的内容失去最后一个名字时被回收
+    bool commit(UploadFile&                  file,
+                const std::filesystem::path& target,
+                Durability                   durability,
+                std::error_code&             ec);
+    // 把已经就位的 target（如续传会话提交的文件）并入存储，需要扩展属性中有效的内容哈希
+    void adopt(const std::filesystem::path& target, Durability durability);
+    // target 当前引用的内容；不是存储中内容的链接时返回空路径
+    [[nodiscard]] std::filesystem::path referenced(const std::filesystem::path& target) const;
+    // blob 只剩存储中的条目时删除；blob 为空时什么都不做
+    void collect(const std::filesystem::path& blob);
+
+    [[nodiscard]] Stats stats() const;
+
+  private:
+    [[nodiscard]] std::filesystem::path blobPath(uint64_t hash, uint64_t size) const;
+    // 原子地把 target 替换为 blob 的又一个链接
+    bool linkInto(const std::filesystem::path& blob,
+                  const std::filesystem::path& target,
+                  Durability                   durability);
+    void sweep();
+
+    std::filesystem::path dir_;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> bytesSaved_{0};
+    std::atomic<uint64_t> created_{0};
+    std::atomic<uint64_t> collected_{0};
+    std::atomic<uint64_t> linkSeq_{0};  // 临时链接名的序号
+};
+
+}  // namespace Http
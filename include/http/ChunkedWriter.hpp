@@ -0,0 +1,44 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "TcpConnection.hpp"
+#include "http/Compression.hpp"
+#include "http/HttpResponse.hpp"
+
+namespace Http {
+
+// 以 chunked 编码流式输出响应体：响应头与首批数据一起发送，之后每攒够 kFlushThreshold
+// 字节就作为一个块交给连接发送，生成端无需提前算出 Content-Length。
+// coding 不为 IDENTITY 时数据先经流式压缩再分块，响应头补上 Content-Encoding 与 Vary。
+// 析构时若尚未 finish() 会自动补发结束块。
+class ChunkedWriter {
+  public:
+    static constexpr size_t kFlushThreshold = 16 * 1024;
+
+    ChunkedWriter(Server::TcpConnection::TcpConnectionPtr conn,
+                  HttpResponse                            head,
+                  bool                                    keepAlive,
+                  ContentCoding                           coding = ContentCoding::IDENTITY,
+                  int                                     level  = 0);
+    ~ChunkedWriter();
+
+    ChunkedWriter(const ChunkedWriter&)            = delete;
+    ChunkedWriter& operator=(const ChunkedWriter&) = delete;
+
+    void write(std::string_view data);
+    void finish();
+
+  private:
+    void flush(bool last);
+
+    Server::TcpConnection::TcpConnectionPtr conn_;
+    std::string                             head_;     // 尚未发送的响应头
+    std::string                             pending_;  // 尚未编码发送的数据（已压缩）
+    std::unique_ptr<Deflater>               deflater_;
+    bool                                    finished_{false};
+};
+
+}  // namespace Http
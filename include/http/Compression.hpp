@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+struct z_stream_s;
+
+namespace Http {
+
+enum class ContentCoding : uint8_t {
+    IDENTITY,
+    GZIP,
+    DEFLATE,  // RFC 9110 的 deflate 即 zlib 格式，而非裸 deflate 流
+};
+
+struct CompressionOptions {
+    int    level{6};        // zlib 压缩级别 1–9，0 表示关闭动态压缩（.gz 旁路文件仍会使用）
+    size_t minBytes{1024};  // 小于该值的响应体压缩收益不抵头部与 CPU 开销
+};
+
+// 按 Accept-Encoding 选择编码：只考虑 gzip 与 deflate（含 "*"），q 值相同时优先 gzip；
+// 头部缺失或两者都不可接受时返回 IDENTITY
+ContentCoding negotiateCoding(std::string_view acceptEncoding);
+
+// Content-Encoding 中的名字；IDENTITY 返回空
+std::string_view codingName(ContentCoding coding);
+
+// 文本类（text/*、JSON、JavaScript、XML、SVG）值得压缩；图片、压缩包等已压缩的格式不值得
+bool isCompressible(std::string_view contentType);
+
+// 流式压缩：输出随输入逐段产生，适合 chunked 响应
+class Deflater {
+  public:
+    // coding 须为 GZIP 或 DEFLATE
+    Deflater(ContentCoding coding, int level);
+    ~Deflater();
+
+    Deflater(const Deflater&)            = delete;
+    Deflater& operator=(const Deflater&) = delete;
+
+    // 压缩 data，把已产生的输出追加到 out；zlib 出错时返回 false
+    bool update(std::string_view data, std::string& out);
+    // 输出剩余数据与结尾（gzip 尾部的 CRC32 与长度），之后不可再调用 update
+    bool finish(std::string& out);
+
+  private:
+    bool run(std::string_view data, int flush, std::string& out);
+
+    std::unique_ptr<z_stream_s> stream_;
+    bool                        ok_{false};
+};
+
+// 一次性压缩 in 并追加到 out
+bool compress(std::string_view in, ContentCoding coding, int level, std::string& out);
+
+}  // namespace Http
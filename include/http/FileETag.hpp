@@ -0,0 +1,26 @@
+#pragma once
+
+#include <sys/stat.h>
+
+#include <cstdint>
+#include <string>
+
+namespace Http {
+
+// 强 ETag：带引号的 16 位十六进制内容哈希（XXH64）
+std::string formatETag(uint64_t hash);
+
+// 上传完成、关闭文件前调用：把内容哈希连同当前大小与 mtime 写入扩展属性
+// user.fileserver.etag，rename 后随文件保留，重启后无需重新计算
+bool storeFileHash(int fd, uint64_t hash);
+
+// 只读扩展属性：其中的哈希与文件当前的大小、mtime 相符时写入 hash 并返回 true，不计算
+bool readFileHash(int fd, const struct stat& st, uint64_t& hash);
+
+// 读取文件的强 ETag。扩展属性缺失（文件由外部放入）或与当前大小/mtime 不符（被外部修改）时
+// 重新读取整个文件计算并尝试写回；文件系统不支持扩展属性时结果缓存在本线程内存中
+std::string fileETag(int fd, const struct stat& st);
+// 同 fileETag，得到哈希本身；读取文件失败时返回 false
+bool fileHash(int fd, const struct stat& st, uint64_t& hash);
+
+}  // namespace Http
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Channel.hpp"
+#include "EventLoop.hpp"
+
+namespace Http {
+
+// 存储目录的内存索引：按文件名排序，保存大小与 mtime。watch() 时扫描一次目录，之后由上传/删除
+// 直接更新，目录外部的改动经 inotify 同步（队列溢出时整体重扫）。
+// 条目按名字顺序分块存放，每块缓存拼好的 JSON，修改只让所在块的缓存失效；
+// 列表请求按块拼接输出，不再遍历目录或逐条格式化。只在所属 EventLoop 的线程中使用。
+class FileIndex {
+  public:
+    struct Query {
+        std::string_view prefix;                                // 只列出以此开头的文件名
+        std::string_view cursor;                                // 从该文件名之后开始；空表示从头
+        size_t           limit{std::numeric_limits<size_t>::max()};
+    };
+    struct Entry {
+        std::string name;
+        uint64_t    size{0};
+        std::time_t mtime{0};
+    };
+
+    // sink 依次收到输出片段，拼接起来是逗号分隔的 JSON 对象序列（不含外层方括号）
+    using Sink = std::function<void(std::string_view)>;
+    // 文件被更新或移除（包括目录外部的改动）时以文件名调用；整体重扫时以空名调用
+    using ChangeCallback = std::function<void(const std::string& name)>;
+
+    FileIndex(Server::EventLoop* loop, std::filesystem::path dir);
+    ~FileIndex();
+
+    FileIndex(const FileIndex&)            = delete;
+    FileIndex& operator=(const FileIndex&) = delete;
+
+    void setChangeCallback(ChangeCallback cb) {
+        changeCallback_ = std::move(cb);
+    }
+
+    // 监视目录并扫描一遍。不调用时（内存存储、分片布局）索引只由 load/update/erase 维护
+    void watch();
+    // 以 entries 替换全部条目（如持久化的元数据索引中的），不访问磁盘
+    void load(std::vector<Entry> entries);
+
+    // 按磁盘现状更新单个文件：是普通文件则插入或更新，否则移除
+    void refresh(const std::string& name);
+    // 调用方已知新的元数据（如存储后端提交后返回的），不访问磁盘
+    void update(const std::string& name, uint64_t size, std::time_t mtime);
+    void erase(const std::string& name);
+    // 丢弃全部条目重新扫描目录
+    void rescan();
+
+    // 按名字顺序输出匹配的条目，返回输出的条数；因 limit 截断且后面还有匹配条目时，
+    // nextCursor 为本页最后一个文件名，否则为空
+    size_t list(const Query& query, const Sink& sink, std::string& nextCursor);
+    // 同 list，但只把匹配的文件名追加到 out（如按前缀分批打包下载）
+    size_t names(const Query& query, std::vector<std::string>& out, std::string& nextCursor) const;
+
+    [[nodiscard]] size_t size() const {
+        return count_;
+    }
+    // 当前版本的弱 ETag：进程内每次修改都会改变，跨重启也不会与旧值重复
+    [[nodiscard]] std::string etag() const;
+
+  private:
+    struct Item {
+        std::string name;
+        uint64_t    size{0};
+        std::time_t mtime{0};
+        std::string json;  // {"name":...,"size":...,"mtime":...}
+    };
+    struct Block {
+        std::vector<Item> items;  // 非空，按名字升序；块之间也整体有序
+        std::string       json;   // 各条目 json 以逗号拼接，dirty 时重建
+        bool              dirty{true};
+    };
+
+    static Item   makeItem(std::string name, uint64_t size, std::time_t mtime);
+    // 块中第一个不小于 start（after 时为大于 start）的条目的下标
+    static size_t seek(const Block& block, std::string_view start, bool after);
+
+    void   upsert(Item item);
+    // 第一个末尾条目不小于 name 的块；都小于时为最后一块
+    size_t findBlock(std::string_view name) const;
+    void   handleInotify();
+
+    Server::EventLoop*               loop_;
+    std::filesystem::path            dir_;
+    std::vector<Block>               blocks_;
+    size_t                           count_{0};
+    uint64_t                         generation_{0};
+    uint64_t                         epoch_;  // 启动时刻，区分不同进程的 generation_
+    int                              inotifyFd_{-1};
+    std::unique_ptr<Server::Channel> inotifyChannel_;
+    ChangeCallback                   changeCallback_;
+};
+
+}  // namespace Http
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "StorageEngine.hpp"
+#include "TcpConnection.hpp"
+#include "http/MappedFileCache.hpp"
+
+namespace Http {
+
+// 把文件的一个区间作为响应体发送到连接，内存占用与文件大小无关。
+// 连接发送缓冲为空且 io_uring 可用时，用链接的 read→send 让数据在内核中直接送到套接字；
+// 否则保持 kWindow 个读请求在途，读完的块按顺序交给 TcpConnection::send。
+// 来源为 MappedFileCache 的映射时不再读文件，每次从映射中取 kHighWater 字节直接 writev。
+// 发送缓冲积压超过 kHighWater 时暂停读取，由 onWriteComplete() 恢复。
+// 正文也可以由多个区间组成（multipart/byteranges）：各区间之前发出自己的分段头，最后发出 trailer。
+class FileSender : public std::enable_shared_from_this<FileSender> {
+  public:
+    static constexpr size_t kWindow    = 4;  // 在途读请求数（每个 StorageEngine::kChunkSize）
+    static constexpr size_t kHighWater = 1024 * 1024;
+
+    // ok 为 false 表示读文件或写套接字失败，响应已不完整，调用方应关闭连接
+    using Done = std::function<void(bool ok)>;
+
+    // 正文中的一段：先发出 head，再发送文件的 [offset, offset + length)，length 不为 0
+    struct Part {
+        std::string head;
+        uint64_t    offset{0};
+        uint64_t    length{0};
+    };
+
+    // 接管 fd，在最后一个在途请求结束后关闭
+    FileSender(Server::StorageEngine&                  engine,
+               Server::TcpConnection::TcpConnectionPtr conn,
+               int                                     fd,
+               uint64_t                                offset,
+               uint64_t                                length);
+    // 从映射发送；持有映射的引用直到发送结束
+    FileSender(Server::StorageEngine&                  engine,
+               Server::TcpConnection::TcpConnectionPtr conn,
+               MappedFileCache::MappingPtr             mapping,
+               uint64_t                                offset,
+               uint64_t                                length);
+    // 依次发送 parts，之后发出 trailer；parts 不能为空
+    FileSender(Server::StorageEngine&                  engine,
+               Server::TcpConnection::TcpConnectionPtr conn,
+               int                                     fd,
+               std::vector<Part>                       parts,
+               std::string                             trailer);
+    FileSender(Server::StorageEngine&                  engine,
+               Server::TcpConnection::TcpConnectionPtr conn,
+               MappedFileCache::MappingPtr             mapping,
+               std::vector<Part>                       parts,
+               std::string                             trailer);
+    ~FileSender();
+
+    FileSender(const FileSender&)            = delete;
+    FileSender& operator=(const FileSender&) = delete;
+
+    // prefix（通常是响应头）先于正文发出；done 总在 start() 返回之后调用
+    void start(std::string prefix, Done done);
+    // 连接发送缓冲清空时调用
+    void onWriteComplete();
+
+  private:
+    void pump();
+    void pumpMapped();
+    // 当前区间已发完：转到下一个区间并发出它的分段头，没有时发出 trailer 并返回 false
+    bool nextPart();
+    void onRead(uint64_t offset, int err, std::string data);
+    void onChain(int err, uint64_t sent, const std::string& rest);
+    void finish(bool ok);
+
+    Server::StorageEngine&                  engine_;
+    Server::TcpConnection::TcpConnectionPtr conn_;
+    int                                     fd_{-1};
+    MappedFileCache::MappingPtr             mapping_;
+    std::string                             prefix_;  // 尚未发出的前缀，映射模式下与正文一起写
+    std::vector<Part>                       parts_;
+    size_t                                  part_{0};  // 正在发送的区间
+    std::string                             trailer_;
+    uint64_t                                next_{0};     // 下一个要读取的文件偏移
+    uint64_t                                sendPos_{0};  // 下一个要交给连接的文件偏移
+    uint64_t                                end_{0};      // 当前区间的结尾
+    std::map<uint64_t, std::string>         ready_;     // 已读完、等待按序发送的块
+    size_t                                  inFlight_{0};
+    bool                                    chaining_{false};  // 链接的 read→send 在途
+    bool                                    paused_{false};
+    bool                                    finished_{false};
+    bool                                    starting_{false};  // start() 尚未返回
+    Done                                    done_;
+};
+
+}  // namespace Http
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace Http {
+
+// 流式 XXH64：数据分多次 update() 与一次性计算结果相同。
+// 用于 ETag 等内容指纹，非加密哈希，不可用于防篡改。
+class Hash64 {
+  public:
+    explicit Hash64(uint64_t seed = 0);
+
+    void                   update(std::string_view data);
+    [[nodiscard]] uint64_t digest() const;
+
+    static uint64_t of(std::string_view data, uint64_t seed = 0) {
+        Hash64 hasher(seed);
+        hasher.update(data);
+        return hasher.digest();
+    }
+
+  private:
+    static constexpr size_t kStripe = 32;
+
+    uint64_t      seed_;
+    uint64_t      acc_[4];
+    uint64_t      total_{0};
+    unsigned char buffer_[kStripe];  // 不足一个 32 字节条带的尾部数据
+    size_t        buffered_{0};
+};
+
+}  // namespace Http
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace Http {
+
+// 常用头部的编号。请求解析与响应生成都按编号查找，避免逐个比较字符串；
+// 新增条目时需同步 kHeaderNames，编译期会检查哈希是否冲突。
+enum class HeaderId : uint8_t {
+    ACCEPT,
+    ACCEPT_ENCODING,
+    ACCEPT_LANGUAGE,
+    ACCEPT_RANGES,
+    AUTHORIZATION,
+    CACHE_CONTROL,
+    CONNECTION,
+    CONTENT_DISPOSITION,
+    CONTENT_ENCODING,
+    CONTENT_LENGTH,
+    CONTENT_RANGE,
+    CONTENT_TYPE,
+    COOKIE,
+    DATE,
+    ETAG,
+    EXPECT,
+    HOST,
+    IF_MATCH,
+    IF_MODIFIED_SINCE,
+    IF_NONE_MATCH,
+    IF_RANGE,
+    IF_UNMODIFIED_SINCE,
+    LAST_MODIFIED,
+    LOCATION,
+    RANGE,
+    REFERER,
+    SERVER,
+    TRANSFER_ENCODING,
+    UPGRADE,
+    USER_AGENT,
+    VARY,
+    X_FILENAME,
+    UNKNOWN,
+};
+
+constexpr size_t kKnownHeaderCount = static_cast<size_t>(HeaderId::UNKNOWN);
+
+namespace detail {
+
+// 规范大小写的头部名，下标即 HeaderId
+constexpr std::array<std::string_view, kKnownHeaderCount> kHeaderNames{
+    "Accept",
+    "Accept-Encoding",
+    "Accept-Language",
+    "Accept-Ranges",
+    "Authorization",
+    "Cache-Control",
+    "Connection",
+    "Content-Disposition",
+    "Content-Encoding",
+    "Content-Length",
+    "Content-Range",
+    "Content-Type",
+    "Cookie",
+    "Date",
+    "ETag",
+    "Expect",
+    "Host",
+    "If-Match",
+    "If-Modified-Since",
+    "If-None-Match",
+    "If-Range",
+    "If-Unmodified-Since",
+    "Last-Modified",
+    "Location",
+    "Range",
+    "Referer",
+    "Server",
+    "Transfer-Encoding",
+    "Upgrade",
+    "User-Agent",
+    "Vary",
+    "X-Filename",
+};
+
+constexpr size_t  kHeaderTableSize = 128;
+constexpr uint8_t kEmptySlot       = 0xFF;
+
+constexpr char toLower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c | 0x20) : c;
+}
+
+// 只看长度、首字符与末两个字符（不区分大小写），对上表中的名字无冲突（完美哈希）
+constexpr size_t headerHash(std::string_view name) {
+    const size_t n = name.size();
+    return (n * 3 + static_cast<unsigned char>(toLower(name[0])) * 40 +
+            static_cast<unsigned char>(toLower(name[n - 1])) +
+            static_cast<unsigned char>(toLower(name[n - 2]))) &
+           (kHeaderTableSize - 1);
+}
+
+constexpr bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (toLower(a[i]) != toLower(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+constexpr std::array<uint8_t, kHeaderTableSize> buildHeaderTable() {
+    std::array<uint8_t, kHeaderTableSize> table{};
+    for (auto& slot : table) {
+        slot = kEmptySlot;
+    }
+    for (size_t i = 0; i < kKnownHeaderCount; ++i) {
+        table[headerHash(kHeaderNames[i])] = static_cast<uint8_t>(i);
+    }
+    return table;
+}
+
+constexpr std::array<uint8_t, kHeaderTableSize> kHeaderTable = buildHeaderTable();
+
+constexpr bool headerTableIsPerfect() {
+    for (size_t i = 0; i < kKnownHeaderCount; ++i) {
+        if (kHeaderTable[headerHash(kHeaderNames[i])] != i) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(headerTableIsPerfect(), "header hash collides; adjust headerHash()");
+
+}  // namespace detail
+
+// 不区分大小写；不在表中的名字返回 UNKNOWN
+constexpr HeaderId headerId(std::string_view name) {
+    if (name.size() < 2) {
+        return HeaderId::UNKNOWN;
+    }
+    const uint8_t slot = detail::kHeaderTable[detail::headerHash(name)];
+    if (slot == detail::kEmptySlot || !detail::iequals(detail::kHeaderNames[slot], name)) {
+        return HeaderId::UNKNOWN;
+    }
+    return static_cast<HeaderId>(slot);
+}
+
+constexpr std::string_view headerName(HeaderId id) {
+    return id == HeaderId::UNKNOWN ? std::string_view{}
+                                   : detail::kHeaderNames[static_cast<size_t>(id)];
+}
+
+// 请求头的扁平存储：按到达顺序保存 (编号, 名字, 值) 视图，常用头部另有按编号的下标，
+// 查找为 O(1)；其余头部线性比较。clear() 保留容量，连接复用时不再分配。
+// 同名头部出现多次时，查找返回第一个。
+class HeaderList {
+  public:
+    struct Field {
+        HeaderId         id;
+        std::string_view name;  // 保持原始大小写
+        std::string_view value;
+    };
+
+    HeaderList() {
+        index_.fill(kAbsent);
+    }
+
+    void add(HeaderId id, std::string_view name, std::string_view value) {
+        if (id != HeaderId::UNKNOWN && index_[static_cast<size_t>(id)] == kAbsent &&
+            fields_.size() < kAbsent) {
+            index_[static_cast<size_t>(id)] = static_cast<uint16_t>(fields_.size());
+        }
+        fields_.push_back({id, name, value});
+    }
+    void add(std::string_view name, std::string_view value) {
+        add(headerId(name), name, value);
+    }
+    void clear() {
+        fields_.clear();
+        index_.fill(kAbsent);
+    }
+
+    [[nodiscard]] bool contains(HeaderId id) const {
+        return index_[static_cast<size_t>(id)] != kAbsent;
+    }
+    // 不存在时返回空视图
+    [[nodiscard]] std::string_view get(HeaderId id) const {
+        const uint16_t pos = index_[static_cast<size_t>(id)];
+        return pos == kAbsent ? std::string_view{} : fields_[pos].value;
+    }
+    [[nodiscard]] std::string_view get(std::string_view name) const {
+        const HeaderId id = headerId(name);
+        if (id != HeaderId::UNKNOWN) {
+            return get(id);
+        }
+        for (const auto& field : fields_) {
+            if (field.id == HeaderId::UNKNOWN && detail::iequals(field.name, name)) {
+                return field.value;
+            }
+        }
+        return {};
+    }
+
+    [[nodiscard]] size_t size() const {
+        return fields_.size();
+    }
+    [[nodiscard]] auto begin() const {
+        return fields_.begin();
+    }
+    [[nodiscard]] auto end() const {
+        return fields_.end();
+    }
+
+  private:
+    static constexpr uint16_t kAbsent = 0xFFFF;
+
+    std::vector<Field> fields_;
+    // 多出的一格对应 UNKNOWN，始终为 kAbsent，查找无需额外分支
+    std::array<uint16_t, kKnownHeaderCount + 1> index_;
+};
+
+}  // namespace Http
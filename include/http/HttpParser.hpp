@@ -1,41 +1,139 @@
 #pragma once
 
+#include <functional>
+#include <limits>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "HttpRequest.hpp"
 namespace Http {
 
+// 增量解析器：记录恢复偏移，已扫描过的字节不会重复扫描；
+// 每个请求只在下一次追加数据前压缩一次缓冲，请求字段以视图形式暴露。
+// 支持 Content-Length 与 Transfer-Encoding: chunked 两种 body。
+// 各项资源上限超出时返回 ERROR，并通过 errorStatus() 给出应答状态码（413/414/431/503）。
 class HttpParser {
   public:
+    struct Limits {
+        size_t maxRequestLine{8 * 1024};      // 请求行长度，超出 → 414
+        size_t maxHeaderBytes{32 * 1024};     // 头部区（或 trailer 区）总字节，超出 → 431
+        size_t maxHeaderCount{100};           // 头部字段个数，超出 → 431
+        size_t maxBufferedBody{1024 * 1024};  // 缓冲在内存中的 body（未设置 sink），超出 → 413
+        size_t maxStreamedBody{std::numeric_limits<size_t>::max()};  // 交给 sink 的 body → 413
+    };
+
     enum class FeedState {
         NEED_MORE,
+        HEADERS_COMPLETE,  // 头部解析完成且随后有 body：调用方可在此时设置 BodySink，再继续 feed
         COMPLETE,
         ERROR,
     };
+    // 流式接收 body（chunked 已解码）；返回 false 表示放弃该请求，feed 返回 ERROR。
+    // 设置了 sink 的请求，body 不在缓冲中保留，getRequest().body 为空。
+    using BodySink = std::function<bool(std::string_view)>;
+
+    HttpParser() = default;
+    ~HttpParser();
+    // 缓冲字节计入全局统计，禁止拷贝/移动以免重复计数
+    HttpParser(const HttpParser&)            = delete;
+    HttpParser& operator=(const HttpParser&) = delete;
+
     FeedState          feed(std::string_view data);
     const HttpRequest& getRequest() const;
     void               resetParser(bool keepBuffer = true);
     bool               isKeepAlive() const;
 
+    void setLimits(const Limits& limits) {
+        limits_ = limits;
+    }
+    // 最近一次 ERROR 对应的 HTTP 状态码（400/413/414/431/500/503）
+    [[nodiscard]] int errorStatus() const {
+        return errorStatus_;
+    }
+
+    // 全部解析器缓冲中的字节总数；预算为 0 表示不限制，超出后新数据被拒绝（503）
+    static size_t bufferedBytes();
+    static void   setBufferBudget(size_t bytes);
+    static size_t bufferBudget();
+
+    // 仅在 HEADERS_COMPLETE 之后、body 开始消费前设置；resetParser 时自动清除
+    void setBodySink(BodySink sink) {
+        bodySink_ = std::move(sink);
+    }
+    [[nodiscard]] bool isChunked() const {
+        return chunked_;
+    }
+    // 已接收（解码后）的 body 字节数
+    [[nodiscard]] size_t bodyReceived() const {
+        return body_received;
+    }
+
   private:
     enum class HttpParseState {
         REQUEST_LINE_PENDING,  // 等待解析请求行
         HEADER_PENDING,        // 等待解析请求头
         HEADER_COMPLETE,       // 请求头解析结束
         BODY_CONTENT_LENGTH,   // 解析body
+        BODY_CHUNK_SIZE,       // 等待 chunk-size 行
+        BODY_CHUNK_DATA,       // 读取 chunk 数据
+        BODY_CHUNK_DATA_END,   // chunk 数据后的 CRLF
+        BODY_TRAILERS,         // last-chunk 之后的 trailer 区
         REQUEST_COMPLETE,      // 解析结束
         PARSE_ERROR
     };
-    HttpParseState state_{HttpParseState::REQUEST_LINE_PENDING};
-    size_t         content_length{0};
-    size_t         body_received{0};
-    bool           keep_alive{false};
-    std::string    recv_buff_;
-    HttpRequest    request_;
-};
+    // 相对当前请求起点 base_ 的区间，缓冲压缩/扩容后依旧有效
+    struct Span {
+        size_t offset{0};
+        size_t length{0};
+    };
+    struct HeaderSpan {
+        HeaderId id;
+        Span     name;
+        Span     value;
+    };
+
+    // 从 scanPos_ 开始查找下一行的 CRLF，返回行尾（相对 base_），未找到返回 npos
+    size_t           findLineEnd();
+    std::string_view view(Span span) const;
+    std::string_view findHeader(HeaderId id) const;
+    // 找出决定 body 长度的头部；有歧义（请求走私）时返回 false
+    bool             framingHeaders(const HeaderSpan*& transfer, const HeaderSpan*& length) const;
+    void             bindRequest();  // 生成请求视图（头部完成/请求完成时）
+    void             eraseRange(size_t offset, size_t length);
+    size_t           available(size_t from) const;  // from 之后已缓冲的字节数
+    FeedState        complete(size_t requestEnd);
+    FeedState        fail(int status);
+    FeedState        parse();
+    FeedState        parseChunked();
+    size_t           bodyLimit() const;
+    void             updateAccounting();  // 同步缓冲大小到全局统计
 
-struct ConnectionContext {
-    HttpParser parser;
+    HttpParseState          state_{HttpParseState::REQUEST_LINE_PENDING};
+    size_t                  content_length{0};
+    size_t                  body_received{0};
+    bool                    keep_alive{false};
+    bool                    chunked_{false};
+    std::string             recv_buff_;
+    size_t                  base_{0};            // 当前请求在 recv_buff_ 中的起点
+    size_t                  lineStart_{0};       // 当前待解析行的起点（相对 base_）
+    size_t                  scanPos_{0};         // CRLF 查找的恢复位置（相对 base_）
+    size_t                  bodyStart_{0};       // body 起点（相对 base_）
+    size_t                  bodyLength_{0};      // 缓冲中保留的 body 长度（chunked 时已原地解码）
+    size_t                  chunkPos_{0};        // chunked 解析位置（相对 base_）
+    size_t                  chunkRemaining_{0};  // 当前 chunk 剩余数据
+    size_t                  requestEnd_{0};      // 请求结束位置（相对 base_）
+    size_t                  headerStart_{0};     // 头部区起点（相对 base_）
+    size_t                  trailerBytes_{0};    // 已消费的 trailer 字节
+    size_t                  accounted_{0};       // 已计入全局统计的缓冲字节
+    int                     errorStatus_{0};
+    Limits                  limits_;
+    Span                    method_;
+    Span                    path_;
+    Span                    version_;
+    std::vector<HeaderSpan> headerSpans_;
+    BodySink                bodySink_;
+    HttpRequest             request_;
 };
 
 }  // namespace Http
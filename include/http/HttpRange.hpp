@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace Http {
+
+// 闭区间 [first, last]，已按文件大小裁剪
+struct ByteRange {
+    uint64_t first{0};
+    uint64_t last{0};
+
+    [[nodiscard]] uint64_t length() const {
+        return last - first + 1;
+    }
+};
+
+enum class RangeResult {
+    NONE,           // 没有 Range 或语法无效：按 RFC 9110 忽略，返回完整内容
+    SATISFIABLE,    // ranges 中至少有一个区间
+    UNSATISFIABLE,  // 语法正确但没有区间落在文件内 → 416
+};
+
+// 单个请求接受的最多区间数，超出视为无效（限制分段头的数量）
+inline constexpr size_t kMaxRanges = 16;
+// multipart/byteranges 中每个分段头的大致字节数；间隔比它小的区间合并为一段
+inline constexpr uint64_t kRangePartOverhead = 96;
+
+// 解析 "bytes=0-99,200-,-50" 形式的 Range 头部。多个区间按起点排序并合并重叠与相邻的部分，
+// 合并后的总长不超过文件大小；若与完整内容相差无几则忽略 Range（返回 NONE）
+RangeResult parseRange(std::string_view header, uint64_t size, std::vector<ByteRange>& ranges);
+
+// 解析请求中的 "bytes first-last/total"（分片上传）；不接受 "*" 形式的长度或区间
+bool parseContentRange(std::string_view header, ByteRange& range, uint64_t& total);
+
+}  // namespace Http
@@ -1,16 +1,19 @@
 #pragma once
 
-#include <string>
-#include <unordered_map>
+#include <string_view>
+
+#include "http/HttpHeaders.hpp"
 
 namespace Http {
 
+// 所有字段都是指向 HttpParser 内部缓冲的视图（零拷贝），
+// 仅在下一次 feed()/resetParser() 之前有效；需要长期持有时由调用方自行拷贝。
 struct HttpRequest {
-    std::string                                  method;
-    std::string                                  path;
-    std::string                                  version;
-    std::unordered_map<std::string, std::string> headers;
-    std::string                                  body;
+    std::string_view method;
+    std::string_view path;
+    std::string_view version;
+    HeaderList       headers;  // 查找不区分大小写，常用头部按 HeaderId 直接定位
+    std::string_view body;
 };
 
 }  // namespace Http
@@ -1,27 +1,86 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <vector>
+
+#include "http/HttpHeaders.hpp"
 
 namespace Http {
 
 class HttpResponse {
   public:
-    static constexpr int kDefaultStatus = 200;
+    static constexpr int              kDefaultStatus = 200;
+    static constexpr std::string_view kLastChunk     = "0\r\n\r\n";
 
     HttpResponse() = default;
 
+    // 使用标准原因短语时输出预先拼好的状态行
+    void                      setStatus(int code);
     void                      setStatus(int code, std::string reason);
+    // 同名（不区分大小写）头部会被替换；头部按首次设置的顺序输出
     void                      setHeader(std::string key, std::string value);
+    void                      setHeader(HeaderId id, std::string value);
     void                      setBody(std::string body);
     void                      setContentType(std::string mime);
     [[nodiscard]] std::string serialize(bool keepAlive) const;
+    // 直接追加到调用方的输出缓冲（通常是连接的输出批次）；缓冲容量足够时不分配内存。
+    // 未显式设置时自动补上 Content-Length/Transfer-Encoding、Connection 与 Date。
+    // negotiable 表示响应本可以按 Accept-Encoding 压缩（只是这次没有），同样补上 Vary
+    void                      serializeTo(std::string& out,
+                                          bool         keepAlive,
+                                          bool         negotiable = false) const;
+    // 同 serializeTo，但以按 coding（如 "gzip"）编码后的 encodedBody 代替 body 输出，
+    // 并补上 Content-Encoding 与 Vary: Accept-Encoding
+    void serializeEncodedTo(std::string&     out,
+                            bool             keepAlive,
+                            std::string_view coding,
+                            std::string_view encodedBody) const;
+
+    [[nodiscard]] int status() const {
+        return statusCode_;
+    }
+    [[nodiscard]] const std::string& body() const {
+        return body_;
+    }
+    // 不存在时返回空视图
+    [[nodiscard]] std::string_view header(HeaderId id) const;
+
+    // chunked 响应：serialize 输出 Transfer-Encoding: chunked 头部（不含 Content-Length），
+    // 已设置的 body 作为第一个块，后续块与结束块由调用方（通常是 ChunkedWriter）追加
+    void setChunked(bool on = true) {
+        chunked_ = on;
+    }
+
+    // 追加 Connection 与 Date 头部；用于调用方自行拼好其余头部的场景（如静态资源缓存）
+    static void appendConnection(std::string& out, bool keepAlive);
+    static void appendDate(std::string& out);
+
+    // 以 chunked 编码追加一个数据块；空数据不输出（空块表示结束）
+    static void appendChunk(std::string& out, std::string_view data);
+    // 只追加块头（十六进制长度与 CRLF）：size 字节的内容由调用方随后发送，并以 CRLF 结束
+    static void appendChunkHeader(std::string& out, uint64_t size);
 
   private:
-    int                                          statusCode_{kDefaultStatus};
-    std::string                                  reasonPhrase_{"OK"};
-    std::unordered_map<std::string, std::string> headers_;
-    std::string                                  body_;
+    struct Field {
+        HeaderId    id;
+        std::string name;  // 仅 UNKNOWN 使用，常用头部输出规范名
+        std::string value;
+    };
+
+    [[nodiscard]] bool hasHeader(HeaderId id) const;
+    void               serializeWith(std::string&     out,
+                                     bool             keepAlive,
+                                     std::string_view body,
+                                     std::string_view coding,
+                                     bool             negotiable) const;
+
+    int                statusCode_{kDefaultStatus};
+    std::string        reasonPhrase_;  // 为空表示使用标准原因短语
+    std::vector<Field> headers_;
+    std::string        body_;
+    bool               chunked_{false};
 };
 
 }  // namespace Http
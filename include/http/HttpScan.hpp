@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace Http::scan {
+
+// HTTP 报文分词用的扫描内核。首次调用时按 CPUID 选择 AVX2 / SSE4.2 / 标量实现，
+// 所有实现的返回值严格一致（未找到统一返回 std::string_view::npos）。
+enum class Kernel {
+    SCALAR,
+    SSE42,
+    AVX2,
+};
+
+// 当前生效的内核
+Kernel      activeKernel();
+const char* kernelName(Kernel kernel);
+// 强制切换内核（基准/等价性校验用）；CPU 不支持时返回 false 且不切换
+bool setKernel(Kernel kernel);
+
+// 从 from 开始查找第一个 "\r\n"，返回 '\r' 的位置
+size_t findCrlf(std::string_view data, size_t from = 0);
+// 查找第一个等于 c 的字节
+size_t findChar(std::string_view data, char c);
+// 查找第一个不属于 RFC 9110 token (tchar) 的字节，用于校验方法名与头部名
+size_t findNonToken(std::string_view data);
+// 查找第一个控制字符（除 HTAB 外的 0x00-0x1f 以及 0x7f），用于校验头部值
+size_t findCtl(std::string_view data);
+
+}  // namespace Http::scan
@@ -1,17 +1,72 @@
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <vector>
 
+#include "DiskIoPool.hpp"
 #include "EventLoop.hpp"
 #include "InetAddress.hpp"
+#include "StorageEngine.hpp"
 #include "TcpServer.hpp"
+#include "http/ArchiveSender.hpp"
+#include "http/Compression.hpp"
+#include "http/FileIndex.hpp"
+#include "http/FileSender.hpp"
 #include "http/HttpParser.hpp"
 #include "http/HttpRequest.hpp"
+#include "http/HttpResponse.hpp"
+#include "http/LocalDiskBackend.hpp"
+#include "http/MappedFileCache.hpp"
+#include "http/MemoryBackend.hpp"
+#include "http/MultipartParser.hpp"
+#include "http/Router.hpp"
+#include "http/StaticFileCache.hpp"
+#include "http/UploadFile.hpp"
+#include "http/UploadSessions.hpp"
 namespace Http {
 
+// multipart/form-data 上传（POST /api/files）：每个文件部分边到边写入自己的临时文件
+struct FormUpload {
+    explicit FormUpload(std::string_view boundary) : parser(boundary) {}
+
+    // 记录第一个错误；之后的 body 被丢弃，请求结束时按 status 回复
+    void fail(int code, const char* message) {
+        if (status == 0) {
+            status = code;
+            reason = message;
+        }
+    }
+
+    MultipartParser         parser;
+    std::vector<UploadFile> files;             // 按出现顺序，最后一个可能仍在接收
+    bool                    receiving{false};  // 当前部分是文件，内容写入 files.back()
+    int                     status{0};
+    const char*             reason{""};
+};
+
+struct ConnectionContext {
+    HttpParser                     parser;
+    UploadFile                     upload;  // 正在流式接收的上传（POST /api/files 或续传分片）
+    UploadSessions::WriterPtr      chunk;   // 续传分片的目标（PUT /api/uploads/:id）
+    std::unique_ptr<FormUpload>    form;    // multipart/form-data 上传（POST /api/files）
+    std::string                    output;  // 本轮已生成、尚未发送的响应，按请求顺序排列
+    bool                           closing{false};  // 已决定关闭连接，不再处理后续数据
+    ContentCoding                  accept{ContentCoding::IDENTITY};  // 按 Accept-Encoding 协商
+    bool                           keepAlive{true};  // 当前请求是否保持连接（解析器可能已重置）
+    bool                           waiting{false};   // 等待磁盘线程池完成，后续请求暂不处理
+    std::string                    stashed;          // 等待期间收到的数据，完成后按序继续解析
+    const Server::TcpConnection*   owner{nullptr};   // 异步完成时据此识别复用同一 fd 的新连接
+    std::shared_ptr<FileSender>    sender;           // 正在发送的大文件下载
+    std::shared_ptr<ArchiveSender> archive;          // 正在发送的打包下载
+};
+
 class HttpServer {
   public:
     HttpServer(Server::EventLoop*         loop,
@@ -21,27 +76,195 @@ class HttpServer {
 
     void start();
 
+    // 静态资源缓存的总字节上限（默认 64 MiB），超出时按 LRU 淘汰
+    void setStaticCacheLimit(size_t bytes) {
+        staticCache_.setMaxBytes(bytes);
+    }
+
+    // 下载文件映射缓存的总字节上限（默认 256 MiB），超出时按 LRU 淘汰
+    void setMappedFileLimit(size_t bytes) {
+        mappedFiles_.setMaxBytes(bytes);
+    }
+
+    // 响应压缩：文本类响应体不小于 minBytes 且客户端接受 gzip/deflate 时按 level 压缩；
+    // level 为 0 时只使用静态资源的 .gz 旁路文件
+    void setCompression(const CompressionOptions& options) {
+        compression_ = options;
+        staticCache_.setCompression(options);
+    }
+
+    // 上传提交前的落盘保证（默认 Durability::DATA，即 rename 之前 fdatasync）
+    void setUploadDurability(Durability durability) {
+        uploadDurability_ = durability;
+    }
+
+    // 内容寻址去重（默认关闭）：相同内容只在 storageDir/.blobs 中保存一份，各名字是它的硬链接。
+    // 在 start() 之前调用，start() 时清扫不再被引用的内容
+    void setDeduplication(bool enabled) {
+        dedup_ = enabled;
+    }
+
+    // 分片布局（默认关闭）：新文件按文件名哈希放进 4096 个子目录，元数据保存在
+    // storageDir/.index 的持久化索引中，启动时读入索引而不扫描目录，也不再监视目录外部的改动。
+    // 已有的文件留在原处，首次启用时扫描一遍建立索引。在 start() 之前调用
+    void setShardedStorage(bool enabled) {
+        sharded_ = enabled;
+    }
+
+    // 内存热层（默认关闭）：下载过的不超过 maxObjectBytes 的文件保留在内存中，
+    // 之后在 loop 线程直接回复；总量超过 bytes 时按 LRU 淘汰。在 start() 之前调用
+    void setHotTier(size_t bytes, uint64_t maxObjectBytes = MemoryBackend::kDefaultMaxObjectBytes) {
+        hotTierBytes_          = bytes;
+        hotTierMaxObjectBytes_ = maxObjectBytes;
+    }
+
+    // 只在内存中保存文件（压测用，排除磁盘的影响）：不读取也不列出 storageDir 中已有的文件，
+    // 容量为 bytes，重启后内容丢失。优先于去重与热层，在 start() 之前调用
+    void setMemoryStorage(size_t bytes) {
+        memoryStorageBytes_ = bytes;
+    }
+
+    // 对之后建立的连接生效；全局缓冲预算见 HttpParser::setBufferBudget
+    void setParserLimits(const HttpParser::Limits& limits) {
+        parserLimits_ = limits;
+    }
+
+    // 注册自定义端点（在 start() 之前调用）；pattern 支持 ":name" 单段参数与末尾 "*name" 通配。
+    // 处理函数通过 sendResponse 回复
+    void route(std::string_view method, std::string_view pattern, Router::Handler handler) {
+        router_.add(method, pattern, std::move(handler));
+    }
+
+    // 响应追加到连接的输出批次，onMessage 在本轮解析结束后一次性发送；
+    // 客户端不保持连接时标记 closing，后续流水线请求不再处理。
+    // 未自带 Content-Encoding 的文本类 200 响应按协商结果压缩（见 setCompression）
+    void sendResponse(const Server::TcpServer::TcpConnectionPtr& conn, const HttpResponse& resp);
+
+    // 存储 I/O 默认走 io_uring（内核不支持时自动退回线程池）；false 时始终用线程池。
+    // 在 start() 之前调用
+    void setIoUring(bool enabled);
+
+    // 低延迟部署：对新连接设置 SO_BUSY_POLL / SO_PREFER_BUSY_POLL
+    void setBusyPoll(int usec, bool prefer = false) {
+        server_.setBusyPoll(usec, prefer);
+    }
+
   private:
     void onConnection(const Server::TcpServer::TcpConnectionPtr& conn);
     void onMessage(const Server::TcpServer::TcpConnectionPtr& conn, std::string& data);
+    // 解析并处理 data 及缓冲中的请求，直到数据耗尽、连接关闭或某个请求转入线程池
+    void processInput(const Server::TcpServer::TcpConnectionPtr& conn,
+                      ConnectionContext&                         ctx,
+                      std::string_view                           data);
+    // 把 work 交给磁盘线程池，完成后在 loop 线程调用 done 生成响应，再继续处理暂存的后续请求。
+    // work 不得引用请求对象（解析器随即重置），所需字段应事先复制；队列已满时直接回复 503
+    // 并返回 false
+    bool offload(const Server::TcpServer::TcpConnectionPtr& conn,
+                 std::function<void()>                      work,
+                 std::function<void(ConnectionContext&)>    done);
+    // 异步完成时取回连接的上下文；连接已关闭（fd 可能已被复用）时返回 nullptr
+    ConnectionContext* activeContext(const Server::TcpServer::TcpConnectionPtr& conn);
+    // 结束等待，继续处理等待期间暂存的数据与解析器中已缓冲的后续请求
+    void resume(const Server::TcpServer::TcpConnectionPtr& conn, ConnectionContext& ctx);
+    // 先发出 head（连同批次中排在前面的响应），再由 sender 发送正文；发完之前不处理后续请求
+    void streamFile(const Server::TcpServer::TcpConnectionPtr& conn,
+                    ConnectionContext&                         ctx,
+                    const HttpResponse&                        head,
+                    std::shared_ptr<FileSender>                sender);
+    // 响应头已在 ctx.output 中：连同它由 sender 发出正文
+    void startSender(const Server::TcpServer::TcpConnectionPtr& conn,
+                     ConnectionContext&                         ctx,
+                     std::shared_ptr<FileSender>                sender);
+    // 同 streamFile，正文是 archive 边生成边发送的归档
+    void streamArchive(const Server::TcpServer::TcpConnectionPtr& conn,
+                       ConnectionContext&                         ctx,
+                       const HttpResponse&                        head,
+                       std::shared_ptr<ArchiveSender>             archive);
 
+    // 请求头解析完成、body 尚未开始时调用：决定 body 的去向（流式落盘/丢弃/缓冲）
+    void onHeaders(const Server::TcpServer::TcpConnectionPtr& conn,
+                   ConnectionContext&                         ctx,
+                   const HttpRequest&                         req);
+    // PUT /api/uploads/:id 的请求头：校验 Content-Range，body 直接写到会话文件中的对应偏移
+    void openUploadChunk(const Server::TcpServer::TcpConnectionPtr& conn,
+                         ConnectionContext&                         ctx,
+                         const HttpRequest&                         req,
+                         std::string_view                           id);
+    // body 交给 ctx.upload 写盘；写盘跟不上网络时暂停读取
+    void streamBody(const Server::TcpServer::TcpConnectionPtr& conn, ConnectionContext& ctx);
+    // multipart/form-data 上传：body 交给 MultipartParser，各文件部分分别写入临时文件
+    void openFormUpload(const Server::TcpServer::TcpConnectionPtr& conn,
+                        ConnectionContext&                         ctx,
+                        std::string_view                           boundary);
+    void registerRoutes();
+    // 按 setDeduplication/setHotTier/setMemoryStorage 组装 backend_
+    void buildBackend();
+    void flushOutput(const Server::TcpServer::TcpConnectionPtr& conn, ConnectionContext& ctx);
     void handleRequest(const Server::TcpServer::TcpConnectionPtr& conn, const HttpRequest& req);
 
-    void handleGet(const Server::TcpServer::TcpConnectionPtr& conn, const HttpRequest& req);
-    void handlePost(const Server::TcpServer::TcpConnectionPtr& conn, const HttpRequest& req);
-    void handleDelete(const Server::TcpServer::TcpConnectionPtr& conn, const HttpRequest& req);
-
     void replyStaticFile(const Server::TcpServer::TcpConnectionPtr& conn,
-                         const std::filesystem::path&               relativePath);
-    void replyFileList(const Server::TcpServer::TcpConnectionPtr& conn);
-    void replyDownload(const Server::TcpServer::TcpConnectionPtr& conn, std::string_view fileName);
+                         const HttpRequest&                         req,
+                         std::string_view                           relativePath);
+    void sendStaticEntry(const Server::TcpServer::TcpConnectionPtr&    conn,
+                         ConnectionContext&                            ctx,
+                         std::shared_ptr<const StaticFileCache::Entry> entry,
+                         std::string_view                              ifNoneMatch,
+                         std::string_view                              ifModifiedSince);
+    void replyMetrics(const Server::TcpServer::TcpConnectionPtr& conn);
+    // 分页：?prefix=&cursor=&limit=，返回 {"files":[{name,size,mtime}...],"next_cursor":...}
+    void replyFileList(const Server::TcpServer::TcpConnectionPtr& conn, const HttpRequest& req);
+    // 支持 Range/If-Range：单区间 206、多区间 multipart/byteranges、不可满足 416
+    void replyDownload(const Server::TcpServer::TcpConnectionPtr& conn,
+                       const HttpRequest&                         req,
+                       std::string_view                           fileName);
+    // 打包下载：GET ?prefix= 打包前缀匹配的全部文件，POST 的 body 每行一个文件名；
+    // ?compress=gzip 时输出 .tar.gz
+    void replyArchive(const Server::TcpServer::TcpConnectionPtr& conn, const HttpRequest& req);
     void handleUpload(const Server::TcpServer::TcpConnectionPtr& conn, const HttpRequest& req);
+    // 表单中的全部文件落盘后逐个 rename 到位，回复 {"status":"ok","files":[...]}
+    void handleFormUpload(const Server::TcpServer::TcpConnectionPtr& conn);
     void handleRemove(const Server::TcpServer::TcpConnectionPtr& conn, std::string_view fileName);
+    // 可续传上传：建立会话（X-Filename、X-Upload-Length）、查询进度、上传分片、提交、放弃
+    void createUploadSession(const Server::TcpServer::TcpConnectionPtr& conn,
+                             const HttpRequest&                         req);
+    void replyUploadSession(const Server::TcpServer::TcpConnectionPtr& conn, std::string_view id);
+    void handleUploadChunk(const Server::TcpServer::TcpConnectionPtr& conn,
+                           const HttpRequest&                         req,
+                           std::string_view                           id);
+    void commitUploadSession(const Server::TcpServer::TcpConnectionPtr& conn, std::string_view id);
+    void removeUploadSession(const Server::TcpServer::TcpConnectionPtr& conn, std::string_view id);
 
+    Server::EventLoop*                         loop_{nullptr};
     Server::TcpServer                          server_;
+    Router                                     router_;
     std::unordered_map<int, ConnectionContext> contexts_;
     std::filesystem::path                      storageDir_;
     std::filesystem::path                      staticDir_;
+    StaticFileCache                            staticCache_;
+    MappedFileCache                            mappedFiles_;  // 下载文件的共享映射
+    FileIndex                                  fileIndex_;  // storageDir_ 的内容，/api/files 由此生成
+    std::filesystem::path                      tempDir_;  // 上传临时文件，与 storageDir_ 同一文件系统
+    UploadSessions                             uploadSessions_;  // 可续传上传，重启后保留
+    bool                                       dedup_{false};
+    bool                                       sharded_{false};
+    size_t                                     hotTierBytes_{0};
+    uint64_t                                   hotTierMaxObjectBytes_{0};
+    size_t                                     memoryStorageBytes_{0};
+    std::unique_ptr<StorageBackend>            backend_;  // 文件内容的读写，start() 时组装
+    const BlobStore*                           blobs_{nullptr};       // 属于 backend_，供指标使用
+    const MemoryBackend*                       memoryTier_{nullptr};  // 同上
+    HttpParser::Limits                         parserLimits_;
+    CompressionOptions                         compression_;
+    Durability                                 uploadDurability_{Durability::DATA};
+    std::map<int, uint64_t>                    rejections_;  // 解析失败次数（按应答状态码）
+    struct {
+        uint64_t requests{0};
+        uint64_t batches{0};  // 实际写出次数；requests / batches 即平均批量
+    } pipelineStats_;
+    // 最后声明：析构时先停止工作线程，排队中的任务不会再访问上面的成员
+    Server::DiskIoPool diskPool_;
+    // 依赖 diskPool_ 作为退路，须先于它析构
+    std::unique_ptr<Server::StorageEngine> storage_;
 };
 
 }  // namespace Http
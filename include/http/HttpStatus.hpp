@@ -1,12 +1,72 @@
 #pragma once
 
+#include <string_view>
+
 namespace Http {
 namespace StatusCode {
-inline constexpr int kOk                  = 200;
-inline constexpr int kCreated             = 201;
-inline constexpr int kBadRequest          = 400;
-inline constexpr int kNotFound            = 404;
-inline constexpr int kMethodNotAllowed    = 405;
-inline constexpr int kInternalServerError = 500;
+inline constexpr int kOk                          = 200;
+inline constexpr int kCreated                     = 201;
+inline constexpr int kPartialContent              = 206;
+inline constexpr int kNotModified                 = 304;
+inline constexpr int kBadRequest                  = 400;
+inline constexpr int kNotFound                    = 404;
+inline constexpr int kMethodNotAllowed            = 405;
+inline constexpr int kConflict                    = 409;
+inline constexpr int kPayloadTooLarge             = 413;
+inline constexpr int kUriTooLong                  = 414;
+inline constexpr int kRangeNotSatisfiable         = 416;
+inline constexpr int kRequestHeaderFieldsTooLarge = 431;
+inline constexpr int kInternalServerError         = 500;
+inline constexpr int kServiceUnavailable          = 503;
+inline constexpr int kHttpVersionNotSupported     = 505;
+inline constexpr int kInsufficientStorage         = 507;
 }  // namespace StatusCode
+
+namespace detail {
+struct StatusLine {
+    int              code;
+    std::string_view line;
+};
+// 预先拼好的状态行，序列化时整行追加，无需格式化状态码
+inline constexpr StatusLine kStatusLines[] = {
+    {StatusCode::kOk, "HTTP/1.1 200 OK\r\n"},
+    {StatusCode::kCreated, "HTTP/1.1 201 Created\r\n"},
+    {StatusCode::kPartialContent, "HTTP/1.1 206 Partial Content\r\n"},
+    {StatusCode::kNotModified, "HTTP/1.1 304 Not Modified\r\n"},
+    {StatusCode::kBadRequest, "HTTP/1.1 400 Bad Request\r\n"},
+    {StatusCode::kNotFound, "HTTP/1.1 404 Not Found\r\n"},
+    {StatusCode::kMethodNotAllowed, "HTTP/1.1 405 Method Not Allowed\r\n"},
+    {StatusCode::kConflict, "HTTP/1.1 409 Conflict\r\n"},
+    {StatusCode::kPayloadTooLarge, "HTTP/1.1 413 Payload Too Large\r\n"},
+    {StatusCode::kUriTooLong, "HTTP/1.1 414 URI Too Long\r\n"},
+    {StatusCode::kRangeNotSatisfiable, "HTTP/1.1 416 Range Not Satisfiable\r\n"},
+    {StatusCode::kRequestHeaderFieldsTooLarge, "HTTP/1.1 431 Request Header Fields Too Large\r\n"},
+    {StatusCode::kInternalServerError, "HTTP/1.1 500 Internal Server Error\r\n"},
+    {StatusCode::kServiceUnavailable, "HTTP/1.1 503 Service Unavailable\r\n"},
+    {StatusCode::kHttpVersionNotSupported, "HTTP/1.1 505 HTTP Version Not Supported\r\n"},
+    {StatusCode::kInsufficientStorage, "HTTP/1.1 507 Insufficient Storage\r\n"},
+};
+inline constexpr size_t kStatusLinePrefix = sizeof("HTTP/1.1 200 ") - 1;
+}  // namespace detail
+
+// 完整状态行（含 CRLF），未知状态码返回空
+constexpr std::string_view statusLine(int code) {
+    for (const auto& entry : detail::kStatusLines) {
+        if (entry.code == code) {
+            return entry.line;
+        }
+    }
+    return {};
+}
+
+// 标准原因短语，未知状态码返回空
+constexpr std::string_view reasonPhrase(int code) {
+    const std::string_view line = statusLine(code);
+    if (line.empty()) {
+        return line;
+    }
+    return line.substr(detail::kStatusLinePrefix, line.size() - detail::kStatusLinePrefix - 2);
+}
+
+static_assert(reasonPhrase(StatusCode::kNotFound) == "Not Found");
 }  // namespace Http
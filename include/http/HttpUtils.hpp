@@ -1,13 +1,36 @@
 #pragma once
 
+#include <ctime>
+#include <optional>
 #include <string>
 #include <string_view>
 
 namespace Http {
 
-std::string stripQuery(const std::string& path);
+std::string_view stripQuery(std::string_view path);
+// 取请求目标中查询串参数的解码值；参数不存在时返回 std::nullopt
+std::optional<std::string> queryParam(std::string_view target, std::string_view name);
 std::string urlDecode(std::string_view input);
 std::string escapeJson(std::string_view input);
 std::string sanitizeFilename(std::string_view name);
+// 按扩展名（不区分大小写）推断 Content-Type，未知类型返回 application/octet-stream
+std::string_view mimeType(std::string_view path);
+
+// IMF-fixdate，如 "Sun, 06 Nov 1994 08:49:37 GMT"
+inline constexpr size_t kHttpDateLength = 29;
+void formatHttpDate(std::time_t t, char (&out)[kHttpDateLength]);
+// 当前时间的 IMF-fixdate；每个线程（即每个 EventLoop）缓存一份，每秒最多格式化一次
+std::string_view httpDate();
+// 解析 IMF-fixdate；格式不符时返回 false（过时的 RFC 850 / asctime 格式视为无效）
+bool parseHttpDate(std::string_view text, std::time_t& out);
+
+// If-None-Match 列表（或 "*"）是否与 etag 匹配，按弱比较忽略 W/ 前缀
+bool etagListMatches(std::string_view list, std::string_view etag);
+// 条件 GET：有 If-None-Match 时只看它，否则比较 If-Modified-Since 与 lastModified（秒级）。
+// 对应头部为空视图表示请求未携带
+bool notModified(std::string_view ifNoneMatch,
+                 std::string_view ifModifiedSince,
+                 std::string_view etag,
+                 std::time_t      lastModified);
 
 }  // namespace Http
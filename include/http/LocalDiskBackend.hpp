@@ -0,0 +1,58 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+
+#include "http/BlobStore.hpp"
+#include "http/MetadataIndex.hpp"
+#include "http/StorageBackend.hpp"
+
+namespace Http {
+
+// 对象即 root 目录中的同名文件。提交以 rename 原子替换，ETag 来自文件的扩展属性；
+// blobs 非空时上传经内容寻址去重（见 BlobStore）。
+// index 非空时为分片布局：新文件放进 index 指定的分片子目录，查找与删除只查内存中的索引，
+// 不在索引中的名字不访问磁盘；ETag 取自索引，文件大小或 mtime 与索引不符时才读扩展属性
+class LocalDiskBackend : public StorageBackend {
+  public:
+    explicit LocalDiskBackend(std::filesystem::path          root,
+                              std::unique_ptr<BlobStore>     blobs = nullptr,
+                              std::unique_ptr<MetadataIndex> index = nullptr);
+
+    bool open(const std::string& name, Object& object, std::error_code& ec) override;
+    bool commit(UploadFile&      file,
+                Durability       durability,
+                ObjectInfo&      info,
+                std::error_code& ec) override;
+    bool place(const std::filesystem::path& source,
+               const std::string&           name,
+               Durability                   durability,
+               ObjectInfo&                  info,
+               std::error_code&             ec) override;
+    bool remove(const std::string& name, std::error_code& ec) override;
+
+    // 未开启去重时为空
+    [[nodiscard]] const BlobStore* blobs() const {
+        return blobs_.get();
+    }
+    // 未使用分片布局时为空
+    [[nodiscard]] const MetadataIndex* index() const {
+        return index_.get();
+    }
+
+  private:
+    // 分片布局下新文件的路径，按需创建分片目录
+    std::filesystem::path shardedTarget(const std::string& name,
+                                        Durability         durability,
+                                        std::error_code&   ec) const;
+    // 提交成功后更新索引；覆盖的是根目录中的旧文件时删除它
+    void indexCommitted(const std::string& name, uint64_t digest, const ObjectInfo& info);
+    // 删除已不在索引中的旧文件，回收其引用的去重内容
+    void removeStale(const std::filesystem::path& path);
+
+    std::filesystem::path          root_;
+    std::unique_ptr<BlobStore>     blobs_;
+    std::unique_ptr<MetadataIndex> index_;
+};
+
+}  // namespace Http
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Http {
+
+// 下载文件的只读映射缓存：以存储目录中的文件名为键，多个下载共享同一个映射，
+// 命中时不再打开、stat 或读取文件，正文直接从映射 writev 到套接字。
+// 映射按引用计数管理：被淘汰或失效的映射在最后一个使用者结束后才 munmap。
+// Mapping 也用来表示内存中的对象（见 MemoryBackend），下载路径对两者一视同仁。
+// 缓存中的映射总字节数超过上限时按 LRU 淘汰。只在所属 EventLoop 的线程中使用（map() 除外）。
+class MappedFileCache {
+  public:
+    // 只映射这个区间内的文件：更小的文件直接读出更划算，更大的文件走 StorageEngine
+    static constexpr uint64_t kMinBytes = 64 * 1024;
+    static constexpr uint64_t kMaxBytes = 64 * 1024 * 1024;
+
+    struct Mapping {
+        const char*                 data{nullptr};
+        size_t                      size{0};
+        std::time_t                 mtime{0};
+        std::string                 etag;
+        std::string                 lastModified;  // HTTP-date
+        bool                        mapped{false};  // data 来自 mmap；否则指向 buffer 或 owner
+        std::string                 buffer;
+        std::shared_ptr<const void> owner;
+
+        Mapping() = default;
+        ~Mapping();
+        Mapping(const Mapping&)            = delete;
+        Mapping& operator=(const Mapping&) = delete;
+    };
+    using MappingPtr = std::shared_ptr<const Mapping>;
+
+    struct Stats {
+        uint64_t hits{0};
+        uint64_t misses{0};
+        uint64_t evictions{0};
+        uint64_t invalidations{0};
+        size_t   entries{0};
+        size_t   bytes{0};
+    };
+
+    explicit MappedFileCache(size_t maxBytes);
+
+    MappedFileCache(const MappedFileCache&)            = delete;
+    MappedFileCache& operator=(const MappedFileCache&) = delete;
+
+    // 该大小的文件是否值得映射（同时不超过总上限的 1/4，避免一个文件挤掉全部缓存）
+    [[nodiscard]] bool eligible(uint64_t size) const;
+    // 可在任意线程调用：映射 fd 的前 size 字节并提示内核顺序预读（MADV_SEQUENTIAL/WILLNEED）。
+    // fd 仍归调用方所有，映射建立后即可关闭。失败返回空
+    static MappingPtr map(int                fd,
+                          size_t             size,
+                          std::time_t        mtime,
+                          std::string        etag,
+                          const std::string& name);
+
+    // 可在任意线程调用：把内存中的内容包装成 Mapping，data 指向接管的 bytes
+    static MappingPtr fromBuffer(std::string bytes, std::time_t mtime, std::string etag);
+    // 不复制地借用 owner 持有的 bytes（如静态资源缓存项的内容），owner 随最后一个使用者释放
+    static MappingPtr borrow(std::shared_ptr<const void> owner, std::string_view bytes);
+
+    MappingPtr find(const std::string& name);
+    // 每次失效都会改变；store() 据此丢弃在失效之前开始映射的结果
+    [[nodiscard]] uint64_t generation() const {
+        return generation_;
+    }
+    // generation 为开始映射之前取得的 generation()
+    void store(const std::string& name, MappingPtr mapping, uint64_t generation);
+    // 文件被重新上传或删除；name 为空时清空全部
+    void invalidate(const std::string& name);
+
+    void setMaxBytes(size_t maxBytes);
+    [[nodiscard]] Stats stats() const;
+
+  private:
+    struct Slot {
+        MappingPtr                       mapping;
+        std::list<std::string>::iterator lru;
+    };
+
+    void erase(const std::string& name);
+    void evict();
+
+    size_t                                maxBytes_;
+    size_t                                bytes_{0};
+    uint64_t                              generation_{0};
+    std::unordered_map<std::string, Slot> entries_;
+    std::list<std::string>                lru_;  // 头部为最近使用
+    Stats                                 stats_;
+};
+
+}  // namespace Http
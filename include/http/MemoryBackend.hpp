@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "http/StorageBackend.hpp"
+
+namespace Http {
+
+// 把对象整个保存在内存中的存储后端，总字节数受 maxBytes 限制。两种用法：
+//   lower 为空：唯一的存储（压测时排除磁盘的影响）。容量用尽时拒绝提交（ENOSPC），从不淘汰，
+//     重启后内容丢失。上传的临时文件读回内存后即删除，通常来不及写回磁盘。
+//   lower 非空：lower 之前的热层。提交与删除直达 lower 并丢弃内存副本；下载未命中时从 lower
+//     读取，不超过 maxObjectBytes 的对象随之读进内存（提升），总量超过 maxBytes 时按 LRU 淘汰。
+// 内存中的对象以 MappedFileCache::Mapping 的形式共享给下载，淘汰后在最后一个使用者结束时释放。
+class MemoryBackend : public StorageBackend {
+  public:
+    // 更大的文件已由 MappedFileCache 映射，热层默认只收小文件
+    static constexpr uint64_t kDefaultMaxObjectBytes = MappedFileCache::kMinBytes;
+
+    struct Stats {
+        uint64_t hits{0};
+        uint64_t misses{0};
+        uint64_t promotions{0};  // 从 lower 读进内存的对象
+        uint64_t evictions{0};
+        uint64_t rejected{0};  // 容量不足而拒绝的提交（仅作为唯一存储时）
+        size_t   entries{0};
+        size_t   bytes{0};
+    };
+
+    explicit MemoryBackend(size_t                          maxBytes,
+                           std::unique_ptr<StorageBackend> lower          = nullptr,
+                           uint64_t                        maxObjectBytes = kDefaultMaxObjectBytes);
+
+    bool open(const std::string& name, Object& object, std::error_code& ec) override;
+    bool commit(UploadFile&      file,
+                Durability       durability,
+                ObjectInfo&      info,
+                std::error_code& ec) override;
+    bool place(const std::filesystem::path& source,
+               const std::string&           name,
+               Durability                   durability,
+               ObjectInfo&                  info,
+               std::error_code&             ec) override;
+    bool remove(const std::string& name, std::error_code& ec) override;
+
+    MappedFileCache::MappingPtr cached(const std::string& name) override;
+    void                        invalidate(const std::string& name) override;
+
+    // 作为热层时的下层后端，否则为空
+    [[nodiscard]] StorageBackend* lower() const {
+        return lower_.get();
+    }
+    [[nodiscard]] Stats stats() const;
+
+  private:
+    struct Slot {
+        MappedFileCache::MappingPtr      object;
+        std::list<std::string>::iterator lru;
+    };
+
+    // 作为唯一存储时保存 object；容量不足返回 false
+    bool store(const std::string& name, MappedFileCache::MappingPtr object, std::error_code& ec);
+    // 以下须持有 mutex_
+    void insertLocked(const std::string& name, MappedFileCache::MappingPtr object);
+    void eraseLocked(const std::string& name);
+    void evictLocked();
+
+    const size_t                          maxBytes_;
+    const uint64_t                        maxObjectBytes_;
+    std::unique_ptr<StorageBackend>       lower_;
+    mutable std::mutex                    mutex_;
+    std::unordered_map<std::string, Slot> entries_;
+    std::list<std::string>                lru_;  // 头部为最近使用
+    size_t                                bytes_{0};
+    uint64_t                              generation_{0};  // 每次失效都会改变，丢弃过期的提升
+    Stats                                 stats_;
+};
+
+}  // namespace Http
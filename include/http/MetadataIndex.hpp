@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+#include "http/UploadFile.hpp"
+
+namespace Http {
+
+// 分片布局的持久化元数据索引：文件名 → 大小、mtime、内容哈希与所在的分片目录。
+// 新文件按文件名哈希放进 4096 个子目录之一（"3fa/<名字>"），千万个文件时每个目录约 2500 条。
+// 索引以追加写的日志保存在 dir/files.log，启动时顺序读入内存，不遍历目录、不逐个 stat。
+// 日志在首行 "fsindex 1" 之后每行一条记录，名字按长度截取，可以包含任意字符：
+//   "? <名字长度> <名字>"                               即将修改该名字
+//   "+ <大小> <mtime> <哈希> <分片> <名字长度> <名字>"   修改后的元数据（分片 "." 表示根目录）
+//   "- <名字长度> <名字>"                               已删除
+// 修改前先追加 "?" 并按持久性要求落盘，完成后再追加结果（不单独落盘）。崩溃后没有结果的 "?"
+// 在启动时按磁盘现状逐个核对，其余条目不访问文件。失效记录占多数时把日志重写为快照。
+// 日志不存在（首次启用或被删除）时扫描根目录与分片目录重建，根目录中原有的文件留在原处。
+// 目录外部的改动不会同步进索引。除构造函数外的方法可以在多个线程中并发调用。
+class MetadataIndex {
+  public:
+    struct Entry {
+        uint64_t    size{0};
+        std::time_t mtime{0};
+        uint64_t    digest{0};  // 内容的 XXH64，即 ETag
+        std::string shard;      // 所在的分片目录，如 "3fa"；根目录中的文件为空
+    };
+
+    // 阻塞：加载 dir 中的日志，核对未完成的修改；日志不存在时扫描 root 重建
+    MetadataIndex(std::filesystem::path root, std::filesystem::path dir);
+    ~MetadataIndex();
+
+    MetadataIndex(const MetadataIndex&)            = delete;
+    MetadataIndex& operator=(const MetadataIndex&) = delete;
+
+    // 新文件所在的分片目录
+    static std::string shardOf(std::string_view name);
+
+    bool find(const std::string& name, Entry& entry) const;
+    // root/<entry.shard>/name
+    [[nodiscard]] std::filesystem::path pathOf(const std::string& name, const Entry& entry) const;
+
+    // 修改磁盘上的 name 之前调用；之后必须以 put、erase 或 cancel 之一结束
+    bool begin(const std::string& name, Durability durability, std::error_code& ec);
+    void put(const std::string& name, Entry entry);
+    void erase(const std::string& name);
+    // 修改失败，磁盘上没有变化
+    void cancel(const std::string& name);
+
+    [[nodiscard]] size_t size() const;
+    // 持锁遍历全部条目，只在启动时使用
+    void forEach(const std::function<void(const std::string&, const Entry&)>& fn) const;
+
+  private:
+    [[nodiscard]] std::filesystem::path logPath() const;
+    // 以下只在构造期间调用
+    // 日志不存在或头部损坏时返回 false；unresolved 收到崩溃时进行中的修改
+    bool load(std::vector<std::string>& unresolved);
+    void rebuild();
+    // 按磁盘现状重新得到 name 的元数据，文件不存在时从索引中移除
+    void verify(const std::string& name);
+    // 读取 root/shard/name 的元数据，不是普通文件时返回 false
+    bool probe(const std::string& name, const std::string& shard, Entry& entry) const;
+
+    // 以下须持有 logMutex_
+    void append(const std::string& record);
+    void finishLocked(const std::string& name);
+    // 失效记录过多时把日志重写为快照
+    void maybeCompactLocked();
+    bool writeSnapshotLocked();
+
+    std::filesystem::path root_;
+    std::filesystem::path dir_;
+
+    // 锁顺序：logMutex_ 在 mutex_ 之前。查找只取 mutex_，不会被日志的 fdatasync 阻塞
+    std::mutex                             logMutex_;
+    int                                    logFd_{-1};
+    uint64_t                               records_{0};  // 日志中 "+"、"-" 记录的条数
+    std::unordered_map<std::string, int>   pending_;     // 进行中的修改，快照中保留它们的 "?"
+    mutable std::mutex                     mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+};
+
+}  // namespace Http
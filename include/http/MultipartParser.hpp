@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace Http {
+
+// 流式 multipart/form-data 解析器（RFC 7578）：body 分成任意大小的片段依次 feed，
+// 每个部分的头部解析完后回调 onPartBegin，内容边到边交给 onPartData，不在内存中攒整个部分。
+// 分隔符 "\r\n--boundary" 用 Boyer-Moore-Horspool 查找；片段末尾可能是半个分隔符的
+// 字节（最多分隔符长度 - 1）暂留到下一次 feed，其余内容立即交出。
+class MultipartParser {
+  public:
+    // 单个部分的头部总长上限
+    static constexpr size_t kMaxHeaderBytes = 8 * 1024;
+
+    struct Part {
+        std::string name;         // Content-Disposition 的 name
+        std::string filename;     // 为空表示普通表单字段（或未选择文件）
+        std::string contentType;  // 缺省为空
+    };
+
+    // 回调返回 false 时解析中止，feed 返回 false
+    using PartBeginCallback = std::function<bool(const Part& part)>;
+    using PartDataCallback  = std::function<bool(std::string_view data)>;
+    using PartEndCallback   = std::function<bool()>;
+
+    // 取 Content-Type 中的 boundary；不是 multipart/form-data 或 boundary 无效时返回空
+    static std::string boundaryOf(std::string_view contentType);
+
+    explicit MultipartParser(std::string_view boundary);
+
+    void setPartBeginCallback(PartBeginCallback cb) {
+        onPartBegin_ = std::move(cb);
+    }
+    void setPartDataCallback(PartDataCallback cb) {
+        onPartData_ = std::move(cb);
+    }
+    void setPartEndCallback(PartEndCallback cb) {
+        onPartEnd_ = std::move(cb);
+    }
+
+    // 格式错误或回调要求中止时返回 false，之后的 feed 都返回 false
+    bool feed(std::string_view data);
+    // 已读到结束分隔符 "--boundary--"（其后的尾声被忽略）
+    [[nodiscard]] bool finished() const {
+        return state_ == State::DONE;
+    }
+
+  private:
+    enum class State { PREAMBLE, AFTER_DELIMITER, HEADERS, BODY, DONE, FAILED };
+
+    // 处理 data，返回已消费的字节数；未消费的部分由 feed 暂存
+    size_t process(std::string_view data);
+    bool   parseHeaderLine(std::string_view line);
+    // 在 data 中查找分隔符，找不到时返回 npos
+    [[nodiscard]] size_t findDelimiter(std::string_view data) const;
+    // data 中可能是分隔符开头的尾部的起点（找不到分隔符时，此前的内容可以安全交出）
+    [[nodiscard]] size_t partialDelimiter(std::string_view data) const;
+
+    std::string       delimiter_;  // "\r\n--" + boundary
+    std::string       pending_;    // 上次 feed 未能消费的尾部
+    State             state_{State::PREAMBLE};
+    Part              part_;
+    size_t            headerBytes_{0};
+    size_t            skip_[256];  // Horspool 坏字符表
+    PartBeginCallback onPartBegin_;
+    PartDataCallback  onPartData_;
+    PartEndCallback   onPartEnd_;
+};
+
+}  // namespace Http
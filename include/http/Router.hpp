@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "TcpServer.hpp"
+#include "http/HttpRequest.hpp"
+
+namespace Http {
+
+// 路由匹配出的路径参数；名字与值均为视图（分别指向路由表与请求缓冲），匹配过程不分配内存
+class RouteParams {
+  public:
+    static constexpr size_t kMaxParams = 4;
+
+    // 不存在时返回空视图
+    [[nodiscard]] std::string_view get(std::string_view name) const;
+    [[nodiscard]] size_t           size() const {
+        return count_;
+    }
+
+  private:
+    friend class Router;
+
+    std::array<std::pair<std::string_view, std::string_view>, kMaxParams> items_{};
+    size_t                                                                count_{0};
+};
+
+// 压缩前缀树（radix tree）路由：静态前缀共享节点，":name" 匹配一个路径段，
+// 末尾的 "*name" 匹配剩余全部路径（至少一个字符）。静态节点优先于参数节点。
+class Router {
+  public:
+    using Handler = std::function<void(const Server::TcpServer::TcpConnectionPtr&,
+                                       const HttpRequest&,
+                                       const RouteParams&)>;
+
+    struct Match {
+        const Handler*   handler{nullptr};  // 为空：未命中
+        bool             pathFound{false};  // 路径存在但方法不匹配 → 405
+        std::string_view allow;             // 该路径已注册的方法，如 "GET, DELETE"
+        RouteParams      params;
+    };
+
+    Router();
+    ~Router();
+
+    Router(const Router&)            = delete;
+    Router& operator=(const Router&) = delete;
+
+    // 同一路径同一方法重复注册、参数名冲突或模式非法时抛出 std::invalid_argument
+    void add(std::string_view method, std::string_view pattern, Handler handler);
+
+    // path 不含查询串
+    [[nodiscard]] Match match(std::string_view method, std::string_view path) const;
+
+  private:
+    struct Node;
+
+    Node*       insertStatic(Node* node, std::string_view text);
+    const Node* lookup(const Node& node, std::string_view path, RouteParams& params) const;
+
+    std::unique_ptr<Node> root_;
+};
+
+}  // namespace Http
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "Channel.hpp"
+#include "EventLoop.hpp"
+#include "http/Compression.hpp"
+
+namespace Http {
+
+// 静态资源缓存：以相对 root 的路径为键，保存文件内容与预先拼好的响应头。
+// 命中时不访问磁盘也不复制内容，条件请求所需的 ETag 与 304 响应头也一并预先生成；
+// 文件变化通过 inotify 失效（不可用时缓存项只使用 kRecheckInterval），总字节数超过上限时按 LRU 淘汰。只在所属 EventLoop 的线程中使用（load() 除外）：
+// 读文件、stat 旁路文件与建立目录监视都在 load() 中完成，loop 线程只发布结果。
+// 文本类资源另有压缩变体：优先读取同目录的 "<name>.gz" 旁路文件，否则在首次被请求时压缩一次，
+// 之后与原文件一样缓存，重复请求不再消耗 CPU。
+class StaticFileCache {
+  public:
+    // inotify 不可用时，缓存项在这段时间之后按未命中处理，由 load() 重新读取
+    static constexpr std::chrono::seconds kRecheckInterval{1};
+
+    struct Entry {
+        // 状态行、Content-Type、Content-Length、ETag、Last-Modified、Cache-Control
+        // （不含 Connection/Date 与空行）
+        std::string head;
+        std::string notModifiedHead;  // 304 状态行与 ETag、Last-Modified、Cache-Control
+        std::string body;
+        std::string   etag;  // 内容哈希的强 ETag（压缩变体有各自的 ETag）
+        std::time_t   mtime{0};
+        off_t         size{0};  // 原文件的大小与 mtime，压缩变体也记录原文件的
+        ContentCoding coding{ContentCoding::IDENTITY};
+        bool          negotiable{false};  // 存在压缩变体，响应须带 Vary: Accept-Encoding
+    };
+
+    struct Stats {
+        uint64_t hits{0};
+        uint64_t misses{0};
+        uint64_t evictions{0};
+        uint64_t invalidations{0};
+        uint64_t compressions{0};  // 现场压缩次数（不含旁路文件）
+        size_t   entries{0};
+        size_t   bytes{0};
+    };
+
+    StaticFileCache(Server::EventLoop* loop, std::filesystem::path root, size_t maxBytes);
+    ~StaticFileCache();
+
+    StaticFileCache(const StaticFileCache&)            = delete;
+    StaticFileCache& operator=(const StaticFileCache&) = delete;
+
+    // load() 的结果：在线程池中读取，回到 loop 线程后交给 store()
+    struct Loaded {
+        std::string                  key;       // 规范化后的键，路径非法时为空
+        std::shared_ptr<const Entry> identity;  // 文件不存在或不是普通文件时为空
+        std::shared_ptr<const Entry> variant;   // 不可协商或压缩不划算时为空
+        bool                         compressed{false};  // variant 为现场压缩所得
+        int                          watch{-1};  // 读取之前建立的目录监视，失败或不可用时为 -1
+    };
+
+    // relPath 为已解码的相对路径。accept 为客户端可接受的编码，有对应压缩变体时返回变体，
+    // 否则返回原文件。只查缓存、不访问文件系统，未命中返回空
+    std::shared_ptr<const Entry> find(std::string_view relPath, ContentCoding accept);
+    // 可在任意线程调用：先监视文件所在目录，再读取文件并按需生成压缩变体，不访问缓存状态。
+    // 越界、不存在或不是普通文件时 identity 为空
+    [[nodiscard]] Loaded load(std::string_view relPath, ContentCoding accept) const;
+    // 每处理一个 inotify 事件加一；load() 之前取得，交给 store() 判断读取期间是否有变化
+    [[nodiscard]] uint64_t generation() const {
+        return generation_;
+    }
+    // loop 线程：把 load() 的结果放入缓存并返回应答使用的项。
+    // 超过单项上限（总上限的 1/4）的文件，或读取期间目录有变化时照常返回，但不进入缓存
+    std::shared_ptr<const Entry> store(const Loaded& loaded,
+                                       ContentCoding accept,
+                                       uint64_t      generation);
+    // find → load → store 的同步组合
+    std::shared_ptr<const Entry> get(std::string_view relPath,
+                                     ContentCoding    accept = ContentCoding::IDENTITY);
+
+    // 以下配置会被 load() 在工作线程读取，只应在开始服务之前修改
+    void setMaxBytes(size_t maxBytes);
+    // 现场压缩的级别与最小文件大小；已缓存的项不受影响
+    void setCompression(const CompressionOptions& options) {
+        compression_ = options;
+    }
+
+    [[nodiscard]] Stats stats() const;
+
+  private:
+    struct Slot {
+        std::shared_ptr<const Entry>          entry;
+        std::list<std::string>::iterator      lru;
+        std::chrono::steady_clock::time_point stored;  // 放入缓存的时间（用于 kRecheckInterval）
+    };
+
+    std::shared_ptr<const Entry> findIdentity(const std::string& key);
+    bool                         cacheable(const Entry& entry) const;
+    void                         insert(std::string key, std::shared_ptr<const Entry> entry);
+    void                         erase(const std::string& key);
+    void                         invalidate(const std::string& key);  // 连同其压缩变体
+    void                         evict();
+    void                         handleInotify();
+
+    Server::EventLoop*                    loop_;
+    std::filesystem::path                 root_;
+    size_t                                maxBytes_;
+    size_t                                bytes_{0};
+    std::unordered_map<std::string, Slot> entries_;
+    std::list<std::string>                lru_;        // 头部为最近使用
+    std::unordered_set<std::string>       noVariant_;  // 压缩不划算的变体键，避免反复尝试
+    int                                   inotifyFd_{-1};
+    std::unique_ptr<Server::Channel>      inotifyChannel_;
+    std::unordered_map<int, std::string>  watchDirs_;  // wd → 相对目录（根目录为空）
+    uint64_t                              generation_{0};
+    CompressionOptions                    compression_;
+    Stats                                 stats_;
+};
+
+}  // namespace Http
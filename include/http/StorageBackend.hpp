@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+#include "http/MappedFileCache.hpp"
+#include "http/UploadFile.hpp"
+
+namespace Http {
+
+// 按文件名保存对象的存储后端。HttpServer 的下载、上传提交与删除只通过它访问文件内容：
+// 本地目录（LocalDiskBackend）与内存（MemoryBackend）可以互换，后者也可以作为前者之前的 LRU 热层。
+// 上传仍先流式写入 storageDir 中的临时文件，提交时交给后端。
+// 除标明不阻塞的方法外都可能阻塞，在磁盘线程池中调用；实现须线程安全。
+class StorageBackend {
+  public:
+    struct ObjectInfo {
+        uint64_t    size{0};
+        std::time_t mtime{0};
+        std::string etag;  // 强 ETag（带引号）
+    };
+    // 读到的对象：磁盘上的对象给出 fd（由调用方关闭），内存中的对象给出共享的只读内容
+    struct Object {
+        ObjectInfo                  info;
+        int                         fd{-1};
+        MappedFileCache::MappingPtr memory;
+    };
+
+    StorageBackend()          = default;
+    virtual ~StorageBackend() = default;
+
+    StorageBackend(const StorageBackend&)            = delete;
+    StorageBackend& operator=(const StorageBackend&) = delete;
+
+    // 不存在时返回 false，ec 为 no_such_file_or_directory
+    virtual bool open(const std::string& name, Object& object, std::error_code& ec) = 0;
+    // 提交已 flush 的上传，名字为 file.name()；成功时 info 为新对象的元数据
+    virtual bool commit(UploadFile&      file,
+                        Durability       durability,
+                        ObjectInfo&      info,
+                        std::error_code& ec) = 0;
+    // 提交已完整写好并落盘的文件 source（续传会话），成功后 source 不再存在
+    virtual bool place(const std::filesystem::path& source,
+                       const std::string&           name,
+                       Durability                   durability,
+                       ObjectInfo&                  info,
+                       std::error_code&             ec) = 0;
+    // 不存在时返回 false，ec 为 no_such_file_or_directory
+    virtual bool remove(const std::string& name, std::error_code& ec) = 0;
+
+    // 不阻塞：已在内存中的对象，没有时返回空。热文件据此在 loop 线程直接回复
+    virtual MappedFileCache::MappingPtr cached(const std::string& /*name*/) {
+        return nullptr;
+    }
+    // 不阻塞：name 在后端之外被改动（inotify），丢弃可能过期的副本；name 为空表示全部
+    virtual void invalidate(const std::string& /*name*/) {}
+};
+
+}  // namespace Http
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <string_view>
+
+namespace Http {
+
+// POSIX tar（ustar，必要时带 pax 扩展头）的归档格式：每个文件是一个 512 字节的头部块，
+// 其后是内容，补零到 512 字节的整数倍；归档以两个全零块结束。
+// 名字超过 100 字节或大小不能用 11 位八进制表示（8 GiB 及以上）时，先输出一个 pax 扩展头
+// 记录完整的 path 与 size，GNU tar、bsdtar 与 Python tarfile 都能识别。
+inline constexpr size_t kTarBlockSize = 512;
+
+// 追加 name 的头部（可能含 pax 扩展头），权限固定为 0644，属主为 0
+void appendTarHeader(std::string& out, std::string_view name, uint64_t size, std::time_t mtime);
+
+// 内容之后需要补的零字节数
+inline size_t tarPadding(uint64_t size) {
+    return static_cast<size_t>((kTarBlockSize - size % kTarBlockSize) % kTarBlockSize);
+}
+
+// 归档结尾的两个全零块
+void appendTarTrailer(std::string& out);
+
+}  // namespace Http
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include "StorageEngine.hpp"
+#include "http/Hash64.hpp"
+
+namespace Http {
+
+// 上传提交时的落盘保证。NONE 只依赖页缓存；DATA 在 rename 之前 fdatasync，
+// 崩溃后不会出现内容不完整的文件；FULL 另外 fsync 所在目录，rename 本身也已持久化
+enum class Durability { NONE, DATA, FULL };
+
+// 流式上传的落盘目标：body 边到边写入临时目录中的文件，commit() 时 rename 到最终路径，
+// 未提交的临时文件在 abort()/析构时删除，因此每个上传占用的内存与文件大小无关。
+// 已知大小的上传按 Content-Length 预分配（fallocate），文件在磁盘上尽量连续，空间不足时尽早失败。
+// 给定 StorageEngine 时数据攒满 kWriteChunk 才异步提交一次写入，write() 不阻塞；
+// 在途写入超过 kMaxPending 字节时 backlogged() 为真，调用方应暂停接收（见 onDrain）。
+class UploadFile {
+  public:
+    static constexpr size_t kWriteChunk = 256 * 1024;
+    static constexpr size_t kMaxPending = 4 * 1024 * 1024;
+
+    UploadFile() = default;
+    ~UploadFile();
+
+    UploadFile(const UploadFile&)            = delete;
+    UploadFile& operator=(const UploadFile&) = delete;
+    UploadFile(UploadFile&& other) noexcept;
+    UploadFile& operator=(UploadFile&& other) noexcept;
+
+    // 在 tempDir 下创建唯一的临时文件；name 为最终文件名（已清洗）。engine 为空时同步写入。
+    // expectedSize 为 body 长度（未知时为 0），非零时预分配；失败原因见 error()
+    bool open(const std::filesystem::path& tempDir,
+              std::string                  name,
+              Server::StorageEngine*       engine       = nullptr,
+              uint64_t                     expectedSize = 0);
+    // 续传分片：从 offset 起写入已存在的文件（复制 fd，调用方的 fd 不受影响）。
+    // 不创建也不删除任何文件，写完后析构或 abort() 只关闭复制的 fd，不能 commit()
+    bool openRange(int fd, uint64_t offset, Server::StorageEngine* engine = nullptr);
+    // 之前的异步写入已失败时返回 false
+    bool write(std::string_view data);
+    // 提交缓冲中的剩余数据，全部写入完成后调用 done（无在途写入时立即调用）
+    void flush(std::function<void(bool ok)> done);
+    [[nodiscard]] bool backlogged() const;
+    // 在途写入回落到 kMaxPending 的一半以下时调用一次 cb
+    void onDrain(std::function<void()> cb);
+    // 按 durability 落盘后原子替换 target；失败时临时文件被删除。关闭前把边写边算的内容哈希
+    // 作为 ETag 持久化到文件的扩展属性（文件系统不支持时忽略，下载时再计算）。
+    // 须在 flush() 完成之后调用，可以在任意线程执行
+    bool commit(const std::filesystem::path& target, Durability durability, std::error_code& ec);
+    void abort();
+
+    [[nodiscard]] bool isOpen() const {
+        return fd_ >= 0;
+    }
+    [[nodiscard]] const std::string& name() const {
+        return name_;
+    }
+    [[nodiscard]] size_t written() const {
+        return written_;
+    }
+    // 已写入内容的 XXH64（边写边算）
+    [[nodiscard]] uint64_t digest() const {
+        return hash_.digest();
+    }
+    // 尚未提交的临时文件（openRange 时为空）
+    [[nodiscard]] const std::filesystem::path& tempPath() const {
+        return tempPath_;
+    }
+    // 最近一次 open() 失败的 errno（如预分配时的 ENOSPC），成功时为 0
+    [[nodiscard]] int error() const {
+        return error_;
+    }
+
+  private:
+    // 异步写入的进度，完成回调与 UploadFile 对象解耦（对象可能已被移动或销毁）
+    struct Pending {
+        size_t                bytes{0};  // 在途字节数
+        int                   err{0};
+        int                   closeFd{-1};  // 放弃上传时，待在途写入结束后再关闭的 fd
+        std::function<void()> onIdle;
+        std::function<void()> onDrain;
+
+        void settle();
+    };
+
+    void reset();
+    void submitBuffer();
+
+    int                      fd_{-1};
+    std::filesystem::path    tempPath_;
+    std::string              name_;
+    uint64_t                 base_{0};  // 第一个字节在文件中的偏移（openRange）
+    size_t                   written_{0};
+    uint64_t                 preallocated_{0};
+    int                      error_{0};
+    Hash64                   hash_;
+    Server::StorageEngine*   engine_{nullptr};
+    std::string              buffer_;  // 尚未提交的数据
+    std::shared_ptr<Pending> pending_;
+};
+
+}  // namespace Http
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+
+#include "http/StorageBackend.hpp"
+#include "http/UploadFile.hpp"
+
+namespace Http {
+
+// 可续传的分片上传会话：客户端先声明文件名与总大小，再用带 Content-Range 的 PUT
+// 分片上传（可以乱序、并行、重复），最后提交。每个会话在 dir 中对应两个文件：
+//   <id>.part  按总大小预分配的数据文件，分片直接写到各自的偏移
+//   <id>.meta  首行记录大小与文件名，之后每写完一个分片追加一行 "first end"
+// 分片先落盘再追加进度，服务器重启后按 .meta 恢复已确认的区间，客户端查询后只补传缺失部分。
+// 会话表只在 loop 线程访问；create/record/commit/discard 做阻塞 I/O，在磁盘线程池中执行。
+class UploadSessions {
+  public:
+    // 同时存在的会话上限（每个会话占用一个 fd）
+    static constexpr size_t kMaxSessions = 1024;
+    // 超过该时长没有任何进度的会话在启动时清理
+    static constexpr std::chrono::hours kExpiry{7 * 24};
+
+    struct Session {
+        std::string                  id;
+        std::string                  name;  // 提交后的文件名（已清洗）
+        uint64_t                     size{0};
+        int                          fd{-1};  // 数据文件，会话对象析构时关闭
+        std::map<uint64_t, uint64_t> ranges;  // 已落盘的区间 first → end（不含），互不相接
+        size_t                       writers{0};     // 正在接收的 PUT 数
+        bool                         closed{false};  // 已提交或已删除，不再接受分片
+
+        Session() = default;
+        ~Session();
+        Session(const Session&)            = delete;
+        Session& operator=(const Session&) = delete;
+
+        [[nodiscard]] uint64_t received() const;
+        [[nodiscard]] bool     complete() const {
+            return received() == size;
+        }
+        // 合并新确认的区间 [first, end)
+        void add(uint64_t first, uint64_t end);
+        // {"id":...,"name":...,"size":...,"received":...,"ranges":[[first,end],...]}
+        [[nodiscard]] std::string json() const;
+    };
+    using SessionPtr = std::shared_ptr<Session>;
+
+    // 正在接收的 PUT 持有一个 Writer；析构（包括连接中途断开）时释放会话的写入计数
+    struct Writer {
+        SessionPtr session;
+        uint64_t   first{0};
+        uint64_t   end{0};
+
+        Writer(SessionPtr s, uint64_t f, uint64_t e);
+        ~Writer();
+        Writer(const Writer&)            = delete;
+        Writer& operator=(const Writer&) = delete;
+    };
+    using WriterPtr = std::shared_ptr<Writer>;
+
+    // 阻塞：创建 dir 并加载其中保存的会话，损坏或过期的会话连同数据一起删除
+    explicit UploadSessions(std::filesystem::path dir);
+
+    UploadSessions(const UploadSessions&)            = delete;
+    UploadSessions& operator=(const UploadSessions&) = delete;
+
+    // 以下四个在线程池中执行，不访问会话表。
+    // 创建数据文件（按 size 预分配，空间不足时失败）与元数据文件
+    SessionPtr create(const std::string& name,
+                      uint64_t           size,
+                      Durability         durability,
+                      std::error_code&   ec) const;
+    // 分片 [first, end) 已写入：按 durability 把数据落盘后追加进度
+    bool record(const Session&   session,
+                uint64_t         first,
+                uint64_t         end,
+                Durability       durability,
+                std::error_code& ec) const;
+    // 全部区间到齐后调用：落盘、写入 ETag 扩展属性，把数据文件交给 backend 并删除元数据
+    bool commit(const Session&              session,
+                StorageBackend&             backend,
+                Durability                  durability,
+                StorageBackend::ObjectInfo& info,
+                std::error_code&            ec) const;
+    // 删除会话的文件
+    void discard(const Session& session) const;
+
+    // 以下在 loop 线程调用
+    void                     insert(SessionPtr session);
+    [[nodiscard]] SessionPtr find(std::string_view id) const;
+    // 从表中移除并标记 closed；正在进行的写入仍持有会话，结束后关闭 fd
+    void                 erase(const std::string& id);
+    [[nodiscard]] size_t size() const {
+        return sessions_.size();
+    }
+
+  private:
+    [[nodiscard]] std::filesystem::path partPath(const std::string& id) const;
+    [[nodiscard]] std::filesystem::path metaPath(const std::string& id) const;
+    void                                load();
+    SessionPtr                          loadOne(const std::string& id);
+
+    std::filesystem::path                       dir_;
+    std::unordered_map<std::string, SessionPtr> sessions_;
+};
+
+}  // namespace Http
@@ -0,0 +1,105 @@
+#include "../include/DiskIoPool.hpp"
+
+#include <algorithm>
+
+#include "../include/EventLoop.hpp"
+#include "../include/Log.hpp"
+
+using namespace Server;
+
+namespace {
+uint64_t elapsedNs(std::chrono::steady_clock::time_point from,
+                   std::chrono::steady_clock::time_point to) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+}
+}  // namespace
+
+DiskIoPool::DiskIoPool(EventLoop* loop, size_t threads, size_t maxQueued)
+    : loop_(loop), maxQueued_(maxQueued), self_(std::make_shared<DiskIoPool*>(this)) {
+    threads = std::max<size_t>(threads, 1);
+    workers_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back([this]() { this->workerLoop(); });
+    }
+    LOG_INFO("disk io pool started: {} threads, queue limit {}", threads, maxQueued_);
+}
+
+DiskIoPool::~DiskIoPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        queue_.clear();
+    }
+    cond_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    self_.reset();
+}
+
+bool DiskIoPool::submit(Task work, Task done) {
+    auto job       = std::make_unique<Job>();
+    job->work      = std::move(work);
+    job->done      = std::move(done);
+    job->submitted = Clock::now();
+    size_t depth   = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.size() >= maxQueued_) {
+            ++stats_.rejected;
+            return false;
+        }
+        queue_.push_back(std::move(job));
+        depth = queue_.size();
+    }
+    cond_.notify_one();
+    ++stats_.submitted;
+    ++stats_.inFlight;
+    stats_.maxQueued = std::max(stats_.maxQueued, depth);
+    return true;
+}
+
+void DiskIoPool::workerLoop() {
+    for (;;) {
+        std::unique_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            job = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        job->started = Clock::now();
+        job->work();
+        job->finished = Clock::now();
+
+        // 交回 loop 线程；池已析构（self_ 失效）时直接丢弃
+        std::weak_ptr<DiskIoPool*> weak = self_;
+        loop_->queueInLoop([weak, job = std::shared_ptr<Job>(std::move(job))]() {
+            if (auto self = weak.lock()) {
+                (*self)->complete(*job);
+            }
+        });
+    }
+}
+
+void DiskIoPool::complete(const Job& job) {
+    const uint64_t latency = elapsedNs(job.submitted, Clock::now());
+    ++stats_.completed;
+    --stats_.inFlight;
+    stats_.waitNs += elapsedNs(job.submitted, job.started);
+    stats_.serviceNs += elapsedNs(job.started, job.finished);
+    stats_.latencyNs += latency;
+    stats_.maxLatencyNs = std::max(stats_.maxLatencyNs, latency);
+    job.done();
+}
+
+DiskIoPool::Stats DiskIoPool::stats() const {
+    Stats out = stats_;
+    std::lock_guard<std::mutex> lock(mutex_);
+    out.queued = queue_.size();
+    return out;
+}
@@ -1,20 +1,73 @@
 #include "../include/EventLoop.hpp"
 
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
 #include "../include/Channel.hpp"
 #include "../include/EpollPoller.hpp"
+#include "../include/Log.hpp"
 
 using namespace Server;
 
-EventLoop::EventLoop() : poller_(std::make_unique<EpollPoller>()) {}
+namespace {
+uint64_t elapsedNs(std::chrono::steady_clock::time_point from,
+                   std::chrono::steady_clock::time_point to) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+}
+}  // namespace
+
+EventLoop::EventLoop() : poller_(std::make_unique<EpollPoller>()) {
+    wakeupFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeupFd_ < 0) {
+        LOG_CRITICAL("eventfd failed: {}", strerror(errno));
+        return;
+    }
+    wakeupChannel_ = std::make_unique<Channel>(this, wakeupFd_);
+    wakeupChannel_->setReadCallback([this]() { this->handleWakeup(); });
+    wakeupChannel_->enableReading();
+}
 
-EventLoop::~EventLoop() = default;
+EventLoop::~EventLoop() {
+    if (wakeupChannel_) {
+        wakeupChannel_->disableAll();
+        wakeupChannel_->remove();
+    }
+    if (wakeupFd_ >= 0) {
+        ::close(wakeupFd_);
+    }
+}
 
 void EventLoop::loop(int timeout) {
+    using Clock = std::chrono::steady_clock;
+    // 初始视为"很久没有活动"，第一轮直接阻塞
+    Clock::time_point lastActive = Clock::now() - busyPollWindow_;
     while (true) {
-        activeChannels_ = poller_->poll(timeout);
-        for (auto* channel : activeChannels_) {
-            channel->handleEvent();
+        const auto start = Clock::now();
+        // 窗口期内自旋：epoll_wait(0) 立即返回，避免睡眠/唤醒带来的调度延迟
+        const bool spinning = busyPollWindow_.count() > 0 && (start - lastActive) < busyPollWindow_;
+
+        activeChannels_   = poller_->poll(spinning ? 0 : timeout);
+        const auto polled = Clock::now();
+        if (spinning) {
+            ++stats_.spinPolls;
+            stats_.spinNs += elapsedNs(start, polled);
+        } else {
+            stats_.blockNs += elapsedNs(start, polled);
         }
+
+        if (!activeChannels_.empty()) {
+            for (auto* channel : activeChannels_) {
+                channel->handleEvent();
+            }
+            doPendingFunctors();
+            lastActive = Clock::now();
+            stats_.workNs += elapsedNs(polled, lastActive);
+        }
+        ++stats_.iterations;
     }
 }
 
@@ -28,3 +81,32 @@ void EventLoop::updateChannel(Channel* channel) {
 void EventLoop::removeChannel(Channel* channel) {
     poller_->removeChannel(channel);
 }
+
+void EventLoop::queueInLoop(Functor functor) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pendingFunctors_.push_back(std::move(functor));
+    }
+    const uint64_t one = 1;
+    if (::write(wakeupFd_, &one, sizeof(one)) != sizeof(one) && errno != EAGAIN) {
+        LOG_ERROR("failed to wake up event loop: {}", strerror(errno));
+    }
+}
+
+void EventLoop::handleWakeup() {
+    uint64_t count = 0;
+    // 清零计数；任务本身在 doPendingFunctors 执行
+    (void) ::read(wakeupFd_, &count, sizeof(count));
+}
+
+void EventLoop::doPendingFunctors() {
+    std::vector<Functor> functors;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        functors.swap(pendingFunctors_);
+    }
+    // 在锁外执行：functor 内部可以再次 queueInLoop
+    for (auto& functor : functors) {
+        functor();
+    }
+}
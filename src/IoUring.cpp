@@ -0,0 +1,204 @@
+#include "IoUring.hpp"
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "Log.hpp"
+
+using namespace Server;
+
+namespace {
+// 头尾指针与内核共享，读对方写的值用 acquire，发布自己的值用 release
+unsigned loadAcquire(const unsigned* p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+void storeRelease(unsigned* p, unsigned value) {
+    __atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+template <typename T>
+T* at(void* base, unsigned offset) {
+    return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+}
+}  // namespace
+
+IoUring::IoUring(unsigned entries) {
+    io_uring_params params{};
+    const int       fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0) {
+        LOG_WARN("io_uring unavailable: {}", strerror(errno));
+        return;
+    }
+
+    sqRingBytes_      = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingBytes_      = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) {
+        sqRingBytes_ = cqRingBytes_ = std::max(sqRingBytes_, cqRingBytes_);
+    }
+    sqRing_ = ::mmap(nullptr,
+                     sqRingBytes_,
+                     PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE,
+                     fd,
+                     IORING_OFF_SQ_RING);
+    cqRing_ = single ? sqRing_
+                     : ::mmap(nullptr,
+                              cqRingBytes_,
+                              PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_POPULATE,
+                              fd,
+                              IORING_OFF_CQ_RING);
+    sqesBytes_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr,
+                        sqesBytes_,
+                        PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE,
+                        fd,
+                        IORING_OFF_SQES);
+    if (sqRing_ == MAP_FAILED || cqRing_ == MAP_FAILED || sqes == MAP_FAILED) {
+        LOG_WARN("io_uring mmap failed: {}", strerror(errno));
+        if (sqes != MAP_FAILED) {
+            ::munmap(sqes, sqesBytes_);
+        }
+        if (!single && cqRing_ != MAP_FAILED) {
+            ::munmap(cqRing_, cqRingBytes_);
+        }
+        if (sqRing_ != MAP_FAILED) {
+            ::munmap(sqRing_, sqRingBytes_);
+        }
+        sqRing_ = cqRing_ = nullptr;
+        ::close(fd);
+        return;
+    }
+    sqes_      = static_cast<io_uring_sqe*>(sqes);
+    sqHead_    = at<unsigned>(sqRing_, params.sq_off.head);
+    sqTail_    = at<unsigned>(sqRing_, params.sq_off.tail);
+    sqMask_    = at<unsigned>(sqRing_, params.sq_off.ring_mask);
+    sqArray_   = at<unsigned>(sqRing_, params.sq_off.array);
+    cqHead_    = at<unsigned>(cqRing_, params.cq_off.head);
+    cqTail_    = at<unsigned>(cqRing_, params.cq_off.tail);
+    cqMask_    = at<unsigned>(cqRing_, params.cq_off.ring_mask);
+    cqes_      = at<io_uring_cqe>(cqRing_, params.cq_off.cqes);
+    sqeTail_   = *sqTail_;
+    sqEntries_ = params.sq_entries;
+
+    // 数组与 SQE 一一对应，之后不再改动
+    for (unsigned i = 0; i < sqEntries_; ++i) {
+        sqArray_[i] = i;
+    }
+
+    eventFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (eventFd_ < 0 ||
+        ::syscall(__NR_io_uring_register, fd, IORING_REGISTER_EVENTFD, &eventFd_, 1) < 0) {
+        LOG_WARN("io_uring eventfd registration failed: {}", strerror(errno));
+        ringFd_ = fd;
+        release();
+        return;
+    }
+    ringFd_ = fd;
+    LOG_INFO("io_uring ready: {} sq entries, {} cq entries", params.sq_entries, params.cq_entries);
+}
+
+IoUring::~IoUring() {
+    release();
+}
+
+void IoUring::release() {
+    if (sqes_ != nullptr) {
+        ::munmap(sqes_, sqesBytes_);
+        sqes_ = nullptr;
+    }
+    if (cqRing_ != nullptr && cqRing_ != sqRing_) {
+        ::munmap(cqRing_, cqRingBytes_);
+    }
+    if (sqRing_ != nullptr) {
+        ::munmap(sqRing_, sqRingBytes_);
+    }
+    sqRing_ = cqRing_ = nullptr;
+    if (eventFd_ >= 0) {
+        ::close(eventFd_);
+    }
+    if (ringFd_ >= 0) {
+        ::close(ringFd_);
+    }
+    eventFd_ = -1;
+    ringFd_  = -1;
+}
+
+unsigned IoUring::space() const {
+    return valid() ? sqEntries_ - (sqeTail_ - loadAcquire(sqHead_)) : 0;
+}
+
+io_uring_sqe* IoUring::getSqe() {
+    if (space() == 0) {
+        return nullptr;
+    }
+    io_uring_sqe* sqe = &sqes_[sqeTail_ & *sqMask_];
+    std::memset(sqe, 0, sizeof(*sqe));
+    ++sqeTail_;
+    return sqe;
+}
+
+int IoUring::submit() {
+    if (!valid()) {
+        return -ENOSYS;
+    }
+    storeRelease(sqTail_, sqeTail_);
+    // 未使用 SQPOLL，内核在 io_uring_enter 中同步取走 SQE 并推进 head
+    const unsigned pending = sqeTail_ - loadAcquire(sqHead_);
+    if (pending == 0) {
+        return 0;
+    }
+    for (;;) {
+        const long ret = ::syscall(__NR_io_uring_enter, ringFd_, pending, 0, 0, nullptr, 0);
+        if (ret >= 0) {
+            return static_cast<int>(ret);
+        }
+        if (errno != EINTR) {
+            return -errno;  // EAGAIN/EBUSY：SQE 留在队列中，下次提交时重试
+        }
+    }
+}
+
+size_t IoUring::reap(const std::function<void(const io_uring_cqe&)>& handler) {
+    if (!valid()) {
+        return 0;
+    }
+    size_t count = 0;
+    for (;;) {
+        unsigned       head = *cqHead_;
+        const unsigned tail = loadAcquire(cqTail_);
+        if (head == tail) {
+            return count;
+        }
+        for (; head != tail; ++head, ++count) {
+            // 先复制再释放槽位，handler 中提交的新请求可以立即复用它
+            const io_uring_cqe cqe = cqes_[head & *cqMask_];
+            storeRelease(cqHead_, head + 1);
+            handler(cqe);
+        }
+    }
+}
+
+int IoUring::wait() {
+    if (!valid()) {
+        return -ENOSYS;
+    }
+    for (;;) {
+        const long ret =
+            ::syscall(__NR_io_uring_enter, ringFd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (ret >= 0) {
+            return 0;
+        }
+        if (errno != EINTR) {
+            return -errno;
+        }
+    }
+}
@@ -135,6 +135,29 @@ void Socket::setKeepAlive(bool on) const {
     }
 }
 
+bool Socket::setBusyPoll(int usec) const {
+    if (::setsockopt(socketfd_, SOL_SOCKET, SO_BUSY_POLL, &usec, sizeof(usec)) == -1) {
+        LOG_WARN("setsockopt(SO_BUSY_POLL={}) fd={} failed: {}", usec, socketfd_, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool Socket::setPreferBusyPoll(bool on) const {
+#ifdef SO_PREFER_BUSY_POLL
+    int val = on ? 1 : 0;
+    if (::setsockopt(socketfd_, SOL_SOCKET, SO_PREFER_BUSY_POLL, &val, sizeof(val)) == -1) {
+        LOG_WARN("setsockopt(SO_PREFER_BUSY_POLL) fd={} failed: {}", socketfd_, strerror(errno));
+        return false;
+    }
+    return true;
+#else
+    (void) on;
+    LOG_WARN("SO_PREFER_BUSY_POLL unsupported by system headers");
+    return false;
+#endif
+}
+
 void Socket::connect(const InetAddress& serveraddr) const {
     const struct addrinfo* list = serveraddr.getAddrinfoList();
     const struct addrinfo* rp   = nullptr;
@@ -0,0 +1,458 @@
+#include "StorageEngine.hpp"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "Channel.hpp"
+#include "DiskIoPool.hpp"
+#include "EventLoop.hpp"
+#include "IoUring.hpp"
+#include "Log.hpp"
+
+using namespace Server;
+
+namespace {
+// 读满 len 字节；读错误返回 errno，文件提前结束返回 EIO
+int preadAll(int fd, char* buf, size_t len, uint64_t offset) {
+    size_t done = 0;
+    while (done < len) {
+        const ssize_t n = ::pread(fd, buf + done, len - done, static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return errno;
+        }
+        if (n == 0) {
+            return EIO;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return 0;
+}
+
+int pwriteAll(int fd, const char* buf, size_t len, uint64_t offset) {
+    size_t done = 0;
+    while (done < len) {
+        const ssize_t n = ::pwrite(fd, buf + done, len - done, static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return errno;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return 0;
+}
+}  // namespace
+
+// 一个 SQE 对应的请求；提交时把指针放进 user_data，完成时收回
+struct StorageEngine::Op {
+    enum class Kind : uint8_t { READ, WRITE, SEND };
+
+    Kind                     kind{Kind::READ};
+    int                      fd{-1};
+    char*                    buf{nullptr};  // WRITE/SEND 只读
+    size_t                   len{0};
+    uint64_t                 offset{0};
+    bool                     link{false};  // 与组内下一个请求链接
+    std::function<void(int)> complete;     // 参数为 cqe.res
+};
+
+struct StorageEngine::ReadJob {
+    int          fd{-1};
+    std::string  data;
+    size_t       pending{0};  // 尚未完成的块数
+    int          err{0};
+    ReadCallback done;
+
+    void finish(int chunkErr) {
+        if (chunkErr != 0 && err == 0) {
+            err = chunkErr;
+        }
+        if (--pending == 0) {
+            done(err, err == 0 ? std::move(data) : std::string{});
+        }
+    }
+};
+
+struct StorageEngine::SendChain {
+    std::vector<std::string> buffers;
+    std::vector<int>         readRes;
+    std::vector<int>         sendRes;
+    size_t                   pending{0};
+    SendCallback             done;
+};
+
+StorageEngine::StorageEngine(EventLoop*  loop,
+                             DiskIoPool* pool,
+                             bool        useIoUring,
+                             unsigned    queueDepth)
+    : loop_(loop), pool_(pool), self_(std::make_shared<StorageEngine*>(this)) {
+    if (useIoUring) {
+        auto ring = std::make_unique<IoUring>(queueDepth);
+        if (ring->valid()) {
+            ring_    = std::move(ring);
+            channel_ = std::make_unique<Channel>(loop_, ring_->eventFd());
+            channel_->setReadCallback([this]() { this->handleCompletions(); });
+            channel_->enableReading();
+        }
+    }
+    LOG_INFO("storage engine backend: {}", ring_ ? "io_uring" : "thread pool");
+}
+
+StorageEngine::~StorageEngine() {
+    if (channel_) {
+        channel_->disableAll();
+        channel_->remove();
+    }
+    backlog_.clear();
+    // 内核可能仍在读写这些请求的缓冲区，必须等它们完成后才能释放
+    while (ring_ && stats_.inFlight > 0) {
+        if (ring_->wait() < 0) {
+            LOG_ERROR("storage engine: {} requests still in flight at shutdown", stats_.inFlight);
+            break;
+        }
+        ring_->reap([this](const io_uring_cqe& cqe) {
+            std::unique_ptr<Op> op(reinterpret_cast<Op*>(cqe.user_data));
+            --stats_.inFlight;
+        });
+    }
+    self_.reset();
+}
+
+StorageEngine::Stats StorageEngine::stats() const {
+    Stats out   = stats_;
+    out.backlog = 0;
+    for (const auto& group : backlog_) {
+        out.backlog += group.size();
+    }
+    return out;
+}
+
+void StorageEngine::read(int fd, uint64_t offset, size_t length, ReadCallback done) {
+    auto job  = std::make_shared<ReadJob>();
+    job->fd   = fd;
+    job->done = std::move(done);
+    job->data.resize(length);
+    if (length == 0) {
+        job->pending = 1;
+        defer([job]() { job->finish(0); });
+        return;
+    }
+    // 先算出块数：线程池的完成回调总是稍后在 loop 线程执行，不会在提交途中结束
+    job->pending = (length + kChunkSize - 1) / kChunkSize;
+    for (size_t pos = 0; pos < length; pos += kChunkSize) {
+        readChunk(job, offset + pos, pos, std::min(kChunkSize, length - pos));
+    }
+}
+
+void StorageEngine::readChunk(const std::shared_ptr<ReadJob>& job,
+                              uint64_t                        offset,
+                              size_t                          pos,
+                              size_t                          len) {
+    if (!ring_) {
+        ++stats_.reads;
+        ++stats_.inFlight;
+        auto                          err  = std::make_shared<int>(0);
+        std::weak_ptr<StorageEngine*> weak = self_;
+        const bool                    queued = pool_->submit(
+            [job, offset, pos, len, err]() {
+                *err = preadAll(job->fd, job->data.data() + pos, len, offset);
+            },
+            [weak, job, len, err]() {
+                if (auto self = weak.lock()) {
+                    StorageEngine& engine = **self;
+                    --engine.stats_.inFlight;
+                    if (*err == 0) {
+                        engine.stats_.bytesRead += len;
+                    } else {
+                        ++engine.stats_.errors;
+                    }
+                    job->finish(*err);
+                }
+            });
+        if (!queued) {
+            --stats_.inFlight;
+            ++stats_.errors;
+            defer([job]() { job->finish(EBUSY); });
+        }
+        return;
+    }
+
+    auto op      = std::make_unique<Op>();
+    op->kind     = Op::Kind::READ;
+    op->fd       = job->fd;
+    op->buf      = job->data.data() + pos;
+    op->len      = len;
+    op->offset   = offset;
+    op->complete = [this, job, offset, pos, len](int res) {
+        if (res > 0) {
+            stats_.bytesRead += static_cast<uint64_t>(res);
+        }
+        if (res > 0 && static_cast<size_t>(res) < len) {
+            // 短读：接着读剩余部分，块数不变
+            const auto n = static_cast<size_t>(res);
+            readChunk(job, offset + n, pos + n, len - n);
+            return;
+        }
+        if (res <= 0) {
+            ++stats_.errors;
+        }
+        job->finish(res < 0 ? -res : (res == 0 ? EIO : 0));
+    };
+    std::vector<std::unique_ptr<Op>> group;
+    group.push_back(std::move(op));
+    enqueue(std::move(group));
+}
+
+void StorageEngine::write(int fd, uint64_t offset, std::string data, WriteCallback done) {
+    if (data.empty()) {
+        defer([done = std::move(done)]() { done(0); });
+        return;
+    }
+    writeChunk(fd, offset, std::make_shared<std::string>(std::move(data)), 0, std::move(done));
+}
+
+void StorageEngine::writeChunk(int                          fd,
+                               uint64_t                     offset,
+                               std::shared_ptr<std::string> data,
+                               size_t                       pos,
+                               WriteCallback                done) {
+    const size_t len = data->size() - pos;
+    if (!ring_) {
+        ++stats_.writes;
+        ++stats_.inFlight;
+        auto                          err  = std::make_shared<int>(0);
+        auto                          cb   = std::make_shared<WriteCallback>(std::move(done));
+        std::weak_ptr<StorageEngine*> weak = self_;
+        const bool                    queued = pool_->submit(
+            [fd, offset, data, pos, len, err]() {
+                *err = pwriteAll(fd, data->data() + pos, len, offset);
+            },
+            [weak, len, err, cb]() {
+                if (auto self = weak.lock()) {
+                    StorageEngine& engine = **self;
+                    --engine.stats_.inFlight;
+                    if (*err == 0) {
+                        engine.stats_.bytesWritten += len;
+                    } else {
+                        ++engine.stats_.errors;
+                    }
+                    (*cb)(*err);
+                }
+            });
+        if (!queued) {
+            --stats_.inFlight;
+            ++stats_.errors;
+            defer([cb]() { (*cb)(EBUSY); });
+        }
+        return;
+    }
+
+    auto op      = std::make_unique<Op>();
+    op->kind     = Op::Kind::WRITE;
+    op->fd       = fd;
+    op->buf      = data->data() + pos;
+    op->len      = len;
+    op->offset   = offset;
+    op->complete = [this, fd, offset, data, pos, len, done = std::move(done)](int res) mutable {
+        if (res > 0) {
+            stats_.bytesWritten += static_cast<uint64_t>(res);
+        }
+        if (res > 0 && static_cast<size_t>(res) < len) {
+            const auto n = static_cast<size_t>(res);
+            writeChunk(fd, offset + n, std::move(data), pos + n, std::move(done));
+            return;
+        }
+        if (res <= 0) {
+            ++stats_.errors;
+        }
+        done(res < 0 ? -res : (res == 0 ? EIO : 0));
+    };
+    std::vector<std::unique_ptr<Op>> group;
+    group.push_back(std::move(op));
+    enqueue(std::move(group));
+}
+
+bool StorageEngine::readToSocket(int          fd,
+                                 uint64_t     offset,
+                                 size_t       length,
+                                 int          sockFd,
+                                 SendCallback done) {
+    if (!ring_ || length == 0) {
+        return false;
+    }
+    // 一组请求必须能一次放进提交队列：每块占一对 read + send
+    length = std::min<size_t>(length, kChunkSize * std::max(1U, ring_->entries() / 2));
+    const size_t chunks = (length + kChunkSize - 1) / kChunkSize;
+
+    auto chain     = std::make_shared<SendChain>();
+    chain->done    = std::move(done);
+    chain->pending = chunks * 2;
+    chain->buffers.resize(chunks);
+    chain->readRes.assign(chunks, 0);
+    chain->sendRes.assign(chunks, 0);
+
+    auto onDone = [this, chain]() {
+        if (--chain->pending != 0) {
+            return;
+        }
+        // 按顺序找出第一处断点：此前的块都已完整发出
+        uint64_t    sent = 0;
+        int         err  = 0;
+        std::string rest;
+        for (size_t i = 0; i < chain->buffers.size(); ++i) {
+            const int r = chain->readRes[i];
+            const int s = chain->sendRes[i];
+            if (s > 0) {
+                sent += static_cast<uint64_t>(s);
+            }
+            if (r < 0 && r != -ECANCELED) {
+                err = -r;
+                break;
+            }
+            if (r > 0 && s == r) {
+                continue;
+            }
+            if (s < 0 && s != -EAGAIN && s != -ECANCELED) {
+                err = -s;  // 套接字错误（如对端已关闭）
+                break;
+            }
+            if (r > 0) {
+                const auto from = static_cast<size_t>(std::max(s, 0));
+                rest            = chain->buffers[i].substr(from, static_cast<size_t>(r) - from);
+            }
+            break;
+        }
+        stats_.bytesSent += sent;
+        if (err != 0) {
+            ++stats_.errors;
+        }
+        chain->done(err, sent, std::move(rest));
+    };
+
+    std::vector<std::unique_ptr<Op>> group;
+    for (size_t i = 0; i < chunks; ++i) {
+        const size_t len = std::min(kChunkSize, length - i * kChunkSize);
+        chain->buffers[i].resize(len);
+
+        auto readOp      = std::make_unique<Op>();
+        readOp->kind     = Op::Kind::READ;
+        readOp->fd       = fd;
+        readOp->buf      = chain->buffers[i].data();
+        readOp->len      = len;
+        readOp->offset   = offset + i * kChunkSize;
+        readOp->link     = true;  // 短读会断开链接，其后的 send 以 -ECANCELED 结束
+        readOp->complete = [this, chain, i, onDone](int res) {
+            chain->readRes[i] = res;
+            if (res > 0) {
+                stats_.bytesRead += static_cast<uint64_t>(res);
+            }
+            onDone();
+        };
+
+        auto sendOp      = std::make_unique<Op>();
+        sendOp->kind     = Op::Kind::SEND;
+        sendOp->fd       = sockFd;
+        sendOp->buf      = chain->buffers[i].data();
+        sendOp->len      = len;
+        sendOp->link     = i + 1 < chunks;
+        sendOp->complete = [chain, i, onDone](int res) {
+            chain->sendRes[i] = res;
+            onDone();
+        };
+        group.push_back(std::move(readOp));
+        group.push_back(std::move(sendOp));
+    }
+    enqueue(std::move(group));
+    return true;
+}
+
+void StorageEngine::enqueue(std::vector<std::unique_ptr<Op>> group) {
+    // 已有排队的组时不插队，保证同一连接/文件的请求按提交顺序进入内核
+    if (backlog_.empty() && trySubmit(group)) {
+        return;
+    }
+    backlog_.push_back(std::move(group));
+}
+
+bool StorageEngine::trySubmit(std::vector<std::unique_ptr<Op>>& group) {
+    // 在途请求数不超过队列深度，完成队列（深度的两倍）不会溢出
+    if (ring_->space() < group.size() || stats_.inFlight + group.size() > ring_->entries()) {
+        return false;
+    }
+    for (auto& op : group) {
+        io_uring_sqe* sqe = ring_->getSqe();
+        switch (op->kind) {
+            case Op::Kind::READ:
+                sqe->opcode = IORING_OP_READ;
+                sqe->off    = op->offset;
+                ++stats_.reads;
+                break;
+            case Op::Kind::WRITE:
+                sqe->opcode = IORING_OP_WRITE;
+                sqe->off    = op->offset;
+                ++stats_.writes;
+                break;
+            case Op::Kind::SEND:
+                sqe->opcode = IORING_OP_SEND;
+                // MSG_WAITALL：部分发送视为失败而断开链接，后续块不会越过缺口先发出
+                sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+                ++stats_.linkedSends;
+                break;
+        }
+        sqe->fd        = op->fd;
+        sqe->addr      = reinterpret_cast<uint64_t>(op->buf);
+        sqe->len       = static_cast<uint32_t>(op->len);
+        sqe->flags     = op->link ? IOSQE_IO_LINK : 0;
+        sqe->user_data = reinterpret_cast<uint64_t>(op.release());
+        ++stats_.inFlight;
+    }
+    if (!reaping_) {
+        submit();
+    }
+    return true;
+}
+
+void StorageEngine::submit() {
+    const int ret = ring_->submit();
+    if (ret < 0 && ret != -EAGAIN && ret != -EBUSY) {
+        LOG_ERROR("io_uring submit failed: {}", strerror(-ret));
+    }
+}
+
+void StorageEngine::handleCompletions() {
+    uint64_t counter = 0;
+    ssize_t  n       = 0;
+    do {
+        n = ::read(ring_->eventFd(), &counter, sizeof(counter));
+    } while (n < 0 && errno == EINTR);
+
+    // 回调中新提交的请求攒到最后一次性进入内核
+    reaping_ = true;
+    ring_->reap([this](const io_uring_cqe& cqe) {
+        std::unique_ptr<Op> op(reinterpret_cast<Op*>(cqe.user_data));
+        --stats_.inFlight;
+        op->complete(cqe.res);
+    });
+    while (!backlog_.empty() && trySubmit(backlog_.front())) {
+        backlog_.pop_front();
+    }
+    reaping_ = false;
+    submit();  // 也包括之前因 EAGAIN 留在队列中的 SQE
+}
+
+void StorageEngine::defer(std::function<void()> fn) {
+    std::weak_ptr<StorageEngine*> weak = self_;
+    loop_->queueInLoop([weak, fn = std::move(fn)]() {
+        if (weak.lock()) {
+            fn();
+        }
+    });
+}
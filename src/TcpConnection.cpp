@@ -1,6 +1,7 @@
 #include "TcpConnection.hpp"
 
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <cerrno>
@@ -62,23 +63,44 @@ void TcpConnection::forceClose() {
     }
 }
 
-void TcpConnection::send(const std::string& data) {
+void TcpConnection::stopReading() {
+    if (state_ == kConnected && channel_->isReading()) {
+        LOG_DEBUG("TcpConnection fd={} reading paused", fd());
+        channel_->disableReading();
+    }
+}
+
+void TcpConnection::startReading() {
+    if (state_ == kConnected && !channel_->isReading()) {
+        LOG_DEBUG("TcpConnection fd={} reading resumed", fd());
+        channel_->enableReading();
+    }
+}
+
+void TcpConnection::send(std::string_view data, std::string_view more) {
     if (state_ != kConnected) {
         LOG_WARN("TcpConnection fd={} send failed: not connected", fd());
         return;
     }
-    LOG_TRACE("TcpConnection fd={} sending {} bytes", fd(), data.size());
+    const size_t total = data.size() + more.size();
+    LOG_TRACE("TcpConnection fd={} sending {} bytes", fd(), total);
     if (!channel_->isWriting() && outputBuffer_.empty()) {
-        // 尝试直接写
-        ssize_t n = ::send(fd(), data.data(), data.size(), 0);
+        // 尝试直接写；两段数据由 writev 一次写出，不必先拼接
+        iovec   iov[2] = {{const_cast<char*>(data.data()), data.size()},
+                          {const_cast<char*>(more.data()), more.size()}};
+        ssize_t n      = ::writev(fd(), iov, more.empty() ? 1 : 2);
         if (n >= 0) {
             size_t sent = static_cast<size_t>(n);
-            if (sent < data.size()) {
+            if (sent < total) {
                 LOG_TRACE("TcpConnection fd={} partial send: {}/{} bytes, buffering remaining",
                           fd(),
                           sent,
-                          data.size());
-                outputBuffer_.append(data.data() + sent, data.size() - sent);
+                          total);
+                if (sent < data.size()) {
+                    outputBuffer_.append(data.substr(sent)).append(more);
+                } else {
+                    outputBuffer_.append(more.substr(sent - data.size()));
+                }
                 channel_->enableWriting();
             } else {
                 LOG_TRACE("TcpConnection fd={} sent all {} bytes directly", fd(), sent);
@@ -89,7 +111,7 @@ void TcpConnection::send(const std::string& data) {
             }
         } else {
             if (errno == EWOULDBLOCK || errno == EAGAIN) {
-                outputBuffer_.append(data);
+                outputBuffer_.append(data).append(more);
                 channel_->enableWriting();
             } else {
                 LOG_ERROR("send error fd={} errno={} msg={}", fd(), errno, strerror(errno));
@@ -97,7 +119,7 @@ void TcpConnection::send(const std::string& data) {
             }
         }
     } else {
-        outputBuffer_.append(data);
+        outputBuffer_.append(data).append(more);
         if (!channel_->isWriting()) {
             channel_->enableWriting();
         }
@@ -116,8 +138,8 @@ void TcpConnection::handleRead() {
                 auto self = shared_from_this();
                 messageCallback_(self, msg);
             }
-            // 判断是不是读完了
-            if (n < static_cast<ssize_t>(sizeof(buf))) {
+            // 判断是不是读完了（或上层在回调中暂停了读取）
+            if (n < static_cast<ssize_t>(sizeof(buf)) || !channel_->isReading()) {
                 break;
             }
             continue;
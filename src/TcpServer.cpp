@@ -4,6 +4,7 @@
 #include "EventLoop.hpp"
 #include "InetAddress.hpp"
 #include "Log.hpp"
+#include "Socket.hpp"
 #include "TcpConnection.hpp"
 
 namespace Server {
@@ -32,6 +33,12 @@ void TcpServer::start() {
 void TcpServer::newConnection(int sockfd, const InetAddress& peer) {
     (void) peer;  // 可扩展：记录或回调上层
     auto conn = std::make_shared<TcpConnection>(loop_, sockfd);
+    if (busyPollUsec_ > 0) {
+        conn->socket().setBusyPoll(busyPollUsec_);
+        if (preferBusyPoll_) {
+            conn->socket().setPreferBusyPoll();
+        }
+    }
     if (connectionCallback_) {
         conn->setConnectionCallback(connectionCallback_);
     }
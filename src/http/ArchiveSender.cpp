@@ -0,0 +1,332 @@
+#include "http/ArchiveSender.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include "EventLoop.hpp"
+#include "Log.hpp"
+#include "http/HttpResponse.hpp"
+#include "http/TarFormat.hpp"
+
+namespace Http {
+
+namespace {
+// 读出 fd 的前 size 字节
+bool readAll(int fd, uint64_t size, std::string& out) {
+    out.resize(size);
+    size_t done = 0;
+    while (done < size) {
+        const ssize_t n = ::pread(fd, out.data() + done, size - done, static_cast<off_t>(done));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;  // 读错误，或文件在读取期间被截短
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+constexpr char kZeros[kTarBlockSize] = {};
+}  // namespace
+
+ArchiveSender::Entry::~Entry() {
+    if (object.fd >= 0) {
+        ::close(object.fd);
+    }
+}
+
+ArchiveSender::ArchiveSender(Server::StorageEngine&                  engine,
+                             Server::DiskIoPool&                     pool,
+                             StorageBackend&                         backend,
+                             Server::TcpConnection::TcpConnectionPtr conn,
+                             NameSource                              source,
+                             ContentCoding                           coding,
+                             int                                     level)
+    : engine_(engine)
+    , pool_(pool)
+    , backend_(backend)
+    , conn_(std::move(conn))
+    , source_(std::move(source)) {
+    if (coding != ContentCoding::IDENTITY) {
+        deflater_ = std::make_unique<Deflater>(coding, level);
+    }
+}
+
+void ArchiveSender::start(std::string prefix, Done done) {
+    done_     = std::move(done);
+    starting_ = true;
+    raw_      = std::move(prefix);  // 与归档的第一块一起发出
+    pump();
+    starting_ = false;
+}
+
+void ArchiveSender::onWriteComplete() {
+    if (body_) {
+        auto body = body_;  // 发送可能就此结束并释放 body_
+        body->onWriteComplete();
+    } else if (paused_) {
+        paused_ = false;
+        pump();
+    }
+}
+
+void ArchiveSender::pump() {
+    if (finished_) {
+        return;
+    }
+    if (!conn_->connected()) {
+        finish(false);
+        return;
+    }
+    bool queued = true;
+    while (!body_ && !reading_ && !finished_) {
+        if (conn_->pendingBytes() > kHighWater) {
+            paused_ = true;  // 等发送缓冲清空
+            return;
+        }
+        if (current_) {
+            pumpBody();
+            continue;
+        }
+        queued  = openMore();
+        auto it = opened_.find(nextSeq_);
+        if (it == opened_.end()) {
+            break;
+        }
+        EntryPtr entry = std::move(it->second);
+        opened_.erase(it);
+        ++nextSeq_;
+        addEntry(std::move(entry));
+    }
+    if (finished_ || body_ || reading_) {
+        return;
+    }
+    if (issued_ > nextSeq_) {
+        flush(false);  // 等待打开完成，已生成的部分先发出
+        return;
+    }
+    if (!queued) {
+        // 没有在途的打开可以等待：归档已经开始，无法再改为 503
+        LOG_WARN("fd={} disk io queue full, archive aborted after {} files", conn_->fd(), files_);
+        finish(false);
+        return;
+    }
+    std::string trailer;
+    appendTarTrailer(trailer);
+    write(trailer);
+    if (deflater_ && !deflater_->finish(pending_)) {
+        LOG_ERROR("fd={} archive compression failed", conn_->fd());
+        finish(false);
+        return;
+    }
+    flush(true);
+    LOG_INFO("fd={} archive sent: {} files", conn_->fd(), files_);
+    finish(true);
+}
+
+bool ArchiveSender::openMore() {
+    while (issued_ - nextSeq_ < kOpenAhead) {
+        if (nameIndex_ == names_.size()) {
+            if (sourceDone_) {
+                return true;
+            }
+            names_.clear();
+            nameIndex_ = 0;
+            source_(names_);
+            sourceDone_ = names_.empty();
+            continue;
+        }
+        auto entry  = std::make_shared<Entry>();
+        entry->name = names_[nameIndex_];
+        // 已在内存中的对象不经过线程池
+        if (auto memory = backend_.cached(entry->name)) {
+            entry->found         = true;
+            entry->object.info   = {memory->size, memory->mtime, memory->etag};
+            entry->object.memory = std::move(memory);
+            opened_.emplace(issued_++, std::move(entry));
+            ++nameIndex_;
+            continue;
+        }
+        auto       self   = shared_from_this();
+        const bool queued = pool_.submit(
+            [self, entry]() {
+                Entry& e = *entry;
+                e.found  = self->backend_.open(e.name, e.object, e.ec);
+                if (e.found && e.object.fd >= 0 && e.object.info.size <= kInlineBytes) {
+                    if (!readAll(e.object.fd, e.object.info.size, e.data)) {
+                        e.found = false;
+                        e.ec.assign(errno != 0 ? errno : EIO, std::generic_category());
+                    }
+                    ::close(std::exchange(e.object.fd, -1));
+                }
+            },
+            [self, entry, seq = issued_]() {
+                if (!self->finished_) {
+                    self->opened_.emplace(seq, entry);
+                    self->pump();
+                }
+            });
+        if (!queued) {
+            return false;  // 某个在途的打开完成时再试
+        }
+        ++issued_;
+        ++nameIndex_;
+    }
+    return true;
+}
+
+void ArchiveSender::addEntry(EntryPtr entry) {
+    if (!entry->found) {
+        // 列出之后被删除，或读取失败：跳过该文件，归档其余部分照常生成
+        LOG_WARN("fd={} archive skips {}: {}", conn_->fd(), entry->name, entry->ec.message());
+        return;
+    }
+    auto&          object = entry->object;
+    const uint64_t size   = object.info.size;
+    std::string    header;
+    appendTarHeader(header, entry->name, size, object.info.mtime);
+    write(header);
+    ++files_;
+    if (object.fd < 0 && !object.memory) {
+        write(entry->data);  // 小文件已在打开时读出
+        endEntry(size);
+        return;
+    }
+    if (object.memory && size <= kInlineBytes) {
+        write({object.memory->data, size});
+        endEntry(size);
+        return;
+    }
+    if (deflater_) {
+        current_ = std::move(entry);  // 由 pumpBody 逐段压缩
+        bodyPos_ = 0;
+        return;
+    }
+    // 大文件单独成一块：块头随前面攒下的数据发出，正文由 FileSender 直接发送
+    std::string prefix;
+    takeChunk(prefix);
+    HttpResponse::appendChunkHeader(prefix, size);
+    if (object.memory) {
+        body_ = std::make_shared<FileSender>(engine_, conn_, std::move(object.memory), 0, size);
+    } else {
+        body_ =
+            std::make_shared<FileSender>(engine_, conn_, std::exchange(object.fd, -1), 0, size);
+    }
+    body_->start(std::move(prefix), [self = shared_from_this(), size](bool ok) {
+        self->onBodySent(ok);
+        if (ok) {
+            self->endEntry(size);
+            self->pump();
+        }
+    });
+}
+
+void ArchiveSender::pumpBody() {
+    const auto&    object = current_->object;
+    const uint64_t size   = object.info.size;
+    if (bodyPos_ == size) {
+        current_.reset();
+        endEntry(size);
+        return;
+    }
+    const auto length = static_cast<size_t>(
+        std::min<uint64_t>(size - bodyPos_, Server::StorageEngine::kChunkSize));
+    if (object.memory) {
+        write({object.memory->data + bodyPos_, length});
+        bodyPos_ += length;
+        return;
+    }
+    reading_ = true;
+    engine_.read(
+        object.fd, bodyPos_, length, [self = shared_from_this()](int err, std::string data) {
+            self->onBodyRead(err, std::move(data));
+        });
+}
+
+void ArchiveSender::onBodyRead(int err, std::string data) {
+    reading_ = false;
+    if (finished_) {
+        return;
+    }
+    if (err != 0 || data.empty()) {
+        LOG_ERROR("fd={} archive read of {} failed at {}: {}",
+                  conn_->fd(),
+                  current_->name,
+                  bodyPos_,
+                  err != 0 ? strerror(err) : "file ended early");
+        finish(false);
+        return;
+    }
+    bodyPos_ += data.size();
+    write(data);
+    pump();
+}
+
+void ArchiveSender::onBodySent(bool ok) {
+    body_.reset();
+    if (!ok) {
+        finish(false);
+        return;
+    }
+    raw_.append("\r\n");  // 结束正文所在的块
+}
+
+void ArchiveSender::endEntry(uint64_t size) {
+    write({kZeros, tarPadding(size)});
+}
+
+void ArchiveSender::write(std::string_view data) {
+    if (!deflater_) {
+        pending_.append(data);
+    } else if (!deflater_->update(data, pending_)) {
+        LOG_ERROR("fd={} archive compression failed", conn_->fd());
+        finish(false);
+        return;
+    }
+    if (pending_.size() >= kFlushBytes) {
+        flush(false);
+    }
+}
+
+void ArchiveSender::takeChunk(std::string& out) {
+    out.append(raw_);
+    raw_.clear();
+    HttpResponse::appendChunk(out, pending_);
+    pending_.clear();
+}
+
+void ArchiveSender::flush(bool last) {
+    std::string out;
+    takeChunk(out);
+    if (last) {
+        out.append(HttpResponse::kLastChunk);
+    }
+    if (!out.empty()) {
+        conn_->send(out);
+    }
+}
+
+void ArchiveSender::finish(bool ok) {
+    finished_ = true;
+    opened_.clear();
+    if (!done_) {
+        return;
+    }
+    auto done = std::move(done_);
+    done_     = nullptr;
+    if (starting_) {
+        // 调用方还在 start() 中（例如归档很小、一次写完），稍后再通知
+        conn_->getLoop()->queueInLoop(
+            [self = shared_from_this(), done = std::move(done), ok]() { done(ok); });
+        return;
+    }
+    done(ok);
+}
+
+}  // namespace Http
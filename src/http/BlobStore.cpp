@@ -0,0 +1,248 @@
+#include "http/BlobStore.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Log.hpp"
+#include "http/FileETag.hpp"
+
+namespace Http {
+
+namespace {
+constexpr size_t           kCompareChunk = 64 * 1024;
+constexpr std::string_view kLinkSuffix   = ".link";
+
+// 关闭时自动释放的只读 fd
+struct ReadOnlyFd {
+    explicit ReadOnlyFd(const std::filesystem::path& path)
+        : fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC)) {}
+    ~ReadOnlyFd() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+    ReadOnlyFd(const ReadOnlyFd&)            = delete;
+    ReadOnlyFd& operator=(const ReadOnlyFd&) = delete;
+
+    int fd;
+};
+
+bool readFully(int fd, char* buf, size_t size, off_t offset) {
+    while (size > 0) {
+        const ssize_t n = ::pread(fd, buf, size, offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        buf += n;
+        size -= static_cast<size_t>(n);
+        offset += n;
+    }
+    return true;
+}
+
+// 两个文件的前 size 字节是否相同；blob 的大小必须恰好是 size
+bool sameContent(const std::filesystem::path& file,
+                 const std::filesystem::path& blob,
+                 uint64_t                     size) {
+    ReadOnlyFd  a(file);
+    ReadOnlyFd  b(blob);
+    struct stat st{};
+    if (a.fd < 0 || b.fd < 0 || ::fstat(b.fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+        static_cast<uint64_t>(st.st_size) != size) {
+        return false;
+    }
+    std::vector<char> left(kCompareChunk);
+    std::vector<char> right(kCompareChunk);
+    for (uint64_t offset = 0; offset < size;) {
+        const size_t n = static_cast<size_t>(std::min<uint64_t>(kCompareChunk, size - offset));
+        if (!readFully(a.fd, left.data(), n, static_cast<off_t>(offset)) ||
+            !readFully(b.fd, right.data(), n, static_cast<off_t>(offset)) ||
+            std::memcmp(left.data(), right.data(), n) != 0) {
+            return false;
+        }
+        offset += n;
+    }
+    return true;
+}
+
+void syncDirectory(const std::filesystem::path& dir) {
+    const int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0 || ::fsync(fd) != 0) {
+        LOG_WARN("failed to sync directory {}: {}", dir.string(), strerror(errno));
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+}  // namespace
+
+BlobStore::BlobStore(std::filesystem::path dir) : dir_(std::move(dir)) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+    if (ec) {
+        LOG_WARN("failed to ensure blob dir {}: {}", dir_.string(), ec.message());
+        return;
+    }
+    sweep();
+}
+
+std::filesystem::path BlobStore::blobPath(uint64_t hash, uint64_t size) const {
+    char name[48];
+    std::snprintf(name, sizeof(name), "%016" PRIx64 "-%" PRIu64, hash, size);
+    return dir_ / name;
+}
+
+void BlobStore::sweep() {
+    size_t          blobs   = 0;
+    size_t          removed = 0;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir_, ec)) {
+        const std::filesystem::path& path = entry.path();
+        struct stat                  st{};
+        if (::lstat(path.c_str(), &st) != 0) {
+            continue;
+        }
+        // 名字在目录外被删除或替换后只剩这里的链接；临时链接是 rename 之前异常退出的遗留
+        if (!S_ISREG(st.st_mode) || st.st_nlink <= 1 || path.extension() == kLinkSuffix) {
+            std::error_code ignored;
+            std::filesystem::remove(path, ignored);
+            ++removed;
+            continue;
+        }
+        ++blobs;
+    }
+    LOG_INFO("blob store {}: {} blobs, {} unreferenced removed", dir_.string(), blobs, removed);
+}
+
+bool BlobStore::linkInto(const std::filesystem::path& blob,
+                         const std::filesystem::path& target,
+                         Durability                   durability) {
+    // 先在存储目录中建立临时链接，再 rename 覆盖 target：读者要么看到旧文件，要么看到新内容
+    std::filesystem::path link = blob;
+    link += "." + std::to_string(linkSeq_.fetch_add(1, std::memory_order_relaxed)) +
+            std::string{kLinkSuffix};
+    if (::link(blob.c_str(), link.c_str()) != 0) {
+        LOG_DEBUG("failed to link blob {}: {}", blob.string(), strerror(errno));
+        return false;  // 如 EMLINK：链接数到达上限，改为单独保存
+    }
+    std::error_code ec;
+    std::filesystem::rename(link, target, ec);
+    if (ec) {
+        LOG_DEBUG("failed to move blob link to {}: {}", target.string(), ec.message());
+        std::filesystem::remove(link, ec);
+        return false;
+    }
+    // target 已经是同一 inode 时 rename 什么都不做，临时链接仍在
+    std::filesystem::remove(link, ec);
+    if (durability == Durability::FULL) {
+        syncDirectory(target.parent_path());
+    }
+    return true;
+}
+
+bool BlobStore::commit(UploadFile&                  file,
+                       const std::filesystem::path& target,
+                       Durability                   durability,
+                       std::error_code&             ec) {
+    const uint64_t              size     = file.written();
+    const std::filesystem::path blob     = blobPath(file.digest(), size);
+    const std::filesystem::path previous = referenced(target);
+
+    // 已有内容已经按其提交时的保证落盘，命中时不必再 fdatasync；
+    // 写入失败的临时文件与边写边算的哈希不一致，比对失败后走正常提交并报告错误
+    if (sameContent(file.tempPath(), blob, size) && linkInto(blob, target, durability)) {
+        file.abort();
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        bytesSaved_.fetch_add(size, std::memory_order_relaxed);
+        LOG_DEBUG("upload {} deduplicated to {}", target.string(), blob.string());
+    } else {
+        if (!file.commit(target, durability, ec)) {
+            return false;
+        }
+        // EEXIST：并发提交了相同内容，或极少见的哈希碰撞，此文件单独保存。
+        // 存储中的条目丢失只会失去去重，不必 fsync 目录
+        if (::link(target.c_str(), blob.c_str()) == 0) {
+            created_.fetch_add(1, std::memory_order_relaxed);
+        } else if (errno != EEXIST) {
+            LOG_DEBUG("failed to add blob {}: {}", blob.string(), strerror(errno));
+        }
+    }
+    collect(previous);
+    return true;
+}
+
+void BlobStore::adopt(const std::filesystem::path& target, Durability durability) {
+    uint64_t    hash = 0;
+    struct stat st{};
+    {
+        ReadOnlyFd file(target);
+        if (file.fd < 0 || ::fstat(file.fd, &st) != 0 || !readFileHash(file.fd, st, hash)) {
+            return;  // 没有可信的哈希（如文件系统不支持扩展属性）：保持单独保存
+        }
+    }
+    const uint64_t              size = static_cast<uint64_t>(st.st_size);
+    const std::filesystem::path blob = blobPath(hash, size);
+    if (sameContent(target, blob, size)) {
+        if (linkInto(blob, target, durability)) {
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            bytesSaved_.fetch_add(size, std::memory_order_relaxed);
+        }
+        return;
+    }
+    if (::link(target.c_str(), blob.c_str()) == 0) {
+        created_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+std::filesystem::path BlobStore::referenced(const std::filesystem::path& target) const {
+    ReadOnlyFd  file(target);
+    struct stat st{};
+    uint64_t    hash = 0;
+    if (file.fd < 0 || ::fstat(file.fd, &st) != 0 || st.st_nlink < 2 ||
+        !readFileHash(file.fd, st, hash)) {
+        return {};
+    }
+    // 哈希只说明应当在哪里找；同一 inode 才是真正的引用
+    std::filesystem::path blob = blobPath(hash, static_cast<uint64_t>(st.st_size));
+    struct stat           blobSt{};
+    if (::stat(blob.c_str(), &blobSt) != 0 || blobSt.st_dev != st.st_dev ||
+        blobSt.st_ino != st.st_ino) {
+        return {};
+    }
+    return blob;
+}
+
+void BlobStore::collect(const std::filesystem::path& blob) {
+    struct stat st{};
+    if (blob.empty() || ::stat(blob.c_str(), &st) != 0 || st.st_nlink > 1) {
+        return;
+    }
+    // 与并发的 linkInto 竞争时，新名字仍持有 inode，只是这份内容此后不再参与去重
+    if (::unlink(blob.c_str()) == 0) {
+        collected_.fetch_add(1, std::memory_order_relaxed);
+        LOG_DEBUG("blob {} no longer referenced, removed", blob.string());
+    }
+}
+
+BlobStore::Stats BlobStore::stats() const {
+    Stats s;
+    s.hits       = hits_.load(std::memory_order_relaxed);
+    s.bytesSaved = bytesSaved_.load(std::memory_order_relaxed);
+    s.created    = created_.load(std::memory_order_relaxed);
+    s.collected  = collected_.load(std::memory_order_relaxed);
+    return s;
+}
+
+}  // namespace Http
@@ -0,0 +1,62 @@
+#include "http/ChunkedWriter.hpp"
+
+namespace Http {
+
+ChunkedWriter::ChunkedWriter(Server::TcpConnection::TcpConnectionPtr conn,
+                             HttpResponse                            head,
+                             bool                                    keepAlive,
+                             ContentCoding                           coding,
+                             int                                     level)
+    : conn_(std::move(conn)) {
+    if (coding != ContentCoding::IDENTITY) {
+        deflater_ = std::make_unique<Deflater>(coding, level);
+        head.setHeader(HeaderId::CONTENT_ENCODING, std::string{codingName(coding)});
+        head.setHeader(HeaderId::VARY, "Accept-Encoding");
+    }
+    head.setChunked();
+    head_ = head.serialize(keepAlive);
+}
+
+ChunkedWriter::~ChunkedWriter() {
+    finish();
+}
+
+void ChunkedWriter::write(std::string_view data) {
+    if (finished_) {
+        return;
+    }
+    if (deflater_) {
+        deflater_->update(data, pending_);
+    } else {
+        pending_.append(data);
+    }
+    if (pending_.size() >= kFlushThreshold) {
+        flush(false);
+    }
+}
+
+void ChunkedWriter::finish() {
+    if (finished_) {
+        return;
+    }
+    if (deflater_) {
+        deflater_->finish(pending_);
+    }
+    flush(true);
+    finished_ = true;
+}
+
+void ChunkedWriter::flush(bool last) {
+    std::string out = std::move(head_);
+    head_.clear();
+    HttpResponse::appendChunk(out, pending_);
+    pending_.clear();
+    if (last) {
+        out.append(HttpResponse::kLastChunk);
+    }
+    if (!out.empty()) {
+        conn_->send(out);
+    }
+}
+
+}  // namespace Http
@@ -0,0 +1,156 @@
+#include "http/Compression.hpp"
+
+#include <zlib.h>
+
+#include <cstdlib>
+
+#include "Log.hpp"
+#include "http/HttpHeaders.hpp"
+
+namespace Http {
+
+namespace {
+// windowBits：15 为 zlib 格式，加 16 输出 gzip 头尾
+constexpr int    kWindowBits  = 15;
+constexpr int    kGzipWrapper = 16;
+constexpr int    kMemLevel    = 8;
+constexpr size_t kOutputStep  = 16 * 1024;
+constexpr double kDefaultQ    = 1.0;
+
+std::string_view trim(std::string_view text) {
+    const size_t first = text.find_first_not_of(" \t");
+    if (first == std::string_view::npos) {
+        return {};
+    }
+    return text.substr(first, text.find_last_not_of(" \t") - first + 1);
+}
+
+// 解析 ";q=0.5" 之类的参数，缺省为 1
+double qualityOf(std::string_view params) {
+    while (!params.empty()) {
+        const size_t     semi  = params.find(';');
+        std::string_view param = trim(params.substr(0, semi));
+        params = semi == std::string_view::npos ? std::string_view{} : params.substr(semi + 1);
+        if (param.size() > 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=') {
+            const std::string value{param.substr(2)};
+            return std::strtod(value.c_str(), nullptr);
+        }
+    }
+    return kDefaultQ;
+}
+}  // namespace
+
+ContentCoding negotiateCoding(std::string_view acceptEncoding) {
+    double gzip     = -1;  // -1：未列出
+    double deflate  = -1;
+    double wildcard = -1;
+    while (!acceptEncoding.empty()) {
+        const size_t     comma = acceptEncoding.find(',');
+        std::string_view item  = acceptEncoding.substr(0, comma);
+        acceptEncoding         = comma == std::string_view::npos ? std::string_view{}
+                                                                 : acceptEncoding.substr(comma + 1);
+
+        const size_t           semi   = item.find(';');
+        const std::string_view coding = trim(item.substr(0, semi));
+        const double           q =
+            semi == std::string_view::npos ? kDefaultQ : qualityOf(item.substr(semi + 1));
+        if (detail::iequals(coding, "gzip") || detail::iequals(coding, "x-gzip")) {
+            gzip = q;
+        } else if (detail::iequals(coding, "deflate")) {
+            deflate = q;
+        } else if (coding == "*") {
+            wildcard = q;
+        }
+    }
+    if (gzip < 0) {
+        gzip = wildcard;
+    }
+    if (deflate < 0) {
+        deflate = wildcard;
+    }
+    if (gzip > 0 && gzip >= deflate) {
+        return ContentCoding::GZIP;
+    }
+    return deflate > 0 ? ContentCoding::DEFLATE : ContentCoding::IDENTITY;
+}
+
+std::string_view codingName(ContentCoding coding) {
+    switch (coding) {
+        case ContentCoding::GZIP:
+            return "gzip";
+        case ContentCoding::DEFLATE:
+            return "deflate";
+        case ContentCoding::IDENTITY:
+            break;
+    }
+    return {};
+}
+
+bool isCompressible(std::string_view contentType) {
+    const std::string_view type = contentType.substr(0, contentType.find(';'));
+    return type.rfind("text/", 0) == 0 || type == "application/json" ||
+           type == "application/javascript" || type == "application/xml" ||
+           type == "image/svg+xml";
+}
+
+Deflater::Deflater(ContentCoding coding, int level) : stream_(std::make_unique<z_stream>()) {
+    const int windowBits = coding == ContentCoding::GZIP ? kWindowBits + kGzipWrapper : kWindowBits;
+    const int rc =
+        ::deflateInit2(stream_.get(), level, Z_DEFLATED, windowBits, kMemLevel, Z_DEFAULT_STRATEGY);
+    ok_ = rc == Z_OK;
+    if (!ok_) {
+        LOG_ERROR("deflateInit2 failed (level {})", level);
+    }
+}
+
+Deflater::~Deflater() {
+    if (ok_) {
+        ::deflateEnd(stream_.get());
+    }
+}
+
+bool Deflater::update(std::string_view data, std::string& out) {
+    return run(data, Z_NO_FLUSH, out);
+}
+
+bool Deflater::finish(std::string& out) {
+    return run({}, Z_FINISH, out);
+}
+
+bool Deflater::run(std::string_view data, int flush, std::string& out) {
+    if (!ok_) {
+        return false;
+    }
+    z_stream& zs = *stream_;
+    zs.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    zs.avail_in  = static_cast<uInt>(data.size());
+    for (;;) {
+        const size_t used = out.size();
+        out.resize(used + kOutputStep);
+        zs.next_out  = reinterpret_cast<Bytef*>(out.data() + used);
+        zs.avail_out = static_cast<uInt>(kOutputStep);
+        const int rc = ::deflate(&zs, flush);
+        out.resize(used + kOutputStep - zs.avail_out);
+        if (rc == Z_STREAM_END) {
+            return true;
+        }
+        if (rc != Z_OK && rc != Z_BUF_ERROR) {
+            LOG_ERROR("deflate failed: {}", zs.msg != nullptr ? zs.msg : "unknown error");
+            ok_ = false;
+            ::deflateEnd(&zs);
+            return false;
+        }
+        // 输出空间未用完说明本轮输入已全部消化（Z_FINISH 须等到 Z_STREAM_END）
+        if (zs.avail_out != 0 && flush != Z_FINISH) {
+            return true;
+        }
+    }
+}
+
+bool compress(std::string_view in, ContentCoding coding, int level, std::string& out) {
+    out.reserve(out.size() + in.size() / 2);
+    Deflater deflater(coding, level);
+    return deflater.update(in, out) && deflater.finish(out);
+}
+
+}  // namespace Http
@@ -0,0 +1,154 @@
+#include "http/FileETag.hpp"
+
+#include <sys/xattr.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+
+#include "Log.hpp"
+#include "http/Hash64.hpp"
+
+namespace Http {
+
+namespace {
+constexpr const char* kETagAttr       = "user.fileserver.etag";
+constexpr size_t      kAttrBufSize    = 96;
+constexpr size_t      kReadChunk      = 256 * 1024;
+constexpr size_t      kMaxMemoEntries = 4096;
+
+// 扩展属性的内容："<hash hex> <size> <mtime 秒> <mtime 纳秒>"
+int formatAttr(char (&buf)[kAttrBufSize], uint64_t hash, const struct stat& st) {
+    return std::snprintf(buf,
+                         sizeof(buf),
+                         "%016" PRIx64 " %lld %lld %ld",
+                         hash,
+                         static_cast<long long>(st.st_size),
+                         static_cast<long long>(st.st_mtim.tv_sec),
+                         static_cast<long>(st.st_mtim.tv_nsec));
+}
+
+bool hashFile(int fd, uint64_t& hash) {
+    Hash64      hasher;
+    std::string buf(kReadChunk, '\0');
+    off_t       offset = 0;
+    for (;;) {
+        const ssize_t n = ::pread(fd, buf.data(), buf.size(), offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return false;
+        }
+        if (n == 0) {
+            break;
+        }
+        hasher.update({buf.data(), static_cast<size_t>(n)});
+        offset += n;
+    }
+    hash = hasher.digest();
+    return true;
+}
+
+struct MemoKey {
+    dev_t dev;
+    ino_t ino;
+    bool  operator==(const MemoKey& other) const {
+        return dev == other.dev && ino == other.ino;
+    }
+};
+struct MemoKeyHash {
+    size_t operator()(const MemoKey& key) const {
+        return std::hash<uint64_t>{}(static_cast<uint64_t>(key.ino) ^
+                                     (static_cast<uint64_t>(key.dev) << 32));
+    }
+};
+}  // namespace
+
+std::string formatETag(uint64_t hash) {
+    char buf[24];
+    std::snprintf(buf, sizeof(buf), "\"%016" PRIx64 "\"", hash);
+    return buf;
+}
+
+bool storeFileHash(int fd, uint64_t hash) {
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        return false;
+    }
+    char      attr[kAttrBufSize];
+    const int len = formatAttr(attr, hash, st);
+    if (::fsetxattr(fd, kETagAttr, attr, static_cast<size_t>(len), 0) != 0) {
+        LOG_DEBUG("fsetxattr {} failed: {}", kETagAttr, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool readFileHash(int fd, const struct stat& st, uint64_t& hash) {
+    char          stored[kAttrBufSize];
+    const ssize_t len = ::fgetxattr(fd, kETagAttr, stored, sizeof(stored) - 1);
+    if (len <= 0) {
+        return false;
+    }
+    stored[len] = '\0';
+    char expected[kAttrBufSize];
+    if (std::sscanf(stored, "%" SCNx64, &hash) != 1) {
+        return false;
+    }
+    formatAttr(expected, hash, st);
+    return std::string_view{stored} == expected;
+}
+
+std::string fileETag(int fd, const struct stat& st) {
+    uint64_t hash = 0;
+    return fileHash(fd, st, hash) ? formatETag(hash) : std::string{};
+}
+
+bool fileHash(int fd, const struct stat& st, uint64_t& hash) {
+    errno = 0;  // 区分 fgetxattr 失败与属性内容过期
+    if (readFileHash(fd, st, hash)) {
+        return true;
+    }
+    const bool xattrUnsupported = errno == ENOTSUP;
+
+    // 不支持扩展属性的文件系统：按 inode 记住结果，大小或 mtime 变化后重新计算
+    struct Memo {
+        off_t           size;
+        struct timespec mtime;
+        uint64_t        hash;
+    };
+    thread_local std::unordered_map<MemoKey, Memo, MemoKeyHash> memo;
+    const MemoKey                                               key{st.st_dev, st.st_ino};
+    if (xattrUnsupported) {
+        auto it = memo.find(key);
+        if (it != memo.end() && it->second.size == st.st_size &&
+            it->second.mtime.tv_sec == st.st_mtim.tv_sec &&
+            it->second.mtime.tv_nsec == st.st_mtim.tv_nsec) {
+            hash = it->second.hash;
+            return true;
+        }
+    }
+
+    if (!hashFile(fd, hash)) {
+        LOG_WARN("failed to hash file for ETag: {}", strerror(errno));
+        return false;
+    }
+    if (xattrUnsupported) {
+        if (memo.size() >= kMaxMemoEntries) {
+            memo.clear();
+        }
+        memo[key] = Memo{st.st_size, st.st_mtim, hash};
+    } else {
+        char      attr[kAttrBufSize];
+        const int attrLen = formatAttr(attr, hash, st);
+        ::fsetxattr(fd, kETagAttr, attr, static_cast<size_t>(attrLen), 0);  // 只读打开也可设置
+    }
+    return true;
+}
+
+}  // namespace Http
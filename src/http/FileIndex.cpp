@@ -0,0 +1,329 @@
+#include "http/FileIndex.hpp"
+
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+#include "Log.hpp"
+#include "http/HttpUtils.hpp"
+
+namespace Http {
+
+namespace {
+constexpr uint32_t kWatchMask = IN_CREATE | IN_CLOSE_WRITE | IN_ATTRIB | IN_DELETE | IN_MOVED_FROM |
+                                IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+constexpr size_t kEventBufSize = 4096;
+// 块的目标条目数；超过两倍时对半拆分
+constexpr size_t kBlockSize    = 256;
+}  // namespace
+
+FileIndex::FileIndex(Server::EventLoop* loop, std::filesystem::path dir)
+    : loop_(loop)
+    , dir_(std::move(dir))
+    , epoch_(static_cast<uint64_t>(
+          std::chrono::system_clock::now().time_since_epoch() / std::chrono::microseconds{1})) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+}
+
+void FileIndex::watch() {
+    inotifyFd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd_ < 0 || ::inotify_add_watch(inotifyFd_, dir_.c_str(), kWatchMask) < 0) {
+        LOG_WARN("inotify unavailable for {} ({}), external changes are not indexed",
+                 dir_.string(),
+                 strerror(errno));
+    } else {
+        inotifyChannel_ = std::make_unique<Server::Channel>(loop_, inotifyFd_);
+        inotifyChannel_->setReadCallback([this]() { this->handleInotify(); });
+        inotifyChannel_->enableReading();
+    }
+    // 先建立监视再扫描：扫描期间发生的改动会以事件形式再同步一次
+    rescan();
+}
+
+FileIndex::~FileIndex() {
+    if (inotifyChannel_) {
+        inotifyChannel_->disableAll();
+        inotifyChannel_->remove();
+    }
+    if (inotifyFd_ >= 0) {
+        ::close(inotifyFd_);
+    }
+}
+
+FileIndex::Item FileIndex::makeItem(std::string name, uint64_t size, std::time_t mtime) {
+    Item item{std::move(name), size, mtime, {}};
+    item.json.append("{\"name\":\"").append(escapeJson(item.name));
+    item.json.append("\",\"size\":").append(std::to_string(size));
+    item.json.append(",\"mtime\":").append(std::to_string(mtime)).append("}");
+    return item;
+}
+
+void FileIndex::rescan() {
+    std::vector<Entry> entries;
+    std::error_code    ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir_, ec)) {
+        struct stat st{};
+        if (::stat(entry.path().c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+            entries.push_back(
+                {entry.path().filename().string(), static_cast<uint64_t>(st.st_size), st.st_mtime});
+        }
+    }
+    if (ec) {
+        LOG_ERROR("failed to scan {}: {}", dir_.string(), ec.message());
+    }
+    load(std::move(entries));
+}
+
+void FileIndex::load(std::vector<Entry> entries) {
+    std::vector<Item> items;
+    items.reserve(entries.size());
+    for (auto& entry : entries) {
+        items.push_back(makeItem(std::move(entry.name), entry.size, entry.mtime));
+    }
+    std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+        return a.name < b.name;
+    });
+
+    blocks_.clear();
+    count_ = items.size();
+    for (size_t i = 0; i < items.size(); i += kBlockSize) {
+        Block block;
+        const size_t end = std::min(items.size(), i + kBlockSize);
+        block.items.assign(std::make_move_iterator(items.begin() + static_cast<ptrdiff_t>(i)),
+                           std::make_move_iterator(items.begin() + static_cast<ptrdiff_t>(end)));
+        blocks_.push_back(std::move(block));
+    }
+    ++generation_;
+    LOG_INFO("file index of {} loaded: {} files", dir_.string(), count_);
+    if (changeCallback_) {
+        changeCallback_("");
+    }
+}
+
+size_t FileIndex::findBlock(std::string_view name) const {
+    const auto it = std::lower_bound(
+        blocks_.begin(), blocks_.end(), name, [](const Block& block, std::string_view key) {
+            return block.items.back().name < key;
+        });
+    return it == blocks_.end() ? blocks_.size() - 1 : static_cast<size_t>(it - blocks_.begin());
+}
+
+void FileIndex::refresh(const std::string& name) {
+    struct stat st{};
+    if (name.empty() || ::stat((dir_ / name).c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        erase(name);
+        return;
+    }
+    update(name, static_cast<uint64_t>(st.st_size), st.st_mtime);
+}
+
+void FileIndex::update(const std::string& name, uint64_t size, std::time_t mtime) {
+    // 大小与 mtime 相同也可能是新内容（mtime 只精确到秒），一律通知
+    if (changeCallback_) {
+        changeCallback_(name);
+    }
+    upsert(makeItem(name, size, mtime));
+}
+
+void FileIndex::upsert(Item item) {
+    size_t index = 0;
+    if (blocks_.empty()) {
+        blocks_.emplace_back();  // 空块没有末项，不能交给 findBlock
+    } else {
+        index = findBlock(item.name);
+    }
+    Block& block = blocks_[index];
+    auto   pos   = std::lower_bound(
+        block.items.begin(), block.items.end(), item.name, [](const Item& a, const std::string& b) {
+            return a.name < b;
+        });
+    if (pos != block.items.end() && pos->name == item.name) {
+        if (pos->size == item.size && pos->mtime == item.mtime) {
+            return;  // 上传路径已更新过，随后到达的 inotify 事件无需再动
+        }
+        *pos = std::move(item);
+    } else {
+        block.items.insert(pos, std::move(item));
+        ++count_;
+    }
+    block.dirty = true;
+    ++generation_;
+
+    if (block.items.size() > 2 * kBlockSize) {
+        Block tail;
+        tail.items.assign(std::make_move_iterator(block.items.begin() + kBlockSize),
+                          std::make_move_iterator(block.items.end()));
+        block.items.resize(kBlockSize);
+        blocks_.insert(blocks_.begin() + static_cast<ptrdiff_t>(index) + 1, std::move(tail));
+    }
+}
+
+void FileIndex::erase(const std::string& name) {
+    if (changeCallback_ && !name.empty()) {
+        changeCallback_(name);
+    }
+    if (blocks_.empty()) {
+        return;
+    }
+    const size_t index = findBlock(name);
+    Block&       block = blocks_[index];
+    auto         pos   = std::lower_bound(
+        block.items.begin(), block.items.end(), name, [](const Item& a, const std::string& b) {
+            return a.name < b;
+        });
+    if (pos == block.items.end() || pos->name != name) {
+        return;
+    }
+    block.items.erase(pos);
+    block.dirty = true;
+    --count_;
+    ++generation_;
+    if (block.items.empty()) {
+        blocks_.erase(blocks_.begin() + static_cast<ptrdiff_t>(index));
+    }
+}
+
+size_t FileIndex::list(const Query& query, const Sink& sink, std::string& nextCursor) {
+    nextCursor.clear();
+    if (blocks_.empty() || query.limit == 0) {
+        return 0;
+    }
+    // 名字以 prefix 开头的条目在排序中连续，起点取 prefix 与 cursor 之后两者中较大的一个
+    const bool             afterCursor = !query.cursor.empty() && query.cursor >= query.prefix;
+    const std::string_view start       = afterCursor ? query.cursor : query.prefix;
+    auto matches = [&query](const Item& item) {
+        return std::string_view{item.name}.substr(0, query.prefix.size()) == query.prefix;
+    };
+
+    size_t             emitted = 0;
+    const std::string* last    = nullptr;  // 最后输出的文件名
+    for (size_t b = findBlock(start); b < blocks_.size(); ++b) {
+        Block& block = blocks_[b];
+        auto   pos   = block.items.begin();
+        if (emitted == 0) {
+            pos += static_cast<ptrdiff_t>(seek(block, start, afterCursor));
+        }
+        // 整块都在范围内：直接输出缓存的块 JSON
+        if (pos == block.items.begin() && query.limit - emitted >= block.items.size() &&
+            matches(block.items.back())) {
+            if (block.dirty) {
+                block.json.clear();
+                for (const auto& item : block.items) {
+                    block.json.append(block.json.empty() ? "" : ",").append(item.json);
+                }
+                block.dirty = false;
+            }
+            if (emitted > 0) {
+                sink(",");
+            }
+            sink(block.json);
+            emitted += block.items.size();
+            last = &block.items.back().name;
+            continue;
+        }
+        for (; pos != block.items.end(); ++pos) {
+            if (!matches(*pos)) {
+                return emitted;
+            }
+            if (emitted == query.limit) {
+                nextCursor = *last;  // 后面还有匹配条目
+                return emitted;
+            }
+            if (emitted > 0) {
+                sink(",");
+            }
+            sink(pos->json);
+            ++emitted;
+            last = &pos->name;
+        }
+    }
+    return emitted;
+}
+
+size_t FileIndex::names(const Query&              query,
+                        std::vector<std::string>& out,
+                        std::string&              nextCursor) const {
+    nextCursor.clear();
+    if (blocks_.empty() || query.limit == 0) {
+        return 0;
+    }
+    const bool             afterCursor = !query.cursor.empty() && query.cursor >= query.prefix;
+    const std::string_view start       = afterCursor ? query.cursor : query.prefix;
+    size_t                 emitted     = 0;
+    for (size_t b = findBlock(start); b < blocks_.size(); ++b) {
+        const auto& items = blocks_[b].items;
+        for (size_t i = emitted == 0 ? seek(blocks_[b], start, afterCursor) : 0; i < items.size();
+             ++i) {
+            if (std::string_view{items[i].name}.substr(0, query.prefix.size()) != query.prefix) {
+                return emitted;
+            }
+            if (emitted == query.limit) {
+                nextCursor = out.back();  // 后面还有匹配条目
+                return emitted;
+            }
+            out.push_back(items[i].name);
+            ++emitted;
+        }
+    }
+    return emitted;
+}
+
+size_t FileIndex::seek(const Block& block, std::string_view start, bool after) {
+    const auto& items = block.items;
+    const auto  pos   = after ? std::upper_bound(items.begin(),
+                                                 items.end(),
+                                                 start,
+                                                 [](std::string_view key, const Item& item) {
+                                                     return key < item.name;
+                                                 })
+                              : std::lower_bound(items.begin(),
+                                                 items.end(),
+                                                 start,
+                                                 [](const Item& item, std::string_view key) {
+                                                     return item.name < key;
+                                                 });
+    return static_cast<size_t>(pos - items.begin());
+}
+
+std::string FileIndex::etag() const {
+    char buf[48];
+    std::snprintf(buf, sizeof(buf), "W/\"%" PRIx64 "-%" PRIx64 "\"", epoch_, generation_);
+    return buf;
+}
+
+void FileIndex::handleInotify() {
+    alignas(inotify_event) char buf[kEventBufSize];
+    for (;;) {
+        const ssize_t n = ::read(inotifyFd_, buf, sizeof(buf));
+        if (n <= 0) {
+            break;  // EAGAIN：事件已读完
+        }
+        for (ssize_t off = 0; off < n;) {
+            const auto* ev = reinterpret_cast<const inotify_event*>(buf + off);
+            off += static_cast<ssize_t>(sizeof(inotify_event) + ev->len);
+
+            if ((ev->mask & IN_Q_OVERFLOW) != 0) {
+                LOG_WARN("inotify queue overflow, rescanning {}", dir_.string());
+                rescan();
+                continue;
+            }
+            if ((ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) != 0) {
+                LOG_ERROR("storage directory {} removed or moved", dir_.string());
+                continue;
+            }
+            if (ev->len > 0) {
+                refresh(std::string{ev->name});
+            }
+        }
+    }
+}
+
+}  // namespace Http
@@ -0,0 +1,232 @@
+#include "http/FileSender.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "EventLoop.hpp"
+#include "Log.hpp"
+
+namespace Http {
+
+FileSender::FileSender(Server::StorageEngine&                  engine,
+                       Server::TcpConnection::TcpConnectionPtr conn,
+                       int                                     fd,
+                       uint64_t                                offset,
+                       uint64_t                                length)
+    : FileSender(engine, std::move(conn), fd, {Part{{}, offset, length}}, {}) {}
+
+FileSender::FileSender(Server::StorageEngine&                  engine,
+                       Server::TcpConnection::TcpConnectionPtr conn,
+                       MappedFileCache::MappingPtr             mapping,
+                       uint64_t                                offset,
+                       uint64_t                                length)
+    : FileSender(engine, std::move(conn), std::move(mapping), {Part{{}, offset, length}}, {}) {}
+
+FileSender::FileSender(Server::StorageEngine&                  engine,
+                       Server::TcpConnection::TcpConnectionPtr conn,
+                       int                                     fd,
+                       std::vector<Part>                       parts,
+                       std::string                             trailer)
+    : engine_(engine)
+    , conn_(std::move(conn))
+    , fd_(fd)
+    , parts_(std::move(parts))
+    , trailer_(std::move(trailer)) {}
+
+FileSender::FileSender(Server::StorageEngine&                  engine,
+                       Server::TcpConnection::TcpConnectionPtr conn,
+                       MappedFileCache::MappingPtr             mapping,
+                       std::vector<Part>                       parts,
+                       std::string                             trailer)
+    : engine_(engine)
+    , conn_(std::move(conn))
+    , mapping_(std::move(mapping))
+    , parts_(std::move(parts))
+    , trailer_(std::move(trailer)) {}
+
+FileSender::~FileSender() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+void FileSender::start(std::string prefix, Done done) {
+    done_     = std::move(done);
+    starting_ = true;
+
+    const Part& first = parts_.front();
+    next_             = first.offset;
+    sendPos_          = first.offset;
+    end_              = first.offset + first.length;
+    prefix.append(first.head);
+    if (mapping_) {
+        prefix_ = std::move(prefix);  // 与第一段正文一起 writev
+    } else if (!prefix.empty()) {
+        conn_->send(prefix);
+    }
+    pump();
+    starting_ = false;
+}
+
+void FileSender::onWriteComplete() {
+    if (paused_) {
+        paused_ = false;
+        pump();
+    }
+}
+
+void FileSender::pump() {
+    if (finished_) {
+        return;
+    }
+    if (!conn_->connected()) {
+        finish(false);
+        return;
+    }
+    if (sendPos_ == end_ && !nextPart()) {
+        finish(true);
+        return;
+    }
+    if (chaining_ || paused_) {
+        return;
+    }
+    if (mapping_) {
+        pumpMapped();
+        return;
+    }
+    if (conn_->pendingBytes() > kHighWater) {
+        paused_ = true;  // 等发送缓冲清空
+        return;
+    }
+
+    auto self = shared_from_this();
+    if (inFlight_ == 0 && ready_.empty() && conn_->pendingBytes() == 0 && next_ < end_) {
+        const auto length = static_cast<size_t>(
+            std::min<uint64_t>(end_ - next_, kWindow * Server::StorageEngine::kChunkSize));
+        chaining_ = engine_.readToSocket(
+            fd_, next_, length, conn_->fd(), [self](int err, uint64_t sent, std::string rest) {
+                self->onChain(err, sent, rest);
+            });
+        if (chaining_) {
+            return;
+        }
+    }
+    while (inFlight_ < kWindow && next_ < end_) {
+        const uint64_t offset = next_;
+        const auto     length = static_cast<size_t>(
+            std::min<uint64_t>(end_ - next_, Server::StorageEngine::kChunkSize));
+        next_ += length;
+        ++inFlight_;
+        engine_.read(fd_, offset, length, [self, offset](int err, std::string data) {
+            self->onRead(offset, err, std::move(data));
+        });
+    }
+}
+
+void FileSender::pumpMapped() {
+    // 只在发送缓冲为空时写下一段：能直接写进套接字的部分不经过任何复制
+    while (conn_->pendingBytes() == 0 && conn_->connected()) {
+        if (sendPos_ == end_ && !nextPart()) {
+            finish(true);
+            return;
+        }
+        const auto length = static_cast<size_t>(std::min<uint64_t>(end_ - sendPos_, kHighWater));
+        const std::string_view body{mapping_->data + sendPos_, length};
+        sendPos_ += length;
+        std::string prefix;
+        prefix.swap(prefix_);
+        conn_->send(prefix, body);
+    }
+    if (!conn_->connected()) {
+        finish(false);
+    } else {
+        paused_ = true;  // 等发送缓冲清空
+    }
+}
+
+bool FileSender::nextPart() {
+    if (part_ + 1 == parts_.size()) {
+        if (!trailer_.empty()) {
+            std::string trailer;
+            trailer.swap(trailer_);
+            conn_->send(trailer);
+        }
+        return false;
+    }
+    const Part& part = parts_[++part_];
+    next_            = part.offset;
+    sendPos_         = part.offset;
+    end_             = part.offset + part.length;
+    // 上一个区间的数据都已交给连接，分段头紧随其后
+    if (mapping_) {
+        prefix_.append(part.head);
+    } else {
+        conn_->send(part.head);
+    }
+    return true;
+}
+
+void FileSender::onRead(uint64_t offset, int err, std::string data) {
+    --inFlight_;
+    if (finished_) {
+        return;
+    }
+    if (err != 0) {
+        LOG_ERROR("fd={} file read at {} failed: {}", conn_->fd(), offset, strerror(err));
+        finish(false);
+        return;
+    }
+    ready_.emplace(offset, std::move(data));
+    // 读请求可能乱序完成，只发送与已发送部分衔接的块
+    for (auto it = ready_.begin(); it != ready_.end() && it->first == sendPos_;
+         it      = ready_.erase(it)) {
+        sendPos_ += it->second.size();
+        conn_->send(it->second);
+    }
+    pump();
+}
+
+void FileSender::onChain(int err, uint64_t sent, const std::string& rest) {
+    chaining_ = false;
+    if (finished_) {
+        return;
+    }
+    if (err != 0) {
+        LOG_WARN("fd={} linked file send failed: {}", conn_->fd(), strerror(err));
+        finish(false);
+        return;
+    }
+    const uint64_t consumed = sent + rest.size();
+    if (consumed == 0) {
+        LOG_ERROR("fd={} file ended early at offset {}", conn_->fd(), next_);
+        finish(false);  // 文件在发送期间被截短
+        return;
+    }
+    next_ += consumed;
+    sendPos_ += consumed;
+    if (!rest.empty()) {
+        conn_->send(rest);  // 套接字暂时写不下：余下部分交给连接的发送缓冲
+    }
+    pump();
+}
+
+void FileSender::finish(bool ok) {
+    finished_ = true;
+    ready_.clear();
+    if (!done_) {
+        return;
+    }
+    auto done = std::move(done_);
+    done_     = nullptr;
+    if (starting_) {
+        // 调用方还在 start() 中（例如整个正文一次写完），稍后再通知
+        conn_->getLoop()->queueInLoop(
+            [self = shared_from_this(), done = std::move(done), ok]() { done(ok); });
+        return;
+    }
+    done(ok);
+}
+
+}  // namespace Http
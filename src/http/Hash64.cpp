@@ -0,0 +1,114 @@
+#include "http/Hash64.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace Http {
+
+namespace {
+constexpr uint64_t kPrime1 = 11400714785074694791ULL;
+constexpr uint64_t kPrime2 = 14029467366897019727ULL;
+constexpr uint64_t kPrime3 = 1609587929392839161ULL;
+constexpr uint64_t kPrime4 = 9650029242287828579ULL;
+constexpr uint64_t kPrime5 = 2870177450012600261ULL;
+
+constexpr uint64_t rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// 小端读取（x86/ARM Linux 均为小端，memcpy 会被编译为单条加载）
+uint64_t read64(const unsigned char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint32_t read32(const unsigned char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint64_t round(uint64_t acc, uint64_t input) {
+    acc += input * kPrime2;
+    acc = rotl(acc, 31);
+    return acc * kPrime1;
+}
+
+uint64_t mergeRound(uint64_t acc, uint64_t value) {
+    acc ^= round(0, value);
+    return acc * kPrime1 + kPrime4;
+}
+
+void consumeStripe(uint64_t (&acc)[4], const unsigned char* p) {
+    acc[0] = round(acc[0], read64(p));
+    acc[1] = round(acc[1], read64(p + 8));
+    acc[2] = round(acc[2], read64(p + 16));
+    acc[3] = round(acc[3], read64(p + 24));
+}
+}  // namespace
+
+Hash64::Hash64(uint64_t seed)
+    : seed_(seed), acc_{seed + kPrime1 + kPrime2, seed + kPrime2, seed, seed - kPrime1} {}
+
+void Hash64::update(std::string_view data) {
+    const auto* p   = reinterpret_cast<const unsigned char*>(data.data());
+    const auto* end = p + data.size();
+    total_ += data.size();
+
+    if (buffered_ > 0) {
+        const size_t take = std::min(kStripe - buffered_, data.size());
+        std::memcpy(buffer_ + buffered_, p, take);
+        buffered_ += take;
+        p += take;
+        if (buffered_ < kStripe) {
+            return;
+        }
+        consumeStripe(acc_, buffer_);
+        buffered_ = 0;
+    }
+    for (; end - p >= static_cast<std::ptrdiff_t>(kStripe); p += kStripe) {
+        consumeStripe(acc_, p);
+    }
+    buffered_ = static_cast<size_t>(end - p);
+    std::memcpy(buffer_, p, buffered_);
+}
+
+uint64_t Hash64::digest() const {
+    uint64_t h;
+    if (total_ >= kStripe) {
+        h = rotl(acc_[0], 1) + rotl(acc_[1], 7) + rotl(acc_[2], 12) + rotl(acc_[3], 18);
+        for (uint64_t acc : acc_) {
+            h = mergeRound(h, acc);
+        }
+    } else {
+        h = seed_ + kPrime5;
+    }
+    h += total_;
+
+    const unsigned char* p   = buffer_;
+    const unsigned char* end = buffer_ + buffered_;
+    for (; end - p >= 8; p += 8) {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * kPrime1 + kPrime4;
+    }
+    if (end - p >= 4) {
+        h ^= static_cast<uint64_t>(read32(p)) * kPrime1;
+        h = rotl(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= (*p) * kPrime5;
+        h = rotl(h, 11) * kPrime1;
+    }
+
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+}  // namespace Http
@@ -1,111 +1,432 @@
 #include "../../include/http/HttpParser.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <charconv>
 #include <string_view>
 
+#include "../../include/http/HttpScan.hpp"
+#include "../../include/http/HttpStatus.hpp"
+
 namespace Http {
 
+namespace {
+constexpr std::string_view kCrlf        = "\r\n";
+constexpr int              kHexBase     = 16;
+constexpr size_t           kMaxChunkLine = 1024;  // chunk-size 行（含扩展）的长度上限
+
+// 所有解析器缓冲中的字节总数与全局预算
+std::atomic<size_t> gBufferedBytes{0};
+std::atomic<size_t> gBufferBudget{0};
+
+bool isBlank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+bool iequals(std::string_view a, std::string_view b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+               return std::tolower(static_cast<unsigned char>(x)) ==
+                      std::tolower(static_cast<unsigned char>(y));
+           });
+}
+}  // namespace
+
+size_t HttpParser::findLineEnd() {
+    const std::string_view pending{recv_buff_.data() + base_, recv_buff_.size() - base_};
+    const auto             pos = scan::findCrlf(pending, scanPos_);
+    if (pos == std::string_view::npos) {
+        // 末尾可能是半个 CRLF，下次从最后一个字节继续，已扫描的部分不再重复扫描
+        scanPos_ = std::max(lineStart_, pending.empty() ? 0 : pending.size() - 1);
+    }
+    return pos;
+}
+
+std::string_view HttpParser::view(Span span) const {
+    return {recv_buff_.data() + base_ + span.offset, span.length};
+}
+
+std::string_view HttpParser::findHeader(HeaderId id) const {
+    for (const auto& header : headerSpans_) {
+        if (header.id == id) {
+            return view(header.value);
+        }
+    }
+    return {};
+}
+
+bool HttpParser::framingHeaders(const HeaderSpan*& transfer, const HeaderSpan*& length) const {
+    // 前后两级若各取不同的 Transfer-Encoding 或 Content-Length，会对 body 边界产生分歧：
+    // Transfer-Encoding 只能出现一次，多个 Content-Length 的值必须相同
+    for (const auto& header : headerSpans_) {
+        if (header.id == HeaderId::TRANSFER_ENCODING) {
+            if (transfer != nullptr) {
+                return false;
+            }
+            transfer = &header;
+        } else if (header.id == HeaderId::CONTENT_LENGTH) {
+            if (length != nullptr && view(length->value) != view(header.value)) {
+                return false;
+            }
+            length = &header;
+        }
+    }
+    return true;
+}
+
+void HttpParser::bindRequest() {
+    request_.method  = view(method_);
+    request_.path    = view(path_);
+    request_.version = view(version_);
+    request_.headers.clear();
+    for (const auto& header : headerSpans_) {
+        request_.headers.add(header.id, view(header.name), view(header.value));
+    }
+    request_.body = view({bodyStart_, bodyLength_});
+}
+
+void HttpParser::eraseRange(size_t offset, size_t length) {
+    recv_buff_.erase(base_ + offset, length);
+}
+
+size_t HttpParser::available(size_t from) const {
+    return recv_buff_.size() - base_ - from;
+}
+
+HttpParser::FeedState HttpParser::fail(int status) {
+    errorStatus_ = status;
+    state_       = HttpParseState::PARSE_ERROR;
+    return FeedState::ERROR;
+}
+
+size_t HttpParser::bodyLimit() const {
+    return bodySink_ ? limits_.maxStreamedBody : limits_.maxBufferedBody;
+}
+
+void HttpParser::updateAccounting() {
+    const size_t now = recv_buff_.size();
+    if (now >= accounted_) {
+        gBufferedBytes.fetch_add(now - accounted_, std::memory_order_relaxed);
+    } else {
+        gBufferedBytes.fetch_sub(accounted_ - now, std::memory_order_relaxed);
+    }
+    accounted_ = now;
+}
+
+size_t HttpParser::bufferedBytes() {
+    return gBufferedBytes.load(std::memory_order_relaxed);
+}
+
+void HttpParser::setBufferBudget(size_t bytes) {
+    gBufferBudget.store(bytes, std::memory_order_relaxed);
+}
+
+size_t HttpParser::bufferBudget() {
+    return gBufferBudget.load(std::memory_order_relaxed);
+}
+
+HttpParser::~HttpParser() {
+    recv_buff_.clear();
+    updateAccounting();
+}
+
+HttpParser::FeedState HttpParser::complete(size_t requestEnd) {
+    requestEnd_ = requestEnd;
+    bindRequest();
+    state_ = HttpParseState::REQUEST_COMPLETE;
+    return FeedState::COMPLETE;
+}
+
+// chunked body：chunk-size 行与 CRLF 等分帧字节解析后立即从缓冲删除，
+// 数据留在 [bodyStart_, chunkPos_) 中连续存放（即原地解码）；有 sink 时数据交给 sink 后也删除。
+HttpParser::FeedState HttpParser::parseChunked() {
+    while (true) {
+        if (state_ == HttpParseState::BODY_CHUNK_SIZE) {
+            lineStart_     = chunkPos_;
+            const auto end = findLineEnd();
+            if (end == std::string_view::npos) {
+                if (available(chunkPos_) > kMaxChunkLine) {
+                    return fail(StatusCode::kBadRequest);
+                }
+                return FeedState::NEED_MORE;
+            }
+            std::string_view line = view({chunkPos_, end - chunkPos_});
+            line                  = line.substr(0, line.find(';'));  // 忽略 chunk-ext
+            while (!line.empty() && isBlank(line.back())) {
+                line.remove_suffix(1);
+            }
+            size_t      size = 0;
+            const auto* last = line.data() + line.size();
+            auto [ptr, ec]   = std::from_chars(line.data(), last, size, kHexBase);
+            if (line.empty() || ec != std::errc{} || ptr != last) {
+                return fail(StatusCode::kBadRequest);
+            }
+            if (size > bodyLimit() - body_received) {
+                return fail(StatusCode::kPayloadTooLarge);
+            }
+            eraseRange(chunkPos_, end + kCrlf.size() - chunkPos_);
+            scanPos_ = chunkPos_;
+            if (size == 0) {
+                state_ = HttpParseState::BODY_TRAILERS;
+            } else {
+                chunkRemaining_ = size;
+                state_          = HttpParseState::BODY_CHUNK_DATA;
+            }
+        }
+
+        if (state_ == HttpParseState::BODY_CHUNK_DATA) {
+            const size_t n = std::min(available(chunkPos_), chunkRemaining_);
+            if (n == 0) {
+                return FeedState::NEED_MORE;
+            }
+            if (bodySink_) {
+                if (!bodySink_(view({chunkPos_, n}))) {
+                    return fail(StatusCode::kInternalServerError);
+                }
+                eraseRange(chunkPos_, n);
+            } else {
+                chunkPos_ += n;
+            }
+            body_received += n;
+            chunkRemaining_ -= n;
+            scanPos_ = chunkPos_;
+            if (chunkRemaining_ > 0) {
+                return FeedState::NEED_MORE;
+            }
+            state_ = HttpParseState::BODY_CHUNK_DATA_END;
+        }
+
+        if (state_ == HttpParseState::BODY_CHUNK_DATA_END) {
+            if (available(chunkPos_) < kCrlf.size()) {
+                return FeedState::NEED_MORE;
+            }
+            if (view({chunkPos_, kCrlf.size()}) != kCrlf) {
+                return fail(StatusCode::kBadRequest);
+            }
+            eraseRange(chunkPos_, kCrlf.size());
+            scanPos_ = chunkPos_;
+            state_   = HttpParseState::BODY_CHUNK_SIZE;
+            continue;
+        }
+
+        if (state_ == HttpParseState::BODY_TRAILERS) {
+            // trailer 字段目前不使用，逐行丢弃直到空行
+            lineStart_     = chunkPos_;
+            const auto end = findLineEnd();
+            if (end == std::string_view::npos) {
+                if (trailerBytes_ + available(chunkPos_) > limits_.maxHeaderBytes) {
+                    return fail(StatusCode::kRequestHeaderFieldsTooLarge);
+                }
+                return FeedState::NEED_MORE;
+            }
+            trailerBytes_ += end + kCrlf.size() - chunkPos_;
+            if (trailerBytes_ > limits_.maxHeaderBytes) {
+                return fail(StatusCode::kRequestHeaderFieldsTooLarge);
+            }
+            const bool last = end == chunkPos_;
+            eraseRange(chunkPos_, end + kCrlf.size() - chunkPos_);
+            scanPos_ = chunkPos_;
+            if (last) {
+                bodyLength_ = chunkPos_ - bodyStart_;
+                return complete(chunkPos_);
+            }
+            continue;
+        }
+        return FeedState::NEED_MORE;
+    }
+}
+
 HttpParser::FeedState HttpParser::feed(std::string_view data) {
-    recv_buff_.append(data.data(), data.size());
+    if (state_ == HttpParseState::PARSE_ERROR) {
+        return FeedState::ERROR;  // 出错后不再接收数据，等待调用方关闭连接
+    }
+    if (!data.empty()) {
+        if (base_ > 0) {
+            // 丢弃已处理完的请求：每个请求最多压缩一次
+            recv_buff_.erase(0, base_);
+            base_ = 0;
+        }
+        const size_t budget = gBufferBudget.load(std::memory_order_relaxed);
+        if (budget > 0 && gBufferedBytes.load(std::memory_order_relaxed) + data.size() > budget) {
+            fail(StatusCode::kServiceUnavailable);
+            updateAccounting();
+            return FeedState::ERROR;
+        }
+        recv_buff_.append(data.data(), data.size());
+    }
+    const FeedState state = parse();
+    updateAccounting();
+    return state;
+}
+
+HttpParser::FeedState HttpParser::parse() {
     if (state_ == HttpParseState::REQUEST_LINE_PENDING) {
-        auto pos = recv_buff_.find("\r\n");
-        if (pos == std::string::npos) {
+        const auto end = findLineEnd();
+        if (end == std::string_view::npos) {
+            if (available(lineStart_) > limits_.maxRequestLine) {
+                return fail(StatusCode::kUriTooLong);
+            }
             return FeedState::NEED_MORE;
         }
+        if (end - lineStart_ > limits_.maxRequestLine) {
+            return fail(StatusCode::kUriTooLong);
+        }
 
-        std::string_view request_line{recv_buff_.data(), pos};  // 使用视图来减少copy
+        const std::string_view request_line = view({lineStart_, end - lineStart_});
 
-        auto split1 = request_line.find(' ');
-        auto split2 =
-            (split1 == std::string::npos) ? std::string::npos : request_line.find(' ', split1 + 1);
-        if (split1 == std::string::npos || split2 == std::string::npos) {
-            return FeedState::ERROR;
+        // 方法名必须是 token，且紧跟一个空格
+        auto split1 = scan::findNonToken(request_line);
+        if (split1 == 0 || split1 == std::string_view::npos || request_line[split1] != ' ') {
+            return fail(StatusCode::kBadRequest);
         }
-        request_.method  = std::string{request_line.substr(0, split1)};
-        request_.path    = std::string{request_line.substr(split1 + 1, split2 - split1 - 1)};
-        request_.version = std::string{request_line.substr(split2 + 1)};
+        auto split2 = scan::findChar(request_line.substr(split1 + 1), ' ');
+        if (split2 == std::string_view::npos) {
+            return fail(StatusCode::kBadRequest);
+        }
+        split2 += split1 + 1;
+        method_  = {lineStart_, split1};
+        path_    = {lineStart_ + split1 + 1, split2 - split1 - 1};
+        version_ = {lineStart_ + split2 + 1, request_line.size() - split2 - 1};
 
-        recv_buff_.erase(0, pos + 2);
-        state_ = HttpParseState::HEADER_PENDING;
+        lineStart_   = end + kCrlf.size();
+        scanPos_     = lineStart_;
+        headerStart_ = lineStart_;
+        state_       = HttpParseState::HEADER_PENDING;
     }
 
     if (state_ == HttpParseState::HEADER_PENDING) {
         while (true) {
-            auto pos = recv_buff_.find("\r\n");
-            if (pos == std::string::npos) {
+            const auto end = findLineEnd();
+            if (end == std::string_view::npos) {
+                // 尚未出现 CRLF 的行同样计入头部大小，防止无限长的单行
+                if (available(headerStart_) > limits_.maxHeaderBytes) {
+                    return fail(StatusCode::kRequestHeaderFieldsTooLarge);
+                }
                 return FeedState::NEED_MORE;
             }
-            if (pos == 0) {
-                recv_buff_.erase(0, 2);
-                state_ = HttpParseState::HEADER_COMPLETE;
+            if (end + kCrlf.size() - headerStart_ > limits_.maxHeaderBytes) {
+                return fail(StatusCode::kRequestHeaderFieldsTooLarge);
+            }
+            if (end == lineStart_) {
+                lineStart_ = end + kCrlf.size();
+                scanPos_   = lineStart_;
+                state_     = HttpParseState::HEADER_COMPLETE;
                 break;
             }
 
-            std::string_view header_line{recv_buff_.data(), pos};
-            auto             split = header_line.find(':');
-            if (split == std::string_view::npos) {
-                return FeedState::ERROR;
+            const std::string_view header_line = view({lineStart_, end - lineStart_});
+            // 头部名必须是非空 token 且紧跟 ':'（RFC 9112 不允许名字与冒号间有空白）
+            const auto split = scan::findNonToken(header_line);
+            if (split == 0 || split == std::string_view::npos || header_line[split] != ':') {
+                return fail(StatusCode::kBadRequest);
+            }
+            if (headerSpans_.size() >= limits_.maxHeaderCount) {
+                return fail(StatusCode::kRequestHeaderFieldsTooLarge);
             }
-            std::string name{header_line.substr(0, split)};
-            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
 
             auto val_start = split + 1;
-            //  跳过:后的空格
-            while (val_start < header_line.size() &&
-                   (header_line[val_start] == ' ' || header_line[val_start] == '\t')) {
+            auto val_end   = header_line.size();
+            //  去掉值两侧的空白
+            while (val_start < val_end && isBlank(header_line[val_start])) {
                 ++val_start;
             }
-            std::string value{header_line.substr(val_start)};
+            while (val_end > val_start && isBlank(header_line[val_end - 1])) {
+                --val_end;
+            }
+            if (scan::findCtl(header_line.substr(val_start, val_end - val_start)) !=
+                std::string_view::npos) {
+                return fail(StatusCode::kBadRequest);
+            }
+            // 常用头部在此一次性映射为编号，之后的查找只比较编号
+            headerSpans_.push_back({headerId(header_line.substr(0, split)),
+                                    {lineStart_, split},
+                                    {lineStart_ + val_start, val_end - val_start}});
 
-            request_.headers[name] = std::move(value);
-            recv_buff_.erase(0, pos + 2);
+            lineStart_ = end + kCrlf.size();
+            scanPos_   = lineStart_;
         }
     }
 
     if (state_ == HttpParseState::HEADER_COMPLETE) {
         // 判断keep-alive
-        auto        connection_it = request_.headers.find("connection");
-        std::string conn_value =
-            (connection_it != request_.headers.end()) ? connection_it->second : "";
-
-        std::transform(conn_value.begin(), conn_value.end(), conn_value.begin(), ::tolower);
-        if (request_.version == "HTTP/1.1") {
+        const std::string_view conn_value = findHeader(HeaderId::CONNECTION);
+        if (view(version_) == "HTTP/1.1") {
             // HTTP/1.1 默认 keep-alive，除非显式关闭
-            keep_alive = (conn_value != "close");
+            keep_alive = !iequals(conn_value, "close");
         } else {
             // HTTP/1.0 默认关闭，除非显式 keep-alive
-            keep_alive = (conn_value == "keep-alive");
+            keep_alive = iequals(conn_value, "keep-alive");
         }
 
-        if (request_.headers.find("transfer-encoding") != request_.headers.end()) {
-            return FeedState::ERROR;  // 不支持 chunked
+        bodyStart_                 = lineStart_;
+        const HeaderSpan* transfer = nullptr;
+        const HeaderSpan* length   = nullptr;
+        if (!framingHeaders(transfer, length)) {
+            return fail(StatusCode::kBadRequest);
         }
-        //  content-length
-        auto content_length_it = request_.headers.find("content-length");
-        if (content_length_it != request_.headers.end()) {
-            try {
-                content_length = static_cast<size_t>(std::stoul(content_length_it->second));
-            } catch (...) {
-                return FeedState::ERROR;
+        if (transfer != nullptr) {
+            // 只支持单独的 chunked；与 Content-Length 同时出现有请求走私风险，直接拒绝
+            if (!iequals(view(transfer->value), "chunked") || length != nullptr) {
+                return fail(StatusCode::kBadRequest);
             }
+            chunked_  = true;
+            chunkPos_ = bodyStart_;
+            scanPos_  = chunkPos_;
+            state_    = HttpParseState::BODY_CHUNK_SIZE;
+        } else if (length != nullptr) {
+            // content-length：空值或非数字（包括 "5, 5" 这样的列表）都是错误
+            const std::string_view length_value = view(length->value);
+            const auto*            last         = length_value.data() + length_value.size();
+            auto [ptr, ec]   = std::from_chars(length_value.data(), last, content_length);
+            if (ec == std::errc::result_out_of_range) {
+                return fail(StatusCode::kPayloadTooLarge);
+            }
+            if (ec != std::errc{} || ptr != last) {
+                return fail(StatusCode::kBadRequest);
+            }
+            if (content_length == 0) {
+                return complete(bodyStart_);
+            }
+            state_ = HttpParseState::BODY_CONTENT_LENGTH;
         } else {
             //  无body
-            state_ = HttpParseState::REQUEST_COMPLETE;
-            return FeedState::COMPLETE;
+            return complete(bodyStart_);
         }
-
-        state_ = HttpParseState::BODY_CONTENT_LENGTH;
+        // 有 body：先把头部交给调用方，以便其决定是否流式接收
+        bindRequest();
+        return FeedState::HEADERS_COMPLETE;
     }
 
     if (state_ == HttpParseState::BODY_CONTENT_LENGTH) {
-        if (content_length > recv_buff_.size()) {
+        // 上限取决于 body 的去向：交给 sink 的流式 body 与缓冲在内存中的 body 分开限制
+        if (content_length > bodyLimit()) {
+            return fail(StatusCode::kPayloadTooLarge);
+        }
+        if (bodySink_) {
+            const size_t n = std::min(available(bodyStart_), content_length - body_received);
+            if (n > 0) {
+                if (!bodySink_(view({bodyStart_, n}))) {
+                    return fail(StatusCode::kInternalServerError);
+                }
+                eraseRange(bodyStart_, n);
+                body_received += n;
+            }
+            if (body_received < content_length) {
+                return FeedState::NEED_MORE;
+            }
+            return complete(bodyStart_);
+        }
+        if (content_length > available(bodyStart_)) {
             return FeedState::NEED_MORE;
         }
-        request_.body.assign(recv_buff_.data(), content_length);
-        recv_buff_.erase(0, content_length);
-        state_ = HttpParseState::REQUEST_COMPLETE;
-        return FeedState::COMPLETE;
+        body_received = content_length;
+        bodyLength_   = content_length;
+        return complete(bodyStart_ + content_length);
+    }
+
+    if (state_ == HttpParseState::BODY_CHUNK_SIZE || state_ == HttpParseState::BODY_CHUNK_DATA ||
+        state_ == HttpParseState::BODY_CHUNK_DATA_END || state_ == HttpParseState::BODY_TRAILERS) {
+        return parseChunked();
     }
     return FeedState::NEED_MORE;
 }
@@ -113,13 +434,43 @@ const HttpRequest& HttpParser::getRequest() const {
     return request_;
 }
 void HttpParser::resetParser(bool keepBuffer) {
-    state_         = HttpParseState::REQUEST_LINE_PENDING;
-    content_length = 0;
-    keep_alive     = false;
-    request_       = HttpRequest{};
     if (!keepBuffer) {
         recv_buff_.clear();
+        base_ = 0;
+    } else if (state_ == HttpParseState::REQUEST_COMPLETE) {
+        // 只移动起点，真正的压缩推迟到下一次追加数据时
+        base_ += requestEnd_;
+        if (base_ == recv_buff_.size()) {
+            recv_buff_.clear();
+            base_ = 0;
+        }
     }
+    state_          = HttpParseState::REQUEST_LINE_PENDING;
+    content_length  = 0;
+    body_received   = 0;
+    keep_alive      = false;
+    chunked_        = false;
+    lineStart_      = 0;
+    scanPos_        = 0;
+    bodyStart_      = 0;
+    bodyLength_     = 0;
+    chunkPos_       = 0;
+    chunkRemaining_ = 0;
+    requestEnd_     = 0;
+    headerStart_    = 0;
+    trailerBytes_   = 0;
+    errorStatus_    = 0;
+    method_         = {};
+    path_           = {};
+    version_        = {};
+    headerSpans_.clear();
+    bodySink_ = nullptr;
+    request_.method  = {};
+    request_.path    = {};
+    request_.version = {};
+    request_.headers.clear();
+    request_.body = {};
+    updateAccounting();
 }
 bool HttpParser::isKeepAlive() const {
     return keep_alive;
@@ -0,0 +1,147 @@
+#include "http/HttpRange.hpp"
+
+#include <algorithm>
+#include <charconv>
+
+namespace Http {
+
+namespace {
+constexpr std::string_view kBytesUnit        = "bytes=";
+constexpr std::string_view kContentRangeUnit = "bytes ";
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+// 整个字符串必须是十进制数
+bool parseNumber(std::string_view text, uint64_t& value) {
+    if (text.empty()) {
+        return false;
+    }
+    const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc{} && ptr == text.data() + text.size();
+}
+
+// 按起点排序，合并重叠、相邻或间隔小于 kRangePartOverhead 的区间（RFC 9110 §14.2）
+void coalesce(std::vector<ByteRange>& ranges) {
+    std::sort(ranges.begin(), ranges.end(), [](const ByteRange& a, const ByteRange& b) {
+        return a.first < b.first;
+    });
+    size_t out = 0;
+    for (size_t i = 1; i < ranges.size(); ++i) {
+        if (ranges[i].first <= ranges[out].last + kRangePartOverhead) {
+            ranges[out].last = std::max(ranges[out].last, ranges[i].last);
+        } else {
+            ranges[++out] = ranges[i];
+        }
+    }
+    ranges.resize(out + 1);
+}
+}  // namespace
+
+RangeResult parseRange(std::string_view header, uint64_t size, std::vector<ByteRange>& ranges) {
+    ranges.clear();
+    header = trim(header);
+    if (header.substr(0, kBytesUnit.size()) != kBytesUnit) {
+        return RangeResult::NONE;
+    }
+    header.remove_prefix(kBytesUnit.size());
+
+    size_t specs = 0;
+    while (!header.empty()) {
+        const auto       comma = header.find(',');
+        std::string_view spec  = trim(header.substr(0, comma));
+        header = comma == std::string_view::npos ? std::string_view{} : header.substr(comma + 1);
+        if (spec.empty()) {
+            continue;  // 允许 "0-1, ,2-3" 中的空元素
+        }
+        if (++specs > kMaxRanges) {
+            ranges.clear();
+            return RangeResult::NONE;
+        }
+
+        const auto dash = spec.find('-');
+        if (dash == std::string_view::npos) {
+            ranges.clear();
+            return RangeResult::NONE;
+        }
+        const std::string_view firstText = trim(spec.substr(0, dash));
+        const std::string_view lastText  = trim(spec.substr(dash + 1));
+        uint64_t               first     = 0;
+        uint64_t               last      = 0;
+        if (firstText.empty()) {
+            // 后缀区间 "-n"：最后 n 个字节
+            uint64_t suffix = 0;
+            if (!parseNumber(lastText, suffix)) {
+                ranges.clear();
+                return RangeResult::NONE;
+            }
+            if (suffix == 0 || size == 0) {
+                continue;
+            }
+            first = suffix >= size ? 0 : size - suffix;
+            last  = size - 1;
+        } else {
+            if (!parseNumber(firstText, first)) {
+                ranges.clear();
+                return RangeResult::NONE;
+            }
+            if (lastText.empty()) {
+                last = size == 0 ? 0 : size - 1;
+            } else if (!parseNumber(lastText, last) || last < first) {
+                ranges.clear();
+                return RangeResult::NONE;
+            }
+            if (first >= size) {
+                continue;  // 不可满足的区间，跳过
+            }
+            last = last >= size ? size - 1 : last;
+        }
+        ranges.push_back({first, last});
+    }
+
+    if (specs == 0) {
+        return RangeResult::NONE;
+    }
+    if (ranges.empty()) {
+        return RangeResult::UNSATISFIABLE;
+    }
+    if (specs > 1) {
+        coalesce(ranges);
+        // 合并后的各段连同分段头不比整个文件小：直接返回完整内容更省
+        uint64_t total = 0;
+        for (const auto& range : ranges) {
+            total += range.length() + kRangePartOverhead;
+        }
+        if (total >= size) {
+            ranges.clear();
+            return RangeResult::NONE;
+        }
+    }
+    return RangeResult::SATISFIABLE;
+}
+
+bool parseContentRange(std::string_view header, ByteRange& range, uint64_t& total) {
+    header = trim(header);
+    if (header.substr(0, kContentRangeUnit.size()) != kContentRangeUnit) {
+        return false;
+    }
+    header.remove_prefix(kContentRangeUnit.size());
+    const auto dash  = header.find('-');
+    const auto slash = header.find('/');
+    if (dash == std::string_view::npos || slash == std::string_view::npos || slash < dash) {
+        return false;
+    }
+    return parseNumber(trim(header.substr(0, dash)), range.first) &&
+           parseNumber(trim(header.substr(dash + 1, slash - dash - 1)), range.last) &&
+           parseNumber(trim(header.substr(slash + 1)), total) && range.first <= range.last &&
+           range.last < total;
+}
+
+}  // namespace Http
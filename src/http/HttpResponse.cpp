@@ -1,16 +1,71 @@
 #include "http/HttpResponse.hpp"
 
-#include <sstream>
+#include <algorithm>
+#include <charconv>
+#include <limits>
+
+#include "http/HttpStatus.hpp"
+#include "http/HttpUtils.hpp"
 
 namespace Http {
 
+namespace {
+constexpr int kHexBase = 16;
+// serializeTo 预留容量的估算：状态行 + 自动补充的头部，每个头部的 ": " 与 CRLF，
+// chunked 时的块大小行与 CRLF
+constexpr size_t kFixedHeadBytes = 160;
+constexpr size_t kFieldOverhead  = 4;
+constexpr size_t kChunkOverhead  = 24;
+
+void appendDecimal(std::string& out, size_t value) {
+    char       digits[std::numeric_limits<size_t>::digits10 + 1];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+}  // namespace
+
+void HttpResponse::setStatus(int code) {
+    statusCode_ = code;
+    reasonPhrase_.clear();
+}
+
 void HttpResponse::setStatus(int code, std::string reason) {
-    statusCode_   = code;
-    reasonPhrase_ = std::move(reason);
+    statusCode_ = code;
+    if (reason == reasonPhrase(code)) {
+        reasonPhrase_.clear();
+    } else {
+        reasonPhrase_ = std::move(reason);
+    }
 }
 
 void HttpResponse::setHeader(std::string key, std::string value) {
-    headers_[std::move(key)] = std::move(value);
+    const HeaderId id = headerId(key);
+    if (id != HeaderId::UNKNOWN) {
+        setHeader(id, std::move(value));
+        return;
+    }
+    for (auto& field : headers_) {
+        if (field.id == HeaderId::UNKNOWN && detail::iequals(field.name, key)) {
+            field.value = std::move(value);
+            return;
+        }
+    }
+    headers_.push_back({id, std::move(key), std::move(value)});
+}
+
+void HttpResponse::setHeader(HeaderId id, std::string value) {
+    for (auto& field : headers_) {
+        if (field.id == id) {
+            field.value = std::move(value);
+            return;
+        }
+    }
+    headers_.push_back({id, std::string{}, std::move(value)});
+}
+
+bool HttpResponse::hasHeader(HeaderId id) const {
+    return std::any_of(
+        headers_.begin(), headers_.end(), [id](const Field& field) { return field.id == id; });
 }
 
 void HttpResponse::setBody(std::string body) {
@@ -18,27 +73,121 @@ void HttpResponse::setBody(std::string body) {
 }
 
 void HttpResponse::setContentType(std::string mime) {
-    headers_["Content-Type"] = std::move(mime);
+    setHeader(HeaderId::CONTENT_TYPE, std::move(mime));
 }
 
 std::string HttpResponse::serialize(bool keepAlive) const {
-    std::ostringstream oss;
-    oss << "HTTP/1.1 " << statusCode_ << ' ' << reasonPhrase_ << "\r\n";
+    std::string out;
+    serializeTo(out, keepAlive);
+    return out;
+}
+
+void HttpResponse::serializeTo(std::string& out, bool keepAlive, bool negotiable) const {
+    serializeWith(out, keepAlive, body_, {}, negotiable);
+}
+
+void HttpResponse::serializeEncodedTo(std::string&     out,
+                                      bool             keepAlive,
+                                      std::string_view coding,
+                                      std::string_view encodedBody) const {
+    serializeWith(out, keepAlive, encodedBody, coding, true);
+}
 
-    if (headers_.find("Content-Length") == headers_.end()) {
-        oss << "Content-Length: " << body_.size() << "\r\n";
+std::string_view HttpResponse::header(HeaderId id) const {
+    for (const auto& field : headers_) {
+        if (field.id == id) {
+            return field.value;
+        }
+    }
+    return {};
+}
+
+void HttpResponse::serializeWith(std::string&     out,
+                                 bool             keepAlive,
+                                 std::string_view body,
+                                 std::string_view coding,
+                                 bool             negotiable) const {
+    size_t headerBytes = 0;
+    for (const auto& field : headers_) {
+        headerBytes += field.name.size() + field.value.size() + kFieldOverhead;
+    }
+    out.reserve(out.size() + kFixedHeadBytes + headerBytes + body.size() + kChunkOverhead);
+
+    const std::string_view line = reasonPhrase_.empty() ? statusLine(statusCode_) : "";
+    if (!line.empty()) {
+        out.append(line);
+    } else {
+        out.append("HTTP/1.1 ");
+        appendDecimal(out, static_cast<size_t>(statusCode_));
+        out.push_back(' ');
+        out.append(reasonPhrase_.empty() ? reasonPhrase(statusCode_) : reasonPhrase_);
+        out.append("\r\n");
     }
 
-    if (headers_.find("Connection") == headers_.end()) {
-        oss << "Connection: " << (keepAlive ? "keep-alive" : "close") << "\r\n";
+    // 304 不带消息体，也不发送 Content-Length（否则会被理解为表示的长度）
+    const bool bodyless = statusCode_ == StatusCode::kNotModified;
+    if (chunked_) {
+        out.append("Transfer-Encoding: chunked\r\n");
+    } else if (!bodyless && !hasHeader(HeaderId::CONTENT_LENGTH)) {
+        out.append("Content-Length: ");
+        appendDecimal(out, body.size());
+        out.append("\r\n");
+    }
+    if (!coding.empty()) {
+        out.append("Content-Encoding: ");
+        out.append(coding);
+        out.append("\r\n");
+    }
+    // 缓存须按 Accept-Encoding 区分压缩与未压缩的副本，两种结果都要带 Vary
+    if (negotiable && !hasHeader(HeaderId::VARY)) {
+        out.append("Vary: Accept-Encoding\r\n");
+    }
+    if (!hasHeader(HeaderId::CONNECTION)) {
+        appendConnection(out, keepAlive);
+    }
+    if (!hasHeader(HeaderId::DATE)) {
+        appendDate(out);
     }
 
-    for (const auto& [key, value] : headers_) {
-        oss << key << ": " << value << "\r\n";
+    for (const auto& field : headers_) {
+        out.append(field.id == HeaderId::UNKNOWN ? std::string_view{field.name}
+                                                 : headerName(field.id));
+        out.append(": ");
+        out.append(field.value);
+        out.append("\r\n");
+    }
+    out.append("\r\n");
+    if (chunked_) {
+        appendChunk(out, body);
+    } else if (!bodyless) {
+        out.append(body);
     }
-    oss << "\r\n";
-    oss << body_;
-    return oss.str();
+}
+
+void HttpResponse::appendConnection(std::string& out, bool keepAlive) {
+    out.append(keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n");
+}
+
+void HttpResponse::appendDate(std::string& out) {
+    out.append("Date: ");
+    out.append(httpDate());
+    out.append("\r\n");
+}
+
+void HttpResponse::appendChunk(std::string& out, std::string_view data) {
+    if (data.empty()) {
+        return;
+    }
+    appendChunkHeader(out, data.size());
+    out.append(data);
+    out.append("\r\n");
+}
+
+void HttpResponse::appendChunkHeader(std::string& out, uint64_t size) {
+    char       hex[sizeof(uint64_t) * 2];
+    const auto result = std::to_chars(hex, hex + sizeof(hex), size, kHexBase);
+    out.append(hex, result.ptr);
+    out.append("\r\n");
 }
 
 }  // namespace Http
@@ -0,0 +1,377 @@
+#include "http/HttpScan.hpp"
+
+#include <array>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <immintrin.h>
+#  define HTTP_SCAN_X86 1
+#endif
+
+namespace Http::scan {
+
+namespace {
+
+constexpr size_t kNpos = std::string_view::npos;
+
+constexpr bool isTchar(unsigned char c) {
+    if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+        return true;
+    }
+    switch (c) {
+        case '!':
+        case '#':
+        case '$':
+        case '%':
+        case '&':
+        case '\'':
+        case '*':
+        case '+':
+        case '-':
+        case '.':
+        case '^':
+        case '_':
+        case '`':
+        case '|':
+        case '~':
+            return true;
+        default:
+            return false;
+    }
+}
+
+constexpr bool isCtl(unsigned char c) {
+    return (c < 0x20 && c != '\t') || c == 0x7f;
+}
+
+// ---------------------------------------------------------------- 标量实现
+
+size_t findCrlfScalar(std::string_view data, size_t from) {
+    return data.find("\r\n", from);
+}
+
+size_t findCharScalar(std::string_view data, char c) {
+    return data.find(c);
+}
+
+size_t findNonTokenScalar(std::string_view data) {
+    for (size_t i = 0; i < data.size(); ++i) {
+        if (!isTchar(static_cast<unsigned char>(data[i]))) {
+            return i;
+        }
+    }
+    return kNpos;
+}
+
+size_t findCtlScalar(std::string_view data) {
+    for (size_t i = 0; i < data.size(); ++i) {
+        if (isCtl(static_cast<unsigned char>(data[i]))) {
+            return i;
+        }
+    }
+    return kNpos;
+}
+
+struct Kernels {
+    Kernel kind;
+    size_t (*findCrlf)(std::string_view, size_t);
+    size_t (*findChar)(std::string_view, char);
+    size_t (*findNonToken)(std::string_view);
+    size_t (*findCtl)(std::string_view);
+};
+
+constexpr Kernels kScalarKernels{
+    Kernel::SCALAR, findCrlfScalar, findCharScalar, findNonTokenScalar, findCtlScalar};
+
+#ifdef HTTP_SCAN_X86
+
+// 半字节查表分类（pshufb）：lo 表的第 h 位表示字符 (h << 4 | lo) 属于集合，
+// 只覆盖 0x00-0x7f，高位字节一律视为不在集合中。
+template <typename Pred>
+constexpr std::array<uint8_t, 16> nibbleTable(Pred pred) {
+    std::array<uint8_t, 16> table{};
+    for (unsigned lo = 0; lo < 16; ++lo) {
+        for (unsigned hi = 0; hi < 8; ++hi) {
+            if (pred(static_cast<unsigned char>((hi << 4) | lo))) {
+                table[lo] = static_cast<uint8_t>(table[lo] | (1U << hi));
+            }
+        }
+    }
+    return table;
+}
+
+constexpr auto kTcharTable = nibbleTable(isTchar);
+constexpr auto kCtlTable   = nibbleTable(isCtl);
+
+constexpr std::array<uint8_t, 16> kHiBitTable{
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0, 0, 0, 0, 0, 0, 0, 0};
+
+// 掩码中的每个 '\r' 候选都检查下一个字节；返回命中位置，或 npos 表示本块无命中
+inline size_t crlfFromMask(std::string_view data, size_t base, uint32_t mask) {
+    while (mask != 0) {
+        const size_t pos = base + static_cast<size_t>(__builtin_ctz(mask));
+        if (pos + 1 < data.size() && data[pos + 1] == '\n') {
+            return pos;
+        }
+        mask &= mask - 1;
+    }
+    return kNpos;
+}
+
+// ---------------------------------------------------------------- SSE4.2
+
+__attribute__((target("sse4.2"))) inline __m128i loadTable128(const std::array<uint8_t, 16>& t) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(t.data()));
+}
+
+// 返回块内"不在集合中"的字节掩码
+__attribute__((target("sse4.2"))) inline uint32_t outsideMask128(__m128i v,
+                                                                 __m128i loTable,
+                                                                 __m128i hiTable) {
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    const __m128i lo     = _mm_and_si128(v, nibble);
+    const __m128i hi     = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+    const __m128i hit =
+        _mm_and_si128(_mm_shuffle_epi8(loTable, lo), _mm_shuffle_epi8(hiTable, hi));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(hit, _mm_setzero_si128())));
+}
+
+__attribute__((target("sse4.2"))) size_t findCrlfSse42(std::string_view data, size_t from) {
+    const __m128i cr  = _mm_set1_epi8('\r');
+    size_t        pos = from;
+    for (; pos + 16 <= data.size(); pos += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data.data() + pos));
+        const auto    mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, cr)));
+        const size_t  hit  = crlfFromMask(data, pos, mask);
+        if (hit != kNpos) {
+            return hit;
+        }
+    }
+    return findCrlfScalar(data, pos);
+}
+
+__attribute__((target("sse4.2"))) size_t findCharSse42(std::string_view data, char c) {
+    const __m128i needle = _mm_set1_epi8(c);
+    size_t        pos    = 0;
+    for (; pos + 16 <= data.size(); pos += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data.data() + pos));
+        const int     mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, needle));
+        if (mask != 0) {
+            return pos + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+        }
+    }
+    const size_t tail = findCharScalar(data.substr(pos), c);
+    return tail == kNpos ? kNpos : pos + tail;
+}
+
+__attribute__((target("sse4.2"))) size_t findNonTokenSse42(std::string_view data) {
+    const __m128i loTable = loadTable128(kTcharTable);
+    const __m128i hiTable = loadTable128(kHiBitTable);
+    size_t        pos     = 0;
+    for (; pos + 16 <= data.size(); pos += 16) {
+        const __m128i  v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data.data() + pos));
+        const uint32_t mask = outsideMask128(v, loTable, hiTable);
+        if (mask != 0) {
+            return pos + static_cast<size_t>(__builtin_ctz(mask));
+        }
+    }
+    const size_t tail = findNonTokenScalar(data.substr(pos));
+    return tail == kNpos ? kNpos : pos + tail;
+}
+
+// 与 picohttpparser 相同，用 pcmpestri 的区间模式一次判断 16 字节
+__attribute__((target("sse4.2"))) size_t findCtlSse42(std::string_view data) {
+    alignas(16) static const char kRanges[16] = "\x00\x08\x0a\x1f\x7f\x7f";
+    const __m128i                 ranges = _mm_load_si128(reinterpret_cast<const __m128i*>(kRanges));
+    size_t                        pos    = 0;
+    for (; pos + 16 <= data.size(); pos += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data.data() + pos));
+        const int     idx = _mm_cmpestri(
+            ranges, 6, v, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_LEAST_SIGNIFICANT);
+        if (idx != 16) {
+            return pos + static_cast<size_t>(idx);
+        }
+    }
+    const size_t tail = findCtlScalar(data.substr(pos));
+    return tail == kNpos ? kNpos : pos + tail;
+}
+
+constexpr Kernels kSse42Kernels{
+    Kernel::SSE42, findCrlfSse42, findCharSse42, findNonTokenSse42, findCtlSse42};
+
+// ---------------------------------------------------------------- AVX2
+
+__attribute__((target("avx2"))) inline __m256i loadTable256(const std::array<uint8_t, 16>& t) {
+    return _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(t.data())));
+}
+
+__attribute__((target("avx2"))) inline uint32_t outsideMask256(__m256i v,
+                                                              __m256i loTable,
+                                                              __m256i hiTable) {
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    const __m256i lo     = _mm256_and_si256(v, nibble);
+    const __m256i hi     = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+    const __m256i hit =
+        _mm256_and_si256(_mm256_shuffle_epi8(loTable, lo), _mm256_shuffle_epi8(hiTable, hi));
+    return static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(hit, _mm256_setzero_si256())));
+}
+
+__attribute__((target("avx2"))) size_t findCrlfAvx2(std::string_view data, size_t from) {
+    const __m256i cr  = _mm256_set1_epi8('\r');
+    size_t        pos = from;
+    for (; pos + 32 <= data.size(); pos += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data.data() + pos));
+        const auto    mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, cr)));
+        const size_t  hit  = crlfFromMask(data, pos, mask);
+        if (hit != kNpos) {
+            return hit;
+        }
+    }
+    return findCrlfSse42(data, pos);
+}
+
+__attribute__((target("avx2"))) size_t findCharAvx2(std::string_view data, char c) {
+    const __m256i needle = _mm256_set1_epi8(c);
+    size_t        pos    = 0;
+    for (; pos + 32 <= data.size(); pos += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data.data() + pos));
+        const auto    mask =
+            static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, needle)));
+        if (mask != 0) {
+            return pos + static_cast<size_t>(__builtin_ctz(mask));
+        }
+    }
+    // 不足 32 字节的尾部交给 16 字节内核
+    const size_t tail = findCharSse42(data.substr(pos), c);
+    return tail == kNpos ? kNpos : pos + tail;
+}
+
+__attribute__((target("avx2"))) size_t findNonTokenAvx2(std::string_view data) {
+    const __m256i loTable = loadTable256(kTcharTable);
+    const __m256i hiTable = loadTable256(kHiBitTable);
+    size_t        pos     = 0;
+    for (; pos + 32 <= data.size(); pos += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data.data() + pos));
+        const uint32_t mask = outsideMask256(v, loTable, hiTable);
+        if (mask != 0) {
+            return pos + static_cast<size_t>(__builtin_ctz(mask));
+        }
+    }
+    const size_t tail = findNonTokenSse42(data.substr(pos));
+    return tail == kNpos ? kNpos : pos + tail;
+}
+
+__attribute__((target("avx2"))) size_t findCtlAvx2(std::string_view data) {
+    const __m256i loTable = loadTable256(kCtlTable);
+    const __m256i hiTable = loadTable256(kHiBitTable);
+    size_t        pos     = 0;
+    for (; pos + 32 <= data.size(); pos += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data.data() + pos));
+        // 取反：CTL 集合内的字节
+        const uint32_t mask = ~outsideMask256(v, loTable, hiTable);
+        if (mask != 0) {
+            return pos + static_cast<size_t>(__builtin_ctz(mask));
+        }
+    }
+    const size_t tail = findCtlSse42(data.substr(pos));
+    return tail == kNpos ? kNpos : pos + tail;
+}
+
+constexpr Kernels kAvx2Kernels{
+    Kernel::AVX2, findCrlfAvx2, findCharAvx2, findNonTokenAvx2, findCtlAvx2};
+
+#endif  // HTTP_SCAN_X86
+
+bool supported(Kernel kernel) {
+#ifdef HTTP_SCAN_X86
+    switch (kernel) {
+        case Kernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+        case Kernel::SSE42:
+            return __builtin_cpu_supports("sse4.2");
+        case Kernel::SCALAR:
+            return true;
+    }
+    return false;
+#else
+    return kernel == Kernel::SCALAR;
+#endif
+}
+
+const Kernels* kernelsFor(Kernel kernel) {
+#ifdef HTTP_SCAN_X86
+    switch (kernel) {
+        case Kernel::AVX2:
+            return &kAvx2Kernels;
+        case Kernel::SSE42:
+            return &kSse42Kernels;
+        case Kernel::SCALAR:
+            break;
+    }
+#else
+    (void) kernel;
+#endif
+    return &kScalarKernels;
+}
+
+const Kernels* detect() {
+    for (auto kernel : {Kernel::AVX2, Kernel::SSE42}) {
+        if (supported(kernel)) {
+            return kernelsFor(kernel);
+        }
+    }
+    return &kScalarKernels;
+}
+
+const Kernels*& current() {
+    static const Kernels* kernels = detect();
+    return kernels;
+}
+
+}  // namespace
+
+Kernel activeKernel() {
+    return current()->kind;
+}
+
+const char* kernelName(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::AVX2:
+            return "avx2";
+        case Kernel::SSE42:
+            return "sse4.2";
+        case Kernel::SCALAR:
+            break;
+    }
+    return "scalar";
+}
+
+bool setKernel(Kernel kernel) {
+    if (!supported(kernel)) {
+        return false;
+    }
+    current() = kernelsFor(kernel);
+    return true;
+}
+
+size_t findCrlf(std::string_view data, size_t from) {
+    if (from >= data.size()) {
+        return kNpos;
+    }
+    return current()->findCrlf(data, from);
+}
+
+size_t findChar(std::string_view data, char c) {
+    return current()->findChar(data, c);
+}
+
+size_t findNonToken(std::string_view data) {
+    return current()->findNonToken(data);
+}
+
+size_t findCtl(std::string_view data) {
+    return current()->findCtl(data);
+}
+
+}  // namespace Http::scan
@@ -1,12 +1,24 @@
 #include "http/HttpServer.hpp"
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <algorithm>
-#include <fstream>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <random>
 #include <sstream>
+#include <utility>
 #include <vector>
 
 #include "Log.hpp"
+#include "http/ChunkedWriter.hpp"
+#include "http/FileETag.hpp"
 #include "http/HttpParser.hpp"
+#include "http/HttpRange.hpp"
 #include "http/HttpRequest.hpp"
 #include "http/HttpResponse.hpp"
 #include "http/HttpStatus.hpp"
@@ -14,13 +26,394 @@
 
 namespace Http {
 
+namespace {
+// 文件数超过该值时 /api/files 改用 chunked 流式输出
+constexpr size_t kStreamListThreshold = 1024;
+// 输出批次缓冲在发送后保留的最大容量
+constexpr size_t kMaxRetainedOutput = 64 * 1024;
+// 静态资源缓存总容量；不超过该值的文件内容直接并入输出批次
+constexpr size_t kStaticCacheBytes = 64 * 1024 * 1024;
+constexpr size_t kInlineBodyLimit  = 16 * 1024;
+// 下载文件映射缓存的总容量
+constexpr size_t kMappedFileBytes = 256 * 1024 * 1024;
+// 磁盘线程池的线程数与排队上限
+constexpr size_t kDiskIoThreads  = 4;
+constexpr size_t kDiskIoMaxQueue = 1024;
+// 等待线程池期间暂存的输入超过该值时暂停读取，剩余数据留在内核缓冲区
+constexpr size_t kMaxStashedInput = 256 * 1024;
+// 超过该值的单区间/完整下载不在线程池中读出，由 FileSender 经存储引擎流式发送
+constexpr uint64_t kStreamDownloadBytes = Server::StorageEngine::kChunkSize;
+// 续传分片的路径前缀，其后为会话 id
+constexpr std::string_view kUploadSessionPrefix = "/api/uploads/";
+// 一个 multipart/form-data 请求中最多接受的文件数（每个文件占用一个 fd）
+constexpr size_t kMaxFormFiles = 64;
+// 按前缀打包下载时每次从索引取出的文件名数
+constexpr size_t kArchiveNameBatch = 256;
+
+// 从 offset 起读取 length 字节追加到 out（pread，不移动文件偏移）
+bool readFileRange(int fd, uint64_t offset, uint64_t length, std::string& out) {
+    const size_t start = out.size();
+    out.resize(start + length);
+    size_t done = 0;
+    while (done < length) {
+        const ssize_t n = ::pread(fd,
+                                  out.data() + start + done,
+                                  length - done,
+                                  static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            out.resize(start);
+            return false;  // 读错误，或文件在读取期间被截短
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+std::string contentRange(const ByteRange& range, uint64_t size) {
+    return "bytes " + std::to_string(range.first) + "-" + std::to_string(range.last) + "/" +
+           std::to_string(size);
+}
+
+std::string makeBoundary() {
+    thread_local std::mt19937_64 rng{std::random_device{}()};
+    char                         hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(rng()));
+    return std::string{"fsrange-"} + hex;
+}
+
+// 下载响应取决于的请求头，复制一份交给线程池（请求对象随即失效）
+struct DownloadConditions {
+    bool        hasRange{false};
+    std::string range;
+    std::string ifRange;
+    std::string ifNoneMatch;
+    std::string ifModifiedSince;
+};
+
+// 下载的处理结果。fd 有效，或 mapping 非空时，response 只是响应头，
+// 正文（parts 与 trailer）由 loop 线程从 fd 或映射流式发送
+struct DownloadPlan {
+    HttpResponse                  response;
+    int                           fd{-1};
+    MappedFileCache::MappingPtr   mapping;
+    std::vector<FileSender::Part> parts;
+    std::string                   trailer;
+    bool inMemory{false};  // mapping 是存储后端的内存对象，不放进 MappedFileCache
+
+    DownloadPlan() = default;
+    ~DownloadPlan() {
+        if (fd >= 0) {
+            ::close(fd);  // 连接在线程池完成前关闭，未被 FileSender 接管
+        }
+    }
+    DownloadPlan(const DownloadPlan&)            = delete;
+    DownloadPlan& operator=(const DownloadPlan&) = delete;
+};
+
+// 下载响应所依据的文件元数据：来自 fstat 与 fileETag，或来自已缓存的映射
+struct FileMeta {
+    uint64_t         size{0};
+    std::time_t      mtime{0};
+    std::string_view lastModified;
+    std::string_view etag;
+};
+
+enum class DownloadKind { NOT_MODIFIED, UNSATISFIABLE, FULL, SINGLE_RANGE, MULTI_RANGE };
+
+HttpResponse notFound(const char* body) {
+    HttpResponse resp;
+    resp.setStatus(StatusCode::kNotFound);
+    resp.setContentType("text/plain; charset=utf-8");
+    resp.setBody(body);
+    return resp;
+}
+
+HttpResponse plainText(int status, const char* body) {
+    HttpResponse resp;
+    resp.setStatus(status);
+    resp.setContentType("text/plain; charset=utf-8");
+    resp.setBody(body);
+    return resp;
+}
+
+HttpResponse jsonResponse(int status, std::string body) {
+    HttpResponse resp;
+    resp.setStatus(status);
+    resp.setContentType("application/json; charset=utf-8");
+    resp.setBody(std::move(body));
+    return resp;
+}
+
+// 存储失败的应答：空间不足回复 507，客户端可以区分于服务器内部错误
+HttpResponse storageFailure(bool noSpace, const char* body) {
+    return noSpace ? plainText(StatusCode::kInsufficientStorage, "Insufficient storage\n")
+                   : plainText(StatusCode::kInternalServerError, body);
+}
+
+// 写盘跟不上网络：暂停接收，在途写入回落后再恢复
+void throttle(UploadFile& upload, const std::weak_ptr<Server::TcpConnection>& weak) {
+    if (!upload.backlogged()) {
+        return;
+    }
+    if (auto conn = weak.lock()) {
+        conn->stopReading();
+    }
+    upload.onDrain([weak]() {
+        if (auto conn = weak.lock()) {
+            conn->startReading();
+        }
+    });
+}
+
+// 按条件请求与 Range 填写响应的状态与头部，正文由调用方按返回的类型生成。
+// 支持 Range/If-Range：单区间 206、多区间 multipart/byteranges、不可满足 416
+DownloadKind prepareDownload(const DownloadConditions& cond,
+                             const FileMeta&           meta,
+                             const std::string&        safeName,
+                             HttpResponse&             resp,
+                             std::vector<ByteRange>&   ranges) {
+    resp.setHeader(HeaderId::LAST_MODIFIED, std::string{meta.lastModified});
+    if (!meta.etag.empty()) {
+        resp.setHeader(HeaderId::ETAG, std::string{meta.etag});
+    }
+    if (notModified(cond.ifNoneMatch, cond.ifModifiedSince, meta.etag, meta.mtime)) {
+        resp.setStatus(StatusCode::kNotModified);
+        return DownloadKind::NOT_MODIFIED;
+    }
+    resp.setHeader(HeaderId::ACCEPT_RANGES, "bytes");
+    resp.setHeader(HeaderId::CONTENT_DISPOSITION, "attachment; filename=\"" + safeName + "\"");
+
+    // If-Range 与当前版本不符时忽略 Range，返回完整的新内容；ETag 按强比较
+    RangeResult rangeResult = RangeResult::NONE;
+    const bool  rangeValid  = cond.ifRange.empty() || cond.ifRange == meta.lastModified ||
+                            (!meta.etag.empty() && cond.ifRange == meta.etag);
+    if (cond.hasRange && rangeValid) {
+        rangeResult = parseRange(cond.range, meta.size, ranges);
+    }
+
+    if (rangeResult == RangeResult::UNSATISFIABLE) {
+        resp.setStatus(StatusCode::kRangeNotSatisfiable);
+        resp.setHeader(HeaderId::CONTENT_RANGE, "bytes */" + std::to_string(meta.size));
+        return DownloadKind::UNSATISFIABLE;
+    }
+    if (rangeResult == RangeResult::SATISFIABLE && ranges.size() == 1) {
+        resp.setStatus(StatusCode::kPartialContent);
+        resp.setContentType("application/octet-stream");
+        resp.setHeader(HeaderId::CONTENT_RANGE, contentRange(ranges.front(), meta.size));
+        return DownloadKind::SINGLE_RANGE;
+    }
+    if (rangeResult == RangeResult::SATISFIABLE) {
+        resp.setStatus(StatusCode::kPartialContent);
+        return DownloadKind::MULTI_RANGE;  // Content-Type 带分隔符，由 planMultipart 设置
+    }
+    resp.setStatus(StatusCode::kOk);
+    resp.setContentType("application/octet-stream");
+    return DownloadKind::FULL;
+}
+
+// 正文是文件的一个连续区间：补上 Content-Length，正文由 loop 线程从 fd 或映射发送
+void planSingle(HttpResponse& resp, uint64_t offset, uint64_t length, DownloadPlan& plan) {
+    resp.setHeader(HeaderId::CONTENT_LENGTH, std::to_string(length));
+    plan.parts.push_back({{}, offset, length});
+}
+
+// multipart/byteranges：每个区间一个分段，各自带 Content-Range。只生成分段头与结尾，
+// 区间内容由 FileSender 依次发送，不读进内存
+void planMultipart(HttpResponse&                 resp,
+                   const std::vector<ByteRange>& ranges,
+                   uint64_t                      size,
+                   DownloadPlan&                 plan) {
+    const std::string boundary = makeBoundary();
+    resp.setContentType("multipart/byteranges; boundary=" + boundary);
+    uint64_t length = 0;
+    for (const auto& range : ranges) {
+        FileSender::Part part;
+        part.head.append("\r\n--").append(boundary);
+        part.head.append("\r\nContent-Type: application/octet-stream\r\nContent-Range: ");
+        part.head.append(contentRange(range, size)).append("\r\n\r\n");
+        part.offset = range.first;
+        part.length = range.length();
+        length += part.head.size() + part.length;
+        plan.parts.push_back(std::move(part));
+    }
+    plan.trailer.append("\r\n--").append(boundary).append("--\r\n");
+    length += plan.trailer.size();
+    resp.setHeader(HeaderId::CONTENT_LENGTH, std::to_string(length));
+}
+
+// 在磁盘线程池中执行：从存储后端打开对象、处理条件请求与 Range 并读出内容，生成完整响应。
+// 超过 kStreamDownloadBytes 的单区间/完整响应与多区间响应只生成响应头，fd 留给 plan 流式发送；
+// 内存中的对象与大小适合映射的文件只取得映射（plan.mapping），
+// 响应回到 loop 线程后由 mappedDownload 生成
+void readDownload(int                       connFd,
+                  StorageBackend&           backend,
+                  const std::string&        safeName,
+                  const DownloadConditions& cond,
+                  const MappedFileCache&    mappedFiles,
+                  DownloadPlan&             plan) {
+    StorageBackend::Object object;
+    std::error_code        ec;
+    if (!backend.open(safeName, object, ec)) {
+        LOG_WARN("fd={} file not found for download: {} ({})", connFd, safeName, ec.message());
+        plan.response = notFound("File not found\n");
+        return;
+    }
+    if (object.memory) {
+        plan.mapping  = std::move(object.memory);
+        plan.inMemory = true;
+        return;
+    }
+    const int         fd    = object.fd;
+    const uint64_t    size  = object.info.size;
+    const std::time_t mtime = object.info.mtime;
+    std::string       etag  = std::move(object.info.etag);
+    if (mappedFiles.eligible(size)) {
+        plan.mapping = MappedFileCache::map(fd, size, mtime, etag, safeName);
+        if (plan.mapping) {
+            ::close(fd);  // 映射不依赖 fd
+            return;
+        }
+    }
+    char lastModified[kHttpDateLength];
+    formatHttpDate(mtime, lastModified);
+    const FileMeta meta{size, mtime, {lastModified, kHttpDateLength}, etag};
+
+    HttpResponse&          resp = plan.response;
+    std::vector<ByteRange> ranges;
+    const DownloadKind     kind = prepareDownload(cond, meta, safeName, resp, ranges);
+
+    std::string body;
+    bool        ok = true;
+    switch (kind) {
+        case DownloadKind::NOT_MODIFIED:
+            LOG_DEBUG("fd={} download not modified: {}", connFd, safeName);
+            break;
+        case DownloadKind::UNSATISFIABLE:
+            break;
+        case DownloadKind::FULL:
+        case DownloadKind::SINGLE_RANGE: {
+            const uint64_t offset = kind == DownloadKind::FULL ? 0 : ranges.front().first;
+            const uint64_t length = kind == DownloadKind::FULL ? size : ranges.front().length();
+            if (length > kStreamDownloadBytes) {
+                // 大的连续区间不读进内存，正文由 loop 线程经存储引擎发送
+                planSingle(resp, offset, length, plan);
+                plan.fd = fd;
+                LOG_INFO(
+                    "fd={} streaming file: {} ({} of {} bytes)", connFd, safeName, length, size);
+                return;
+            }
+            ok = readFileRange(fd, offset, length, body);
+            break;
+        }
+        case DownloadKind::MULTI_RANGE:
+            planMultipart(resp, ranges, size, plan);
+            plan.fd = fd;
+            LOG_INFO("fd={} streaming file: {} ({} ranges of {} bytes)",
+                     connFd,
+                     safeName,
+                     ranges.size(),
+                     size);
+            return;
+    }
+    ::close(fd);
+    if (kind == DownloadKind::NOT_MODIFIED || kind == DownloadKind::UNSATISFIABLE) {
+        return;
+    }
+
+    if (!ok) {
+        LOG_ERROR("fd={} failed to read {}: {}", connFd, safeName, strerror(errno));
+        HttpResponse error;
+        error.setStatus(StatusCode::kInternalServerError);
+        error.setContentType("text/plain; charset=utf-8");
+        error.setBody("Failed to read file\n");
+        resp = std::move(error);
+        return;
+    }
+    LOG_INFO("fd={} downloaded file: {} ({} of {} bytes, {} ranges)",
+             connFd,
+             safeName,
+             body.size(),
+             size,
+             ranges.size());
+    resp.setBody(std::move(body));
+}
+
+// 在 loop 线程按 plan.mapping 生成响应，不访问磁盘。较小的正文直接复制进响应，
+// 否则（以及多区间响应）保留映射并填写 parts，由 FileSender 从映射发送
+void mappedDownload(int                       connFd,
+                    const std::string&        safeName,
+                    const DownloadConditions& cond,
+                    DownloadPlan&             plan) {
+    const MappedFileCache::Mapping& mapping = *plan.mapping;
+
+    const FileMeta         meta{mapping.size, mapping.mtime, mapping.lastModified, mapping.etag};
+    HttpResponse&          resp = plan.response;
+    std::vector<ByteRange> ranges;
+    const DownloadKind     kind = prepareDownload(cond, meta, safeName, resp, ranges);
+
+    std::string body;
+    switch (kind) {
+        case DownloadKind::NOT_MODIFIED:
+            LOG_DEBUG("fd={} download not modified: {}", connFd, safeName);
+            plan.mapping.reset();
+            return;
+        case DownloadKind::UNSATISFIABLE:
+            plan.mapping.reset();
+            return;
+        case DownloadKind::FULL:
+        case DownloadKind::SINGLE_RANGE: {
+            const uint64_t offset = kind == DownloadKind::FULL ? 0 : ranges.front().first;
+            const uint64_t length =
+                kind == DownloadKind::FULL ? mapping.size : ranges.front().length();
+            if (length > kInlineBodyLimit) {
+                planSingle(resp, offset, length, plan);
+                LOG_INFO("fd={} serving mapped file: {} ({} of {} bytes)",
+                         connFd,
+                         safeName,
+                         length,
+                         mapping.size);
+                return;
+            }
+            body.assign(mapping.data + offset, length);
+            break;
+        }
+        case DownloadKind::MULTI_RANGE:
+            planMultipart(resp, ranges, mapping.size, plan);
+            LOG_INFO("fd={} serving mapped file: {} ({} ranges of {} bytes)",
+                     connFd,
+                     safeName,
+                     ranges.size(),
+                     mapping.size);
+            return;
+    }
+    LOG_INFO("fd={} downloaded mapped file: {} ({} of {} bytes, {} ranges)",
+             connFd,
+             safeName,
+             body.size(),
+             mapping.size,
+             ranges.size());
+    plan.mapping.reset();  // 正文已复制出来；之后不能再访问 mapping
+    resp.setBody(std::move(body));
+}
+}  // namespace
+
 HttpServer::HttpServer(Server::EventLoop*         loop,
                        const Server::InetAddress& listenAddr,
                        std::filesystem::path      storageDir,
                        std::filesystem::path      staticDir)
-    : server_(loop, listenAddr)
+    : loop_(loop)
+    , server_(loop, listenAddr)
     , storageDir_(std::move(storageDir))
-    , staticDir_(std::move(staticDir)) {
+    , staticDir_(std::move(staticDir))
+    , staticCache_(loop, std::filesystem::absolute(staticDir_), kStaticCacheBytes)
+    , mappedFiles_(kMappedFileBytes)
+    , fileIndex_(loop, std::filesystem::absolute(storageDir_))
+    , uploadSessions_(std::filesystem::absolute(storageDir_) / ".uploads")
+    , diskPool_(loop, kDiskIoThreads, kDiskIoMaxQueue)
+    , storage_(std::make_unique<Server::StorageEngine>(loop, &diskPool_)) {
     storageDir_ = std::filesystem::absolute(storageDir_);
     staticDir_  = std::filesystem::absolute(staticDir_);
 
@@ -36,14 +429,84 @@ HttpServer::HttpServer(Server::EventLoop*         loop,
         LOG_DEBUG("storage directory created/verified: {}", storageDir_.string());
     }
 
+    // 临时目录放在 storageDir_ 内部：rename 保证原子，且目录项不会出现在文件列表里
+    tempDir_ = storageDir_ / ".tmp";
+    std::filesystem::remove_all(tempDir_, ec);  // 清理上次异常退出遗留的半截上传
+    std::filesystem::create_directories(tempDir_, ec);
+    if (ec) {
+        LOG_WARN("failed to ensure upload temp dir {}: {}", tempDir_.string(), ec.message());
+    }
+
+    // 文件被重新上传、删除或在目录外被改动时丢弃其映射与内存副本（仍在发送的下载继续使用旧的）
+    fileIndex_.setChangeCallback([this](const std::string& name) {
+        mappedFiles_.invalidate(name);
+        if (backend_) {
+            backend_->invalidate(name);
+        }
+    });
+
+    registerRoutes();
+
     server_.setConnectionCallback(
         [this](const Server::TcpServer::TcpConnectionPtr& conn) { this->onConnection(conn); });
     server_.setMessageCallback([this](const Server::TcpServer::TcpConnectionPtr& conn,
                                       std::string& data) { this->onMessage(conn, data); });
+    server_.setWriteCompleteCallback([this](const Server::TcpServer::TcpConnectionPtr& conn) {
+        ConnectionContext* ctx = activeContext(conn);
+        if (ctx != nullptr && ctx->sender) {
+            auto sender = ctx->sender;  // 发送可能就此结束并释放 ctx->sender
+            sender->onWriteComplete();
+        } else if (ctx != nullptr && ctx->archive) {
+            auto archive = ctx->archive;
+            archive->onWriteComplete();
+        }
+    });
+}
+
+void HttpServer::setIoUring(bool enabled) {
+    storage_ = std::make_unique<Server::StorageEngine>(loop_, &diskPool_, enabled);
+}
+
+void HttpServer::buildBackend() {
+    if (memoryStorageBytes_ > 0) {
+        auto memory = std::make_unique<MemoryBackend>(memoryStorageBytes_);
+        memoryTier_ = memory.get();
+        backend_    = std::move(memory);
+        // 目录中已有的文件不属于内存存储，索引从空开始
+        LOG_INFO("files are kept in memory only ({} bytes)", memoryStorageBytes_);
+        return;
+    }
+    auto disk = std::make_unique<LocalDiskBackend>(
+        storageDir_,
+        dedup_ ? std::make_unique<BlobStore>(storageDir_ / ".blobs") : nullptr,
+        sharded_ ? std::make_unique<MetadataIndex>(storageDir_, storageDir_ / ".index") : nullptr);
+    blobs_ = disk->blobs();
+    if (const MetadataIndex* index = disk->index()) {
+        // 文件列表直接取自持久化的索引：不扫描目录，也不监视数千个分片目录
+        std::vector<FileIndex::Entry> entries;
+        entries.reserve(index->size());
+        index->forEach([&entries](const std::string& name, const MetadataIndex::Entry& entry) {
+            entries.push_back({name, entry.size, entry.mtime});
+        });
+        fileIndex_.load(std::move(entries));
+    } else {
+        fileIndex_.watch();
+    }
+    backend_ = std::move(disk);
+    if (hotTierBytes_ > 0) {
+        auto tier   = std::make_unique<MemoryBackend>(
+            hotTierBytes_, std::move(backend_), hotTierMaxObjectBytes_);
+        memoryTier_ = tier.get();
+        backend_    = std::move(tier);
+        LOG_INFO("in-memory hot tier enabled: {} bytes, objects up to {} bytes",
+                 hotTierBytes_,
+                 hotTierMaxObjectBytes_);
+    }
 }
 
 void HttpServer::start() {
     LOG_INFO("HttpServer starting...");
+    buildBackend();
     server_.start();
     LOG_INFO("HttpServer started successfully");
 }
@@ -52,7 +515,9 @@ void HttpServer::onConnection(const Server::TcpServer::TcpConnectionPtr& conn) {
     const int fd = conn->fd();
     auto      it = contexts_.find(fd);
     if (it == contexts_.end()) {
-        contexts_.emplace(fd, ConnectionContext{});
+        auto& ctx = contexts_.try_emplace(fd).first->second;
+        ctx.parser.setLimits(parserLimits_);
+        ctx.owner = conn.get();
         LOG_INFO("http connection fd={} established", fd);
     } else {
         contexts_.erase(it);
@@ -62,308 +527,1016 @@ void HttpServer::onConnection(const Server::TcpServer::TcpConnectionPtr& conn) {
 
 void HttpServer::onMessage(const Server::TcpServer::TcpConnectionPtr& conn, std::string& data) {
     LOG_TRACE("fd={} received {} bytes", conn->fd(), data.size());
-    auto& ctx    = contexts_[conn->fd()];
-    auto& parser = ctx.parser;
+    auto& ctx = contexts_[conn->fd()];
+    if (ctx.closing) {
+        return;  // 已回复错误并关闭写端，忽略对端后续数据
+    }
+    if (ctx.waiting) {
+        // 前一个请求还在线程池中，后续请求须排在它的响应之后
+        ctx.stashed.append(data);
+        if (ctx.stashed.size() > kMaxStashedInput) {
+            conn->stopReading();
+        }
+        return;
+    }
+    processInput(conn, ctx, data);
+}
 
-    auto state = parser.feed(data);
+void HttpServer::processInput(const Server::TcpServer::TcpConnectionPtr& conn,
+                              ConnectionContext&                         ctx,
+                              std::string_view                           data) {
+    auto& parser = ctx.parser;
+    auto  state  = ctx.closing ? HttpParser::FeedState::NEED_MORE : parser.feed(data);
     while (true) {
+        if (state == HttpParser::FeedState::HEADERS_COMPLETE) {
+            onHeaders(conn, ctx, parser.getRequest());
+            state = parser.feed("");  // 继续解析 body
+            continue;
+        }
         if (state == HttpParser::FeedState::COMPLETE) {
             const HttpRequest& req = parser.getRequest();
+            ctx.accept    = negotiateCoding(req.headers.get(HeaderId::ACCEPT_ENCODING));
+            ctx.keepAlive = parser.isKeepAlive();
             handleRequest(conn, req);
+            ++pipelineStats_.requests;
             parser.resetParser(true);
+            if (ctx.closing) {
+                break;  // 该响应带 Connection: close，后续流水线请求不再处理
+            }
+            if (ctx.waiting) {
+                break;  // 请求已交给线程池，完成后再继续解析缓冲中的后续请求
+            }
             state = parser.feed("");  // 继续尝试解析缓冲里的后续请求
             continue;
         }
         if (state == HttpParser::FeedState::ERROR) {
-            LOG_ERROR("HTTP parsing error on fd={}, closing connection", conn->fd());
-            conn->shutdown();
+            const int status = parser.errorStatus();
+            LOG_ERROR("HTTP parsing error on fd={} (status {}), closing connection",
+                      conn->fd(),
+                      status);
+            ++rejections_[status];
+            ctx.upload.abort();
+            ctx.chunk.reset();
+            ctx.form.reset();
+            ctx.closing = true;
+            HttpResponse resp;
+            resp.setStatus(status);
+            resp.setContentType("text/plain; charset=utf-8");
+            resp.setBody(std::string{reasonPhrase(status)} + "\n");
+            resp.serializeTo(ctx.output, false);
             break;
         }
         break;  // NEED_MORE
     }
-}
-void HttpServer::handleRequest(const Server::TcpServer::TcpConnectionPtr& conn,
-                               const HttpRequest&                         req) {
-    LOG_INFO("fd={} {} {}", conn->fd(), req.method, req.path);
-    LOG_DEBUG("fd={} request details: version={}, headers={}, body_size={}",
-              conn->fd(),
-              req.version,
-              req.headers.size(),
-              req.body.size());
 
-    if (req.method == "GET") {
-        handleGet(conn, req);
-    } else if (req.method == "POST") {
-        handlePost(conn, req);
-    } else if (req.method == "DELETE") {
-        handleDelete(conn, req);
-    } else {
-        LOG_WARN("fd={} unsupported HTTP method: {}", conn->fd(), req.method);
-        HttpResponse resp;
-        resp.setStatus(StatusCode::kMethodNotAllowed, "Method Not Allowed");
-        resp.setContentType("text/plain; charset=utf-8");
-        resp.setBody("Unsupported method\n");
-        conn->send(resp.serialize(false));
+    // 本次读到的所有请求的响应合并为一次写
+    flushOutput(conn, ctx);
+    if (ctx.closing) {
         conn->shutdown();
     }
 }
 
-void HttpServer::handleGet(const Server::TcpServer::TcpConnectionPtr& conn,
-                           const HttpRequest&                         req) {
-    const std::string cleanPath = stripQuery(req.path);
-    LOG_DEBUG("fd={} GET cleanPath={}", conn->fd(), cleanPath);
+bool HttpServer::offload(const Server::TcpServer::TcpConnectionPtr& conn,
+                         std::function<void()>                      work,
+                         std::function<void(ConnectionContext&)>    done) {
+    auto& ctx   = contexts_[conn->fd()];
+    ctx.waiting = true;
+    const bool queued =
+        diskPool_.submit(std::move(work), [this, conn, done = std::move(done)]() {
+            ConnectionContext* ctx = activeContext(conn);
+            if (ctx == nullptr) {
+                return;
+            }
+            ctx->waiting = false;
+            done(*ctx);
+            // done 中的发送出错会同步关闭连接；done 也可能又开始了异步发送（如大文件下载）
+            ctx = activeContext(conn);
+            if (ctx != nullptr && !ctx->waiting) {
+                resume(conn, *ctx);
+            }
+        });
+    if (queued) {
+        return true;
+    }
+    ctx.waiting = false;
+    LOG_WARN("fd={} disk io queue full, rejecting request", conn->fd());
+    HttpResponse resp;
+    resp.setStatus(StatusCode::kServiceUnavailable);
+    resp.setContentType("text/plain; charset=utf-8");
+    resp.setBody("Server busy\n");
+    sendResponse(conn, resp);
+    return false;
+}
 
-    if (cleanPath == "/" || cleanPath == "/index.html") {
-        LOG_DEBUG("fd={} serving index.html", conn->fd());
-        replyStaticFile(conn, "index.html");
-        return;
+ConnectionContext* HttpServer::activeContext(const Server::TcpServer::TcpConnectionPtr& conn) {
+    auto it = contexts_.find(conn->fd());
+    if (it == contexts_.end() || it->second.owner != conn.get()) {
+        return nullptr;  // 等待期间连接已关闭，fd 可能已被新连接复用
     }
+    return &it->second;
+}
+
+void HttpServer::resume(const Server::TcpServer::TcpConnectionPtr& conn, ConnectionContext& ctx) {
+    ctx.waiting = false;
+    std::string pending;
+    pending.swap(ctx.stashed);
+    conn->startReading();
+    processInput(conn, ctx, pending);
+}
 
-    // 获取文件列表
-    constexpr std::string_view prefix = "/api/files";
-    if (cleanPath == prefix) {
-        LOG_DEBUG("fd={} listing files", conn->fd());
-        replyFileList(conn);
+void HttpServer::streamFile(const Server::TcpServer::TcpConnectionPtr& conn,
+                            ConnectionContext&                         ctx,
+                            const HttpResponse&                        head,
+                            std::shared_ptr<FileSender>                sender) {
+    sendResponse(conn, head);
+    startSender(conn, ctx, std::move(sender));
+}
+
+void HttpServer::startSender(const Server::TcpServer::TcpConnectionPtr& conn,
+                             ConnectionContext&                         ctx,
+                             std::shared_ptr<FileSender>                sender) {
+    std::string prefix;
+    prefix.swap(ctx.output);  // 由 sender 发出，映射模式下与正文一起 writev
+    ++pipelineStats_.batches;
+    ctx.waiting = true;  // 正文发完之前，后续请求的响应不能插进来
+    ctx.sender  = sender;
+    // 发送出错会同步关闭连接（ctx 随之失效），此后不再访问 ctx
+    sender->start(std::move(prefix), [this, conn](bool ok) {
+        ConnectionContext* ctx = activeContext(conn);
+        if (ctx == nullptr) {
+            return;
+        }
+        ctx->sender.reset();
+        if (!ok) {
+            ctx->closing = true;  // 响应已不完整，只能关闭连接让客户端察觉
+        }
+        resume(conn, *ctx);
+    });
+}
+
+void HttpServer::streamArchive(const Server::TcpServer::TcpConnectionPtr& conn,
+                               ConnectionContext&                         ctx,
+                               const HttpResponse&                        head,
+                               std::shared_ptr<ArchiveSender>             archive) {
+    sendResponse(conn, head);
+    std::string prefix;
+    prefix.swap(ctx.output);  // 与归档的第一块一起发出
+    ++pipelineStats_.batches;
+    ctx.waiting = true;
+    ctx.archive = archive;
+    archive->start(std::move(prefix), [this, conn](bool ok) {
+        ConnectionContext* ctx = activeContext(conn);
+        if (ctx == nullptr) {
+            return;
+        }
+        ctx->archive.reset();
+        if (!ok) {
+            ctx->closing = true;
+        }
+        resume(conn, *ctx);
+    });
+}
+
+void HttpServer::sendResponse(const Server::TcpServer::TcpConnectionPtr& conn,
+                              const HttpResponse&                        resp) {
+    auto&      ctx       = contexts_[conn->fd()];
+    const bool keepAlive = !ctx.closing && ctx.keepAlive;
+    // 不论客户端这次是否接受压缩，可协商的响应都带 Vary，以免共享缓存混用两种副本
+    const bool negotiable = compression_.level > 0 && resp.status() == StatusCode::kOk &&
+                            resp.body().size() >= compression_.minBytes &&
+                            resp.header(HeaderId::CONTENT_ENCODING).empty() &&
+                            isCompressible(resp.header(HeaderId::CONTENT_TYPE));
+    if (negotiable && ctx.accept != ContentCoding::IDENTITY) {
+        std::string encoded;
+        if (compress(resp.body(), ctx.accept, compression_.level, encoded) &&
+            encoded.size() < resp.body().size()) {
+            resp.serializeEncodedTo(ctx.output, keepAlive, codingName(ctx.accept), encoded);
+            ctx.closing = !keepAlive;
+            return;
+        }
+    }
+    resp.serializeTo(ctx.output, keepAlive, negotiable);
+    ctx.closing = !keepAlive;
+}
+
+void HttpServer::flushOutput(const Server::TcpServer::TcpConnectionPtr& conn,
+                             ConnectionContext&                         ctx) {
+    if (ctx.output.empty()) {
+        return;
+    }
+    conn->send(ctx.output);
+    ++pipelineStats_.batches;
+    if (ctx.output.capacity() > kMaxRetainedOutput) {
+        std::string{}.swap(ctx.output);  // 大响应（如文件下载）之后不长期占用内存
+    } else {
+        ctx.output.clear();
+    }
+}
+void HttpServer::onHeaders(const Server::TcpServer::TcpConnectionPtr& conn,
+                           ConnectionContext&                         ctx,
+                           const HttpRequest&                         req) {
+    if (req.headers.get(HeaderId::EXPECT) == "100-continue") {
+        // 客户端（curl -T 等）在发送 body 前等待确认；排在此前请求的响应之后立即发出
+        ctx.output.append("HTTP/1.1 100 Continue\r\n\r\n");
+        flushOutput(conn, ctx);
+    }
+    const std::string_view path = stripQuery(req.path);
+    if (req.method == "PUT" &&
+        path.substr(0, kUploadSessionPrefix.size()) == kUploadSessionPrefix) {
+        openUploadChunk(conn, ctx, req, path.substr(kUploadSessionPrefix.size()));
         return;
     }
-    // 获取具体文件
-    if (cleanPath.rfind(prefix, 0) == 0 && cleanPath.size() > prefix.size() + 1) {
-        const std::string name = cleanPath.substr(prefix.size() + 1);
-        LOG_DEBUG("fd={} downloading file: {}", conn->fd(), name);
-        replyDownload(conn, name);
+    if (req.method != "POST" || path != "/api/files") {
+        return;  // 其他请求的 body 很小，照常缓冲
+    }
+    const std::string boundary =
+        MultipartParser::boundaryOf(req.headers.get(HeaderId::CONTENT_TYPE));
+    if (!boundary.empty()) {
+        openFormUpload(conn, ctx, boundary);
         return;
     }
 
-    LOG_WARN("fd={} GET path not found: {}", conn->fd(), cleanPath);
-    HttpResponse resp;
-    resp.setStatus(StatusCode::kNotFound, "Not Found");
-    resp.setContentType("text/plain; charset=utf-8");
-    resp.setBody("Resource not found\n");
-    conn->send(resp.serialize(true));
-    auto& ctx    = contexts_[conn->fd()];
-    auto& parser = ctx.parser;
-    if (!parser.isKeepAlive()) {
-        conn->shutdown();
+    // 上传：body 直接写入临时文件，内存占用与文件大小无关
+    const std::string safeName =
+        sanitizeFilename(urlDecode(req.headers.get(HeaderId::X_FILENAME)));
+    // 已知长度（解析器已校验 Content-Length）时按它预分配；chunked 上传大小未知
+    uint64_t expectedSize = 0;
+    if (!ctx.parser.isChunked()) {
+        const std::string_view length = req.headers.get(HeaderId::CONTENT_LENGTH);
+        std::from_chars(length.data(), length.data() + length.size(), expectedSize);
+    }
+    if (safeName.empty() ||
+        !ctx.upload.open(tempDir_, safeName, storage_.get(), expectedSize)) {
+        // 请求注定失败（handleUpload 负责回复错误），丢弃 body 而不是缓冲它
+        ctx.parser.setBodySink([](std::string_view) { return true; });
+        return;
+    }
+    LOG_DEBUG("fd={} streaming upload of {} to disk", conn->fd(), safeName);
+    streamBody(conn, ctx);
+}
+
+void HttpServer::openUploadChunk(const Server::TcpServer::TcpConnectionPtr& conn,
+                                 ConnectionContext&                         ctx,
+                                 const HttpRequest&                         req,
+                                 std::string_view                           id) {
+    // 分片必须带 Content-Length 且与区间长度一致，写入不会越过声明的区间
+    const auto             session = uploadSessions_.find(id);
+    const std::string_view contentLength = req.headers.get(HeaderId::CONTENT_LENGTH);
+    ByteRange              range;
+    uint64_t               total  = 0;
+    uint64_t               length = 0;
+    std::from_chars(contentLength.data(), contentLength.data() + contentLength.size(), length);
+    const bool valid = session && !session->closed && !ctx.parser.isChunked() &&
+                       parseContentRange(req.headers.get(HeaderId::CONTENT_RANGE), range, total) &&
+                       total == session->size && length == range.length();
+    if (!valid || !ctx.upload.openRange(session->fd, range.first, storage_.get())) {
+        // handleUploadChunk 负责回复错误，丢弃 body
+        ctx.parser.setBodySink([](std::string_view) { return true; });
+        return;
     }
+    ctx.chunk = std::make_shared<UploadSessions::Writer>(session, range.first, range.last + 1);
+    LOG_DEBUG("fd={} receiving bytes {}-{} of upload session {}",
+              conn->fd(),
+              range.first,
+              range.last,
+              session->id);
+    streamBody(conn, ctx);
 }
 
-void HttpServer::handlePost(const Server::TcpServer::TcpConnectionPtr& conn,
-                            const HttpRequest&                         req) {
-    const std::string cleanPath = stripQuery(req.path);
-    LOG_DEBUG("fd={} POST cleanPath={}", conn->fd(), cleanPath);
+void HttpServer::streamBody(const Server::TcpServer::TcpConnectionPtr& conn,
+                            ConnectionContext&                         ctx) {
+    ctx.parser.setBodySink(
+        [&upload = ctx.upload, weak = std::weak_ptr<Server::TcpConnection>(conn)](
+            std::string_view chunk) {
+            if (!upload.write(chunk)) {
+                return false;
+            }
+            throttle(upload, weak);
+            return true;
+        });
+}
 
-    if (cleanPath == "/api/files") {
-        LOG_DEBUG("fd={} uploading file", conn->fd());
-        handleUpload(conn, req);
+void HttpServer::openFormUpload(const Server::TcpServer::TcpConnectionPtr& conn,
+                                ConnectionContext&                         ctx,
+                                std::string_view                           boundary) {
+    LOG_DEBUG("fd={} streaming multipart upload to disk", conn->fd());
+    ctx.form   = std::make_unique<FormUpload>(boundary);
+    auto& form = *ctx.form;
+    form.parser.setPartBeginCallback([this, &form](const MultipartParser::Part& part) {
+        form.receiving = false;
+        // 没有文件名的部分是普通表单字段（或未选择文件的文件框），内容丢弃
+        const std::string safeName = sanitizeFilename(part.filename);
+        if (safeName.empty()) {
+            return true;
+        }
+        if (form.files.size() >= kMaxFormFiles) {
+            form.fail(StatusCode::kPayloadTooLarge, "Too many files in form\n");
+            return false;
+        }
+        UploadFile file;
+        if (!file.open(tempDir_, safeName, storage_.get())) {
+            const bool noSpace = file.error() == ENOSPC;
+            form.fail(noSpace ? StatusCode::kInsufficientStorage : StatusCode::kInternalServerError,
+                      noSpace ? "Insufficient storage\n" : "Failed to store file\n");
+            return false;
+        }
+        form.files.push_back(std::move(file));
+        form.receiving = true;
+        return true;
+    });
+    form.parser.setPartDataCallback([&form](std::string_view data) {
+        if (form.receiving && !form.files.back().write(data)) {
+            form.fail(StatusCode::kInternalServerError, "Failed to store file\n");
+            return false;
+        }
+        return true;
+    });
+    form.parser.setPartEndCallback([&form]() {
+        form.receiving = false;
+        return true;
+    });
+    // 格式错误或写盘失败时不断开连接：其余 body 照常读完丢弃，由 handleFormUpload 回复错误
+    ctx.parser.setBodySink(
+        [&form, weak = std::weak_ptr<Server::TcpConnection>(conn)](std::string_view chunk) {
+            if (form.status != 0) {
+                return true;
+            }
+            if (!form.parser.feed(chunk)) {
+                form.fail(StatusCode::kBadRequest, "Malformed multipart body\n");
+                return true;
+            }
+            if (form.receiving) {
+                throttle(form.files.back(), weak);
+            }
+            return true;
+        });
+}
+
+void HttpServer::registerRoutes() {
+    using Server::TcpServer;
+    router_.add("GET",
+                "/",
+                [this](const TcpServer::TcpConnectionPtr& conn,
+                       const HttpRequest&                 req,
+                       const RouteParams&) { replyStaticFile(conn, req, "index.html"); });
+    // 其余未被 API 占用的路径都到 staticDir_ 中查找
+    router_.add("GET",
+                "/*path",
+                [this](const TcpServer::TcpConnectionPtr& conn,
+                       const HttpRequest&                 req,
+                       const RouteParams& params) {
+                    replyStaticFile(conn, req, urlDecode(params.get("path")));
+                });
+    router_.add(
+        "GET",
+        "/api/metrics",
+        [this](const TcpServer::TcpConnectionPtr& conn, const HttpRequest&, const RouteParams&) {
+            replyMetrics(conn);
+        });
+    router_.add("GET",
+                "/api/files",
+                [this](const TcpServer::TcpConnectionPtr& conn,
+                       const HttpRequest&                 req,
+                       const RouteParams&) { replyFileList(conn, req); });
+    router_.add("POST",
+                "/api/files",
+                [this](const TcpServer::TcpConnectionPtr& conn,
+                       const HttpRequest&                 req,
+                       const RouteParams&) { handleUpload(conn, req); });
+    // 通配匹配 /api/files/ 之后的全部路径，多段名字交给 sanitizeFilename 清洗
+    router_.add("GET",
+                "/api/files/*name",
+                [this](const TcpServer::TcpConnectionPtr& conn,
+                       const HttpRequest&                 req,
+                       const RouteParams& params) {
+                    replyDownload(conn, req, params.get("name"));
+                });
+    router_.add("DELETE",
+                "/api/files/*name",
+                [this](const TcpServer::TcpConnectionPtr& conn,
+                       const HttpRequest&,
+                       const RouteParams& params) { handleRemove(conn, params.get("name")); });
+    router_.add("GET",
+                "/api/archive",
+                [this](const TcpServer::TcpConnectionPtr& conn,
+                       const HttpRequest&                 req,
+                       const RouteParams&) { replyArchive(conn, req); });
+    router_.add("POST",
+                "/api/archive",
+                [this](const TcpServer::TcpConnectionPtr& conn,
+                       const HttpRequest&                 req,
+                       const RouteParams&) { replyArchive(conn, req); });
+    router_.add("POST",
+                "/api/uploads",
+                [this](const TcpServer::TcpConnectionPtr& conn,
+                       const HttpRequest&                 req,
+                       const RouteParams&) { createUploadSession(conn, req); });
+    router_.add("GET",
+                "/api/uploads/:id",
+                [this](const TcpServer::TcpConnectionPtr& conn,
+                       const HttpRequest&,
+                       const RouteParams& params) { replyUploadSession(conn, params.get("id")); });
+    router_.add("PUT",
+                "/api/uploads/:id",
+                [this](const TcpServer::TcpConnectionPtr& conn,
+                       const HttpRequest&                 req,
+                       const RouteParams& params) {
+                    handleUploadChunk(conn, req, params.get("id"));
+                });
+    router_.add("DELETE",
+                "/api/uploads/:id",
+                [this](const TcpServer::TcpConnectionPtr& conn,
+                       const HttpRequest&,
+                       const RouteParams& params) { removeUploadSession(conn, params.get("id")); });
+    router_.add("POST",
+                "/api/uploads/:id/commit",
+                [this](const TcpServer::TcpConnectionPtr& conn,
+                       const HttpRequest&,
+                       const RouteParams& params) { commitUploadSession(conn, params.get("id")); });
+}
+
+void HttpServer::handleRequest(const Server::TcpServer::TcpConnectionPtr& conn,
+                               const HttpRequest&                         req) {
+    LOG_INFO("fd={} {} {}", conn->fd(), req.method, req.path);
+    LOG_DEBUG("fd={} request details: version={}, headers={}, body_size={}",
+              conn->fd(),
+              req.version,
+              req.headers.size(),
+              req.body.size());
+
+    const Router::Match match = router_.match(req.method, stripQuery(req.path));
+    if (match.handler != nullptr) {
+        (*match.handler)(conn, req, match.params);
         return;
     }
-    LOG_WARN("fd={} POST path not found: {}", conn->fd(), cleanPath);
+
     HttpResponse resp;
-    resp.setStatus(StatusCode::kNotFound, "Not Found");
     resp.setContentType("text/plain; charset=utf-8");
-    resp.setBody("POST target not found\n");
-    conn->send(resp.serialize(true));
-    auto& ctx    = contexts_[conn->fd()];
-    auto& parser = ctx.parser;
-    if (!parser.isKeepAlive()) {
-        conn->shutdown();
+    if (match.pathFound) {
+        LOG_WARN("fd={} method {} not allowed for {}", conn->fd(), req.method, req.path);
+        resp.setStatus(StatusCode::kMethodNotAllowed);
+        resp.setHeader("Allow", std::string{match.allow});
+        resp.setBody("Method not allowed\n");
+    } else {
+        LOG_WARN("fd={} {} path not found: {}", conn->fd(), req.method, req.path);
+        resp.setStatus(StatusCode::kNotFound);
+        resp.setBody("Resource not found\n");
     }
+    sendResponse(conn, resp);
 }
 
-void HttpServer::handleDelete(const Server::TcpServer::TcpConnectionPtr& conn,
-                              const HttpRequest&                         req) {
-    const std::string          cleanPath = stripQuery(req.path);
-    constexpr std::string_view prefix    = "/api/files";
-    LOG_DEBUG("fd={} DELETE cleanPath={}", conn->fd(), cleanPath);
-
-    if (cleanPath.rfind(prefix, 0) == 0 && cleanPath.size() > prefix.size() + 1) {
-        const std::string name = cleanPath.substr(prefix.size() + 1);
-        LOG_DEBUG("fd={} deleting file: {}", conn->fd(), name);
-        handleRemove(conn, name);
+void HttpServer::replyStaticFile(const Server::TcpServer::TcpConnectionPtr& conn,
+                                 const HttpRequest&                         req,
+                                 std::string_view                           relativePath) {
+    LOG_TRACE("fd={} serving static file: {}", conn->fd(), relativePath);
+    auto& ctx = contexts_[conn->fd()];
+    if (auto entry = staticCache_.find(relativePath, ctx.accept)) {
+        sendStaticEntry(conn,
+                        ctx,
+                        std::move(entry),
+                        req.headers.get(HeaderId::IF_NONE_MATCH),
+                        req.headers.get(HeaderId::IF_MODIFIED_SINCE));
         return;
     }
-    LOG_WARN("fd={} DELETE path not found: {}", conn->fd(), cleanPath);
-    HttpResponse resp;
-    resp.setStatus(StatusCode::kNotFound, "Not Found");
-    resp.setContentType("text/plain; charset=utf-8");
-    resp.setBody("DELETE target not found\n");
-    conn->send(resp.serialize(true));
-    auto& ctx    = contexts_[conn->fd()];
-    auto& parser = ctx.parser;
-    if (!parser.isKeepAlive()) {
-        conn->shutdown();
+
+    // 未命中：读文件（及现场压缩）交给线程池，回到 loop 线程后放入缓存再回复
+    auto                loaded     = std::make_shared<StaticFileCache::Loaded>();
+    const ContentCoding accept     = ctx.accept;
+    const uint64_t      generation = staticCache_.generation();
+    offload(
+        conn,
+        [this, loaded, path = std::string{relativePath}, accept]() {
+            *loaded = staticCache_.load(path, accept);
+        },
+        [this,
+         conn,
+         loaded,
+         accept,
+         generation,
+         path            = std::string{relativePath},
+         ifNoneMatch     = std::string{req.headers.get(HeaderId::IF_NONE_MATCH)},
+         ifModifiedSince = std::string{req.headers.get(HeaderId::IF_MODIFIED_SINCE)}](
+            ConnectionContext& ctx) {
+            auto entry = staticCache_.store(*loaded, accept, generation);
+            if (!entry) {
+                LOG_WARN("fd={} static file not found: {}", conn->fd(), path);
+                HttpResponse resp;
+                resp.setStatus(StatusCode::kNotFound);
+                resp.setContentType("text/plain; charset=utf-8");
+                resp.setBody("Static file missing\n");
+                sendResponse(conn, resp);
+                return;
+            }
+            sendStaticEntry(conn, ctx, std::move(entry), ifNoneMatch, ifModifiedSince);
+        });
+}
+
+void HttpServer::sendStaticEntry(const Server::TcpServer::TcpConnectionPtr&    conn,
+                                 ConnectionContext&                            ctx,
+                                 std::shared_ptr<const StaticFileCache::Entry> entry,
+                                 std::string_view                              ifNoneMatch,
+                                 std::string_view                              ifModifiedSince) {
+    // 响应头已在缓存中拼好，只需补上随请求变化的 Connection 与 Date
+    const bool keepAlive = !ctx.closing && ctx.keepAlive;
+    const bool unchanged = notModified(ifNoneMatch, ifModifiedSince, entry->etag, entry->mtime);
+    ctx.output.append(unchanged ? entry->notModifiedHead : entry->head);
+    HttpResponse::appendConnection(ctx.output, keepAlive);
+    HttpResponse::appendDate(ctx.output);
+    ctx.output.append("\r\n");
+    ctx.closing = !keepAlive;
+    if (unchanged) {
+        LOG_TRACE("fd={} static file not modified", conn->fd());
+    } else if (entry->body.size() <= kInlineBodyLimit) {
+        ctx.output.append(entry->body);
+    } else {
+        // 大文件不复制进批次：与映射文件一样由 FileSender 从缓存项分段 writev，
+        // 套接字写不下的只有当前一段；缓存项在发送结束前不会释放
+        const std::string_view body{entry->body};
+        auto                   mapping = MappedFileCache::borrow(std::move(entry), body);
+        startSender(
+            conn, ctx, std::make_shared<FileSender>(*storage_, conn, mapping, 0, body.size()));
     }
 }
 
-void HttpServer::replyStaticFile(const Server::TcpServer::TcpConnectionPtr& conn,
-                                 const std::filesystem::path&               relativePath) {
-    auto            target = staticDir_ / relativePath;
-    std::error_code ec;
-    LOG_TRACE("fd={} serving static file: {}", conn->fd(), target.string());
+void HttpServer::replyFileList(const Server::TcpServer::TcpConnectionPtr& conn,
+                               const HttpRequest&                         req) {
+    // 查询参数：prefix 过滤文件名前缀，cursor 为上一页返回的 next_cursor，limit 为每页条数
+    const std::string prefix = queryParam(req.path, "prefix").value_or("");
+    const std::string cursor = queryParam(req.path, "cursor").value_or("");
+    FileIndex::Query  query{prefix, cursor};
+    if (const auto limit = queryParam(req.path, "limit")) {
+        const char* end    = limit->data() + limit->size();
+        const auto  result = std::from_chars(limit->data(), end, query.limit);
+        if (result.ec != std::errc{} || result.ptr != end || query.limit == 0) {
+            HttpResponse resp;
+            resp.setStatus(StatusCode::kBadRequest);
+            resp.setContentType("text/plain; charset=utf-8");
+            resp.setBody("Invalid limit\n");
+            sendResponse(conn, resp);
+            return;
+        }
+    }
 
-    if (!std::filesystem::exists(target, ec) || !std::filesystem::is_regular_file(target, ec)) {
-        LOG_ERROR("fd={} static file not found: {}", conn->fd(), target.string());
+    // 索引每次变化都会换 ETag；列表是文件名与元数据的汇总而非逐字节的表示，用弱 ETag
+    const std::string etag = fileIndex_.etag();
+    if (etagListMatches(req.headers.get(HeaderId::IF_NONE_MATCH), etag)) {
         HttpResponse resp;
-        resp.setStatus(StatusCode::kNotFound, "Not Found");
-        resp.setContentType("text/plain; charset=utf-8");
-        resp.setBody("Static file missing\n");
-        conn->send(resp.serialize(false));
-        conn->shutdown();
+        resp.setStatus(StatusCode::kNotModified);
+        resp.setHeader(HeaderId::ETAG, etag);
+        resp.setHeader(HeaderId::CACHE_CONTROL, "no-cache");
+        if (compression_.level > 0) {
+            resp.setHeader(HeaderId::VARY, "Accept-Encoding");  // 与 200 时一致
+        }
+        sendResponse(conn, resp);
         return;
     }
 
-    std::ifstream      ifs(target, std::ios::binary);
-    std::ostringstream oss;
-    oss << ifs.rdbuf();  // 将文件的内容传递到oss
-    LOG_DEBUG("fd={} served static file {} ({} bytes)",
-              conn->fd(),
-              relativePath.string(),
-              oss.str().size());
+    std::string nextCursor;
+    auto        appendTail = [&nextCursor](std::string& out) {
+        out.append("],\"next_cursor\":");
+        if (nextCursor.empty()) {
+            out.append("null}");
+        } else {
+            out.append("\"").append(escapeJson(nextCursor)).append("\"}");
+        }
+    };
 
-    HttpResponse resp;
-    resp.setContentType("text/html; charset=utf-8");
-    resp.setBody(oss.str());
-    conn->send(resp.serialize(true));
-    auto& ctx    = contexts_[conn->fd()];
-    auto& parser = ctx.parser;
-    if (!parser.isKeepAlive()) {
-        conn->shutdown();
+    const size_t expected = std::min(query.limit, fileIndex_.size());
+    if (req.version == "HTTP/1.1" && expected > kStreamListThreshold) {
+        // 大列表边生成边以 chunked 发送，无需先拼出完整 JSON；
+        // 先把批次中排在前面的响应发出，保证顺序
+        auto&      ctx       = contexts_[conn->fd()];
+        const bool keepAlive = ctx.keepAlive;
+        flushOutput(conn, ctx);
+        HttpResponse head;
+        head.setContentType("application/json; charset=utf-8");
+        head.setHeader(HeaderId::ETAG, etag);
+        head.setHeader(HeaderId::CACHE_CONTROL, "no-cache");
+        if (compression_.level > 0) {
+            head.setHeader(HeaderId::VARY, "Accept-Encoding");
+        }
+        const ContentCoding coding =
+            compression_.level > 0 ? ctx.accept : ContentCoding::IDENTITY;
+        ChunkedWriter writer(conn, std::move(head), keepAlive, coding, compression_.level);
+        writer.write("{\"files\":[");
+        fileIndex_.list(
+            query, [&writer](std::string_view part) { writer.write(part); }, nextCursor);
+        std::string tail;
+        appendTail(tail);
+        writer.write(tail);
+        writer.finish();
+        ctx.closing = !keepAlive;
+        return;
     }
+
+    std::string body = "{\"files\":[";
+    fileIndex_.list(query, [&body](std::string_view part) { body.append(part); }, nextCursor);
+    appendTail(body);
+    LOG_DEBUG(
+        "fd={} file list: {} bytes, {} files indexed", conn->fd(), body.size(), fileIndex_.size());
+
+    HttpResponse resp;
+    resp.setContentType("application/json; charset=utf-8");
+    resp.setHeader(HeaderId::ETAG, etag);
+    resp.setHeader(HeaderId::CACHE_CONTROL, "no-cache");
+    resp.setBody(std::move(body));
+    sendResponse(conn, resp);
 }
 
-void HttpServer::replyFileList(const Server::TcpServer::TcpConnectionPtr& conn) {
-    std::vector<std::string> names;
-    std::error_code          ec;
-    std::filesystem::create_directories(storageDir_, ec);
-    if (!ec) {
-        for (const auto& entry : std::filesystem::directory_iterator(storageDir_, ec)) {
-            if (entry.is_regular_file()) {
-                names.emplace_back(entry.path().filename().string());
-            }
-        }
-        LOG_DEBUG("fd={} file list: {} files found", conn->fd(), names.size());
-    } else {
-        LOG_ERROR(
-            "fd={} failed to list files in {}: {}", conn->fd(), storageDir_.string(), ec.message());
-    }
-    std::sort(names.begin(), names.end());
+void HttpServer::replyMetrics(const Server::TcpServer::TcpConnectionPtr& conn) {
+    const Server::LoopStats& loop = loop_->stats();
 
     std::ostringstream json;
-    json << "{\"files\":[";
-    for (size_t i = 0; i < names.size(); ++i) {
-        if (i > 0) {
-            json << ',';
-        }
-        json << '\"' << escapeJson(names[i]) << '\"';
+    json << "{\"connections\":" << contexts_.size() << ",\"parser\":{\"buffered_bytes\":"
+         << HttpParser::bufferedBytes() << ",\"buffer_budget\":" << HttpParser::bufferBudget()
+         << ",\"rejections\":{";
+    bool first = true;
+    for (const auto& [status, count] : rejections_) {
+        json << (first ? "" : ",") << '\"' << status << "\":" << count;
+        first = false;
+    }
+    const StaticFileCache::Stats cache = staticCache_.stats();
+    json << "}},\"static_cache\":{\"entries\":" << cache.entries << ",\"bytes\":" << cache.bytes
+         << ",\"hits\":" << cache.hits << ",\"misses\":" << cache.misses
+         << ",\"evictions\":" << cache.evictions << ",\"invalidations\":" << cache.invalidations
+         << ",\"compressions\":" << cache.compressions
+         << "},\"pipeline\":{\"requests\":" << pipelineStats_.requests
+         << ",\"batches\":" << pipelineStats_.batches
+         << "},\"loop\":{\"iterations\":" << loop.iterations
+         << ",\"spin_polls\":" << loop.spinPolls << ",\"spin_ns\":" << loop.spinNs
+         << ",\"block_ns\":" << loop.blockNs << ",\"work_ns\":" << loop.workNs << "}";
+    const Server::DiskIoPool::Stats disk = diskPool_.stats();
+    json << ",\"disk_io\":{\"threads\":" << diskPool_.threads() << ",\"queued\":" << disk.queued
+         << ",\"in_flight\":" << disk.inFlight << ",\"max_queued\":" << disk.maxQueued
+         << ",\"submitted\":" << disk.submitted << ",\"completed\":" << disk.completed
+         << ",\"rejected\":" << disk.rejected << ",\"wait_ns\":" << disk.waitNs
+         << ",\"service_ns\":" << disk.serviceNs << ",\"latency_ns\":" << disk.latencyNs
+         << ",\"max_latency_ns\":" << disk.maxLatencyNs << "}";
+    const Server::StorageEngine::Stats io = storage_->stats();
+    json << ",\"storage\":{\"backend\":\""
+         << (storage_->usingIoUring() ? "io_uring" : "thread_pool") << "\",\"reads\":" << io.reads
+         << ",\"writes\":" << io.writes << ",\"linked_sends\":" << io.linkedSends
+         << ",\"bytes_read\":" << io.bytesRead << ",\"bytes_written\":" << io.bytesWritten
+         << ",\"bytes_sent\":" << io.bytesSent << ",\"errors\":" << io.errors
+         << ",\"in_flight\":" << io.inFlight << ",\"backlog\":" << io.backlog << "}";
+    const MappedFileCache::Stats mapped = mappedFiles_.stats();
+    json << ",\"mapped_files\":{\"entries\":" << mapped.entries << ",\"bytes\":" << mapped.bytes
+         << ",\"hits\":" << mapped.hits << ",\"misses\":" << mapped.misses
+         << ",\"evictions\":" << mapped.evictions << ",\"invalidations\":" << mapped.invalidations
+         << "},\"upload_sessions\":" << uploadSessions_.size();
+    if (memoryTier_) {
+        const MemoryBackend::Stats memory = memoryTier_->stats();
+        json << ",\"memory_store\":{\"mode\":\""
+             << (memoryTier_->lower() ? "hot_tier" : "primary")
+             << "\",\"entries\":" << memory.entries << ",\"bytes\":" << memory.bytes
+             << ",\"hits\":" << memory.hits << ",\"misses\":" << memory.misses
+             << ",\"promotions\":" << memory.promotions << ",\"evictions\":" << memory.evictions
+             << ",\"rejected\":" << memory.rejected << "}";
     }
-    json << "]}";
+    if (blobs_) {
+        const BlobStore::Stats dedup = blobs_->stats();
+        json << ",\"dedup\":{\"hits\":" << dedup.hits << ",\"bytes_saved\":" << dedup.bytesSaved
+             << ",\"blobs_created\":" << dedup.created
+             << ",\"blobs_collected\":" << dedup.collected << "}";
+    }
+    json << "}";
 
     HttpResponse resp;
     resp.setContentType("application/json; charset=utf-8");
     resp.setBody(json.str());
-    conn->send(resp.serialize(true));
-    auto& ctx    = contexts_[conn->fd()];
-    auto& parser = ctx.parser;
-    if (!parser.isKeepAlive()) {
-        conn->shutdown();
-    }
+    sendResponse(conn, resp);
 }
 
 void HttpServer::replyDownload(const Server::TcpServer::TcpConnectionPtr& conn,
+                               const HttpRequest&                         req,
                                std::string_view                           fileName) {
     const std::string safeName = sanitizeFilename(urlDecode(fileName));
-    auto              target   = storageDir_ / safeName;
-    std::error_code   ec;
     LOG_TRACE("fd={} download request: fileName={}, safeName={}", conn->fd(), fileName, safeName);
-
-    if (safeName.empty() || !std::filesystem::exists(target, ec) ||
-        !std::filesystem::is_regular_file(target, ec)) {
-        LOG_WARN("fd={} file not found for download: {}", conn->fd(), safeName);
-        HttpResponse resp;
-        resp.setStatus(StatusCode::kNotFound, "Not Found");
-        resp.setContentType("text/plain; charset=utf-8");
-        resp.setBody("File not found\n");
-        conn->send(resp.serialize(false));
-        conn->shutdown();
+    if (safeName.empty()) {
+        LOG_WARN("fd={} file not found for download: {}", conn->fd(), fileName);
+        sendResponse(conn, notFound("File not found\n"));
         return;
     }
 
-    std::ifstream      ifs(target, std::ios::binary);
-    std::ostringstream oss;
-    oss << ifs.rdbuf();
-    LOG_INFO("fd={} downloaded file: {} ({} bytes)", conn->fd(), safeName, oss.str().size());
+    DownloadConditions cond;
+    cond.hasRange        = req.headers.contains(HeaderId::RANGE);
+    cond.range           = req.headers.get(HeaderId::RANGE);
+    cond.ifRange         = req.headers.get(HeaderId::IF_RANGE);
+    cond.ifNoneMatch     = req.headers.get(HeaderId::IF_NONE_MATCH);
+    cond.ifModifiedSince = req.headers.get(HeaderId::IF_MODIFIED_SINCE);
 
-    HttpResponse resp;
-    resp.setStatus(StatusCode::kOk, "OK");
-    resp.setContentType("application/octet-stream");
-    resp.setHeader("Content-Disposition", "attachment; filename=\"" + safeName + "\"");
-    resp.setBody(oss.str());
-    conn->send(resp.serialize(true));
-    auto& ctx    = contexts_[conn->fd()];
-    auto& parser = ctx.parser;
-    if (!parser.isKeepAlive()) {
-        conn->shutdown();
+    // 按处理结果回复：正文留在文件或映射中的交给 FileSender
+    auto deliver = [this, conn](ConnectionContext& ctx, DownloadPlan& plan) {
+        std::shared_ptr<FileSender> sender;
+        if (plan.fd >= 0) {
+            sender = std::make_shared<FileSender>(*storage_,
+                                                  conn,
+                                                  std::exchange(plan.fd, -1),
+                                                  std::move(plan.parts),
+                                                  std::move(plan.trailer));
+        } else if (plan.mapping) {
+            sender = std::make_shared<FileSender>(*storage_,
+                                                  conn,
+                                                  std::move(plan.mapping),
+                                                  std::move(plan.parts),
+                                                  std::move(plan.trailer));
+        }
+        if (sender) {
+            streamFile(conn, ctx, plan.response, std::move(sender));
+        } else {
+            sendResponse(conn, plan.response);
+        }
+    };
+
+    // 热文件的映射已缓存或内容在内存中：不访问磁盘，直接在 loop 线程回复
+    auto mapping = mappedFiles_.find(safeName);
+    if (!mapping) {
+        mapping = backend_->cached(safeName);
     }
+    if (mapping) {
+        DownloadPlan plan;
+        plan.mapping = std::move(mapping);
+        mappedDownload(conn->fd(), safeName, cond, plan);
+        deliver(contexts_[conn->fd()], plan);
+        return;
+    }
+
+    // open/fstat/读取可能阻塞，放到线程池执行
+    auto           plan       = std::make_shared<DownloadPlan>();
+    const uint64_t generation = mappedFiles_.generation();
+    offload(
+        conn,
+        [this, plan, connFd = conn->fd(), safeName, cond]() {
+            readDownload(connFd, *backend_, safeName, cond, mappedFiles_, *plan);
+        },
+        [this, conn, plan, safeName, cond, generation, deliver](ConnectionContext& ctx) {
+            if (plan->mapping) {
+                if (!plan->inMemory) {
+                    mappedFiles_.store(safeName, plan->mapping, generation);
+                }
+                mappedDownload(conn->fd(), safeName, cond, *plan);
+            }
+            deliver(ctx, *plan);
+        });
 }
 
 void HttpServer::handleUpload(const Server::TcpServer::TcpConnectionPtr& conn,
                               const HttpRequest&                         req) {
-    auto it = req.headers.find("x-filename");
-    if (it == req.headers.end()) {
+    auto& ctx = contexts_[conn->fd()];
+    if (ctx.form) {
+        handleFormUpload(conn);
+        return;
+    }
+    auto& upload = ctx.upload;  // body 已在 onHeaders 中流式写入临时文件
+    if (!req.headers.contains(HeaderId::X_FILENAME)) {
         LOG_WARN("fd={} upload missing X-Filename header", conn->fd());
+        upload.abort();
         HttpResponse resp;
-        resp.setStatus(StatusCode::kBadRequest, "Bad Request");
+        resp.setStatus(StatusCode::kBadRequest);
         resp.setContentType("text/plain; charset=utf-8");
         resp.setBody("Missing X-Filename header\n");
-        conn->send(resp.serialize(false));
-        conn->shutdown();
+        sendResponse(conn, resp);
         return;
     }
-    const std::string safeName = sanitizeFilename(urlDecode(it->second));
+    const std::string_view rawName  = req.headers.get(HeaderId::X_FILENAME);
+    const std::string      safeName = sanitizeFilename(urlDecode(rawName));
+    const size_t           bodySize = ctx.parser.bodyReceived();
     LOG_TRACE("fd={} upload: originalName={}, safeName={}, bodySize={}",
               conn->fd(),
-              it->second,
+              rawName,
               safeName,
-              req.body.size());
+              bodySize);
 
-    if (safeName.empty() || req.body.empty()) {
+    if (safeName.empty() || bodySize == 0) {
         LOG_WARN("fd={} upload failed: empty filename or body", conn->fd());
+        upload.abort();
         HttpResponse resp;
-        resp.setStatus(StatusCode::kBadRequest, "Bad Request");
+        resp.setStatus(StatusCode::kBadRequest);
         resp.setContentType("text/plain; charset=utf-8");
         resp.setBody("Empty filename or body\n");
-        conn->send(resp.serialize(false));
-        conn->shutdown();
+        sendResponse(conn, resp);
         return;
     }
 
-    std::error_code ec;
-    std::filesystem::create_directories(storageDir_, ec);
-    auto          target = storageDir_ / safeName;
-    std::ofstream ofs(target, std::ios::binary);
-    if (!ofs.is_open()) {
-        LOG_ERROR("fd={} failed to open file for writing: {}", conn->fd(), target.string());
-        HttpResponse resp;
-        resp.setStatus(StatusCode::kInternalServerError, "Internal Server Error");
-        resp.setContentType("text/plain; charset=utf-8");
-        resp.setBody("Failed to store file\n");
-        conn->send(resp.serialize(false));
-        conn->shutdown();
+    // 等缓冲中的数据写完，再在线程池中落盘（fdatasync + rename）；临时文件的所有权随之转给任务
+    struct Commit {
+        UploadFile                 file;
+        StorageBackend::ObjectInfo info;
+        std::error_code            ec;
+        bool                       ok{false};
+    };
+    auto commit  = std::make_shared<Commit>();
+    commit->file = std::move(upload);
+    ctx.waiting  = true;
+    // 写入失败时 commit() 返回该错误并删除临时文件，因此不必区分 flush 的结果
+    auto deferred = std::make_shared<bool>(false);  // flush 是否在之后的事件中完成
+    commit->file.flush([this, conn, commit, safeName, bodySize, deferred](bool) {
+        ConnectionContext* ctx = activeContext(conn);
+        if (ctx == nullptr) {
+            return;  // 连接已关闭：commit 随之释放，临时文件被删除
+        }
+        offload(
+            conn,
+            [this, commit, durability = uploadDurability_]() {
+                commit->ok = commit->file.isOpen() &&
+                             backend_->commit(commit->file, durability, commit->info, commit->ec);
+            },
+            [this, conn, commit, safeName, bodySize](ConnectionContext&) {
+                if (!commit->ok) {
+                    // 预分配或写入时空间不足回复 507，客户端可以区分于服务器内部错误
+                    const int  openError = commit->file.error();
+                    const bool noSpace =
+                        commit->ec == std::errc::no_space_on_device || openError == ENOSPC;
+                    LOG_ERROR("fd={} failed to store file {}: {}",
+                              conn->fd(),
+                              safeName,
+                              commit->ec        ? commit->ec.message()
+                              : openError != 0 ? std::string{strerror(openError)}
+                                               : std::string{"temp file unavailable"});
+                    HttpResponse resp;
+                    resp.setStatus(noSpace ? StatusCode::kInsufficientStorage
+                                           : StatusCode::kInternalServerError);
+                    resp.setContentType("text/plain; charset=utf-8");
+                    resp.setBody(noSpace ? "Insufficient storage\n" : "Failed to store file\n");
+                    sendResponse(conn, resp);
+                    return;
+                }
+                fileIndex_.update(safeName, commit->info.size, commit->info.mtime);
+                LOG_INFO("fd={} uploaded file: {} ({} bytes)", conn->fd(), safeName, bodySize);
+
+                HttpResponse resp;
+                resp.setStatus(StatusCode::kCreated);
+                resp.setContentType("application/json; charset=utf-8");
+                resp.setBody("{\"status\":\"ok\"}");
+                sendResponse(conn, resp);
+            });
+        if (*deferred && !ctx->waiting) {
+            resume(conn, *ctx);  // 线程池已满、503 已生成：由这里继续处理后续请求
+        }
+    });
+    *deferred = true;
+}
+
+void HttpServer::handleFormUpload(const Server::TcpServer::TcpConnectionPtr& conn) {
+    auto&                       ctx  = contexts_[conn->fd()];
+    std::shared_ptr<FormUpload> form = std::move(ctx.form);  // 各部分已在接收时写入临时文件
+    if (form->status == 0 && !form->parser.finished()) {
+        form->fail(StatusCode::kBadRequest, "Malformed multipart body\n");
+    }
+    if (form->status == 0 && form->files.empty()) {
+        form->fail(StatusCode::kBadRequest, "No file in form\n");
+    }
+    if (form->status != 0) {
+        LOG_WARN("fd={} multipart upload failed: {} {}", conn->fd(), form->status, form->reason);
+        sendResponse(conn, plainText(form->status, form->reason));
+        return;  // form 随之释放，临时文件被删除
+    }
+
+    // 与单文件上传相同：等全部文件的缓冲写完，再在线程池中逐个落盘并 rename
+    struct Commit {
+        std::vector<std::string>                names;
+        std::vector<StorageBackend::ObjectInfo> infos;
+        std::vector<std::error_code>            errors;
+        std::vector<char>                       stored;  // 各文件是否已就位
+    };
+    auto commit = std::make_shared<Commit>();
+    for (const auto& file : form->files) {
+        commit->names.push_back(file.name());
+    }
+    commit->infos.resize(form->files.size());
+    commit->errors.resize(form->files.size());
+    commit->stored.resize(form->files.size(), 0);
+    ctx.waiting    = true;
+    auto remaining = std::make_shared<size_t>(form->files.size());
+    auto deferred  = std::make_shared<bool>(false);  // flush 是否在之后的事件中完成
+    auto flushed   = [this, conn, form, commit, deferred]() {
+        ConnectionContext* ctx = activeContext(conn);
+        if (ctx == nullptr) {
+            return;  // 连接已关闭：form 随之释放，临时文件被删除
+        }
+        offload(
+            conn,
+            [this, form, commit, durability = uploadDurability_]() {
+                for (size_t i = 0; i < form->files.size(); ++i) {
+                    UploadFile& file = form->files[i];
+                    commit->stored[i] =
+                        file.isOpen() &&
+                        backend_->commit(file, durability, commit->infos[i], commit->errors[i]);
+                }
+            },
+            [this, conn, commit](ConnectionContext&) {
+                std::string files;
+                bool        failed  = false;
+                bool        noSpace = false;
+                for (size_t i = 0; i < commit->names.size(); ++i) {
+                    const std::string& name = commit->names[i];
+                    if (!commit->stored[i]) {
+                        LOG_ERROR("fd={} failed to store file {}: {}",
+                                  conn->fd(),
+                                  name,
+                                  commit->errors[i].message());
+                        failed = true;
+                        noSpace |= commit->errors[i] == std::errc::no_space_on_device;
+                        continue;
+                    }
+                    fileIndex_.update(name, commit->infos[i].size, commit->infos[i].mtime);
+                    files += (files.empty() ? "\"" : ",\"") + escapeJson(name) + "\"";
+                }
+                if (failed) {
+                    sendResponse(conn, storageFailure(noSpace, "Failed to store file\n"));
+                    return;
+                }
+                LOG_INFO("fd={} uploaded {} files from form", conn->fd(), commit->names.size());
+                sendResponse(conn,
+                             jsonResponse(StatusCode::kCreated,
+                                          "{\"status\":\"ok\",\"files\":[" + files + "]}"));
+            });
+        if (*deferred && !ctx->waiting) {
+            resume(conn, *ctx);  // 线程池已满、503 已生成：由这里继续处理后续请求
+        }
+    };
+    for (auto& file : form->files) {
+        file.flush([remaining, flushed](bool) {
+            if (--*remaining == 0) {
+                flushed();
+            }
+        });
+    }
+    *deferred = true;
+}
+
+void HttpServer::replyArchive(const Server::TcpServer::TcpConnectionPtr& conn,
+                              const HttpRequest&                         req) {
+    if (req.version != "HTTP/1.1") {
+        // 归档大小事先未知，只能以 chunked 发送
+        sendResponse(conn,
+                     plainText(StatusCode::kHttpVersionNotSupported,
+                               "Archive download requires HTTP/1.1\n"));
         return;
     }
-    ofs.write(req.body.data(), static_cast<std::streamsize>(req.body.size()));
-    LOG_INFO("fd={} uploaded file: {} ({} bytes)", conn->fd(), safeName, req.body.size());
+    const std::string compress = queryParam(req.path, "compress").value_or("");
+    if (!compress.empty() && compress != "gzip") {
+        sendResponse(conn, plainText(StatusCode::kBadRequest, "Unsupported compression\n"));
+        return;
+    }
+    const bool gzip = compress == "gzip";
 
-    HttpResponse resp;
-    resp.setStatus(StatusCode::kCreated, "Created");
-    resp.setContentType("application/json; charset=utf-8");
-    resp.setBody("{\"status\":\"ok\"}");
-    conn->send(resp.serialize(true));
-    auto& ctx    = contexts_[conn->fd()];
-    auto& parser = ctx.parser;
-    if (!parser.isKeepAlive()) {
-        conn->shutdown();
+    ArchiveSender::NameSource source;
+    if (req.method == "POST") {
+        // body 每行一个文件名，按给出的顺序打包
+        auto       names = std::make_shared<std::vector<std::string>>();
+        const auto body  = std::string_view{req.body};
+        for (size_t pos = 0; pos < body.size();) {
+            size_t end = body.find('\n', pos);
+            if (end == std::string_view::npos) {
+                end = body.size();
+            }
+            std::string_view line = body.substr(pos, end - pos);
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            std::string name = sanitizeFilename(line);
+            if (!name.empty()) {
+                names->push_back(std::move(name));
+            }
+            pos = end + 1;
+        }
+        if (names->empty()) {
+            sendResponse(conn, plainText(StatusCode::kBadRequest, "No file names\n"));
+            return;
+        }
+        source = [names](std::vector<std::string>& out) { out.swap(*names); };
+    } else {
+        // 按名字顺序分批取出前缀匹配的文件名，每批从上一批的最后一个之后继续，
+        // 期间上传或删除的文件不会让遍历重复或遗漏其余文件
+        source = [this,
+                  prefix = queryParam(req.path, "prefix").value_or(""),
+                  cursor = std::string{},
+                  done   = false](std::vector<std::string>& out) mutable {
+            if (done) {
+                return;
+            }
+            std::string next;
+            fileIndex_.names({prefix, cursor, kArchiveNameBatch}, out, next);
+            cursor = std::move(next);
+            done   = cursor.empty();
+        };
     }
+
+    const ContentCoding coding = gzip ? ContentCoding::GZIP : ContentCoding::IDENTITY;
+    const int           level =
+        compression_.level > 0 ? compression_.level : CompressionOptions{}.level;
+    auto archive = std::make_shared<ArchiveSender>(
+        *storage_, diskPool_, *backend_, conn, std::move(source), coding, level);
+    HttpResponse head;
+    head.setContentType(gzip ? "application/gzip" : "application/x-tar");
+    head.setHeader(HeaderId::CONTENT_DISPOSITION,
+                   gzip ? "attachment; filename=\"archive.tar.gz\""
+                        : "attachment; filename=\"archive.tar\"");
+    head.setHeader(HeaderId::CACHE_CONTROL, "no-store");
+    head.setChunked();
+    LOG_INFO("fd={} streaming archive ({})", conn->fd(), gzip ? "tar.gz" : "tar");
+    streamArchive(conn, contexts_[conn->fd()], head, std::move(archive));
 }
 
 void HttpServer::handleRemove(const Server::TcpServer::TcpConnectionPtr& conn,
@@ -374,48 +1547,293 @@ void HttpServer::handleRemove(const Server::TcpServer::TcpConnectionPtr& conn,
     if (safeName.empty()) {
         LOG_WARN("fd={} delete failed: invalid filename", conn->fd());
         HttpResponse resp;
-        resp.setStatus(StatusCode::kBadRequest, "Bad Request");
+        resp.setStatus(StatusCode::kBadRequest);
         resp.setContentType("text/plain; charset=utf-8");
         resp.setBody("Invalid filename\n");
-        conn->send(resp.serialize(false));
-        conn->shutdown();
+        sendResponse(conn, resp);
         return;
     }
 
-    auto            target = storageDir_ / safeName;
-    std::error_code ec;
-    if (!std::filesystem::exists(target, ec)) {
-        LOG_WARN("fd={} delete failed: file not found: {}", conn->fd(), safeName);
-        HttpResponse resp;
-        resp.setStatus(StatusCode::kNotFound, "Not Found");
-        resp.setContentType("text/plain; charset=utf-8");
-        resp.setBody("File not found\n");
-        conn->send(resp.serialize(false));
-        conn->shutdown();
+    // 删除可能阻塞在慢盘上，放到线程池执行
+    enum class Outcome { DELETED, NOT_FOUND, FAILED };
+    struct Removal {
+        Outcome         outcome{Outcome::FAILED};
+        std::error_code ec;
+    };
+    auto removal = std::make_shared<Removal>();
+    offload(
+        conn,
+        [this, removal, safeName]() {
+            if (backend_->remove(safeName, removal->ec)) {
+                removal->outcome = Outcome::DELETED;
+            } else if (removal->ec == std::errc::no_such_file_or_directory) {
+                removal->outcome = Outcome::NOT_FOUND;
+            }
+        },
+        [this, conn, removal, safeName](ConnectionContext&) {
+            HttpResponse resp;
+            switch (removal->outcome) {
+                case Outcome::NOT_FOUND:
+                    LOG_WARN("fd={} delete failed: file not found: {}", conn->fd(), safeName);
+                    resp.setStatus(StatusCode::kNotFound);
+                    resp.setContentType("text/plain; charset=utf-8");
+                    resp.setBody("File not found\n");
+                    break;
+                case Outcome::FAILED:
+                    LOG_ERROR("fd={} failed to delete file {}: {}",
+                              conn->fd(),
+                              safeName,
+                              removal->ec.message());
+                    resp.setStatus(StatusCode::kInternalServerError);
+                    resp.setContentType("text/plain; charset=utf-8");
+                    resp.setBody("Failed to delete file\n");
+                    break;
+                case Outcome::DELETED:
+                    fileIndex_.erase(safeName);
+                    LOG_INFO("fd={} deleted file: {}", conn->fd(), safeName);
+                    resp.setContentType("application/json; charset=utf-8");
+                    resp.setBody("{\"status\":\"deleted\"}");
+                    break;
+            }
+            sendResponse(conn, resp);
+        });
+}
+
+void HttpServer::createUploadSession(const Server::TcpServer::TcpConnectionPtr& conn,
+                                     const HttpRequest&                         req) {
+    const std::string safeName =
+        sanitizeFilename(urlDecode(req.headers.get(HeaderId::X_FILENAME)));
+    const std::string_view sizeText = req.headers.get("X-Upload-Length");
+    const char*            sizeEnd  = sizeText.data() + sizeText.size();
+    uint64_t               size     = 0;
+    const auto [end, ec]            = std::from_chars(sizeText.data(), sizeEnd, size);
+    if (safeName.empty() || ec != std::errc{} || end != sizeEnd || size == 0) {
+        LOG_WARN("fd={} upload session rejected: bad X-Filename or X-Upload-Length", conn->fd());
+        sendResponse(conn,
+                     plainText(StatusCode::kBadRequest,
+                               "X-Filename and a positive X-Upload-Length are required\n"));
+        return;
+    }
+    if (uploadSessions_.size() >= UploadSessions::kMaxSessions) {
+        LOG_WARN("fd={} too many upload sessions", conn->fd());
+        sendResponse(conn,
+                     plainText(StatusCode::kServiceUnavailable, "Too many upload sessions\n"));
         return;
     }
 
-    std::filesystem::remove(target, ec);
-    if (ec) {
-        LOG_ERROR("fd={} failed to delete file {}: {}", conn->fd(), safeName, ec.message());
-        HttpResponse resp;
-        resp.setStatus(StatusCode::kInternalServerError, "Internal Server Error");
-        resp.setContentType("text/plain; charset=utf-8");
-        resp.setBody("Failed to delete file\n");
-        conn->send(resp.serialize(false));
-        conn->shutdown();
+    // 建立并预分配会话文件可能阻塞，放到线程池执行
+    struct Creation {
+        UploadSessions::SessionPtr session;
+        std::error_code            ec;
+    };
+    auto creation = std::make_shared<Creation>();
+    offload(
+        conn,
+        [this, creation, safeName, size, durability = uploadDurability_]() {
+            creation->session = uploadSessions_.create(safeName, size, durability, creation->ec);
+        },
+        [this, conn, creation, safeName, size](ConnectionContext&) {
+            if (!creation->session) {
+                LOG_ERROR("fd={} failed to create upload session for {} ({} bytes): {}",
+                          conn->fd(),
+                          safeName,
+                          size,
+                          creation->ec.message());
+                sendResponse(conn,
+                             storageFailure(creation->ec == std::errc::no_space_on_device ||
+                                                creation->ec == std::errc::file_too_large,
+                                            "Failed to create upload session\n"));
+                return;
+            }
+            const auto& session = creation->session;
+            LOG_INFO("fd={} upload session {} created for {} ({} bytes)",
+                     conn->fd(),
+                     session->id,
+                     safeName,
+                     size);
+            HttpResponse resp = jsonResponse(StatusCode::kCreated, session->json());
+            resp.setHeader(HeaderId::LOCATION, std::string{kUploadSessionPrefix} + session->id);
+            uploadSessions_.insert(session);
+            sendResponse(conn, resp);
+        });
+}
+
+void HttpServer::replyUploadSession(const Server::TcpServer::TcpConnectionPtr& conn,
+                                    std::string_view                           id) {
+    const auto session = uploadSessions_.find(id);
+    if (!session) {
+        sendResponse(conn, notFound("Upload session not found\n"));
         return;
     }
-    LOG_INFO("fd={} deleted file: {}", conn->fd(), safeName);
+    HttpResponse resp = jsonResponse(StatusCode::kOk, session->json());
+    resp.setHeader(HeaderId::CACHE_CONTROL, "no-store");
+    sendResponse(conn, resp);
+}
 
-    HttpResponse resp;
-    resp.setContentType("application/json; charset=utf-8");
-    resp.setBody("{\"status\":\"deleted\"}");
-    conn->send(resp.serialize(true));
+void HttpServer::handleUploadChunk(const Server::TcpServer::TcpConnectionPtr& conn,
+                                   const HttpRequest&                         req,
+                                   std::string_view                           id) {
     auto& ctx    = contexts_[conn->fd()];
-    auto& parser = ctx.parser;
-    if (!parser.isKeepAlive()) {
-        conn->shutdown();
+    auto  writer = std::move(ctx.chunk);  // body 已在 openUploadChunk 中写到会话文件
+    if (!writer || !ctx.upload.isOpen()) {
+        ctx.upload.abort();
+        if (!uploadSessions_.find(id)) {
+            sendResponse(conn, notFound("Upload session not found\n"));
+            return;
+        }
+        LOG_WARN("fd={} bad chunk for upload session {}: Content-Range={}",
+                 conn->fd(),
+                 id,
+                 req.headers.get(HeaderId::CONTENT_RANGE));
+        sendResponse(conn,
+                     plainText(StatusCode::kBadRequest,
+                               "Content-Range must lie within the upload and match "
+                               "Content-Length\n"));
+        return;
+    }
+
+    // 等缓冲中的数据写完，再在线程池中落盘并记录进度；完成后才把区间计入会话
+    struct Chunk {
+        UploadFile      file;
+        std::error_code ec;
+        bool            ok{false};
+    };
+    auto chunk  = std::make_shared<Chunk>();
+    chunk->file = std::move(ctx.upload);
+    ctx.waiting = true;
+    auto deferred = std::make_shared<bool>(false);  // flush 是否在之后的事件中完成
+    chunk->file.flush([this, conn, chunk, writer, deferred](bool ok) {
+        chunk->file.abort();  // 只关闭复制的 fd，会话文件保留
+        ConnectionContext* ctx = activeContext(conn);
+        if (ctx == nullptr) {
+            return;  // 连接已关闭：该分片不计入进度，客户端重传
+        }
+        chunk->ok = ok;
+        offload(
+            conn,
+            [this,
+             chunk,
+             session    = writer->session,
+             first      = writer->first,
+             end        = writer->end,
+             durability = uploadDurability_]() {
+                if (chunk->ok) {
+                    chunk->ok = uploadSessions_.record(*session, first, end, durability, chunk->ec);
+                }
+            },
+            [this, conn, chunk, writer](ConnectionContext&) {
+                const auto& session = writer->session;
+                if (session->closed) {
+                    sendResponse(conn, notFound("Upload session not found\n"));
+                    return;
+                }
+                if (!chunk->ok) {
+                    LOG_ERROR("fd={} failed to store bytes {}-{} of upload session {}: {}",
+                              conn->fd(),
+                              writer->first,
+                              writer->end,
+                              session->id,
+                              chunk->ec ? chunk->ec.message() : std::string{"write failed"});
+                    sendResponse(conn,
+                                 storageFailure(chunk->ec == std::errc::no_space_on_device,
+                                                "Failed to store chunk\n"));
+                    return;
+                }
+                session->add(writer->first, writer->end);
+                LOG_DEBUG("fd={} upload session {}: {}/{} bytes",
+                          conn->fd(),
+                          session->id,
+                          session->received(),
+                          session->size);
+                HttpResponse resp = jsonResponse(StatusCode::kOk, session->json());
+                resp.setHeader(HeaderId::CACHE_CONTROL, "no-store");
+                sendResponse(conn, resp);
+            });
+        if (*deferred && !ctx->waiting) {
+            resume(conn, *ctx);  // 线程池已满、503 已生成：由这里继续处理后续请求
+        }
+    });
+    *deferred = true;
+}
+
+void HttpServer::commitUploadSession(const Server::TcpServer::TcpConnectionPtr& conn,
+                                     std::string_view                           id) {
+    const auto session = uploadSessions_.find(id);
+    if (!session) {
+        sendResponse(conn, notFound("Upload session not found\n"));
+        return;
+    }
+    // 还有分片在写、区间未到齐或已在提交：回复 409 与当前进度，客户端补传后重试
+    if (session->closed || session->writers > 0 || !session->complete()) {
+        LOG_WARN("fd={} upload session {} not ready to commit: {}/{} bytes, {} writers",
+                 conn->fd(),
+                 session->id,
+                 session->received(),
+                 session->size,
+                 session->writers);
+        sendResponse(conn, jsonResponse(StatusCode::kConflict, session->json()));
+        return;
+    }
+
+    session->closed = true;  // 提交期间不再接受分片
+    struct Commit {
+        StorageBackend::ObjectInfo info;
+        std::error_code            ec;
+        bool                       ok{false};
+    };
+    auto       commit = std::make_shared<Commit>();
+    const bool queued = offload(
+        conn,
+        [this, commit, session, durability = uploadDurability_]() {
+            commit->ok = uploadSessions_.commit(
+                *session, *backend_, durability, commit->info, commit->ec);
+        },
+        [this, conn, commit, session](ConnectionContext&) {
+            if (!commit->ok) {
+                session->closed = false;  // 数据仍在，允许重试
+                LOG_ERROR("fd={} failed to commit upload session {} as {}: {}",
+                          conn->fd(),
+                          session->id,
+                          session->name,
+                          commit->ec.message());
+                sendResponse(conn,
+                             storageFailure(commit->ec == std::errc::no_space_on_device,
+                                            "Failed to store file\n"));
+                return;
+            }
+            uploadSessions_.erase(session->id);
+            fileIndex_.update(session->name, commit->info.size, commit->info.mtime);
+            LOG_INFO("fd={} uploaded file: {} ({} bytes, session {})",
+                     conn->fd(),
+                     session->name,
+                     session->size,
+                     session->id);
+            sendResponse(conn, jsonResponse(StatusCode::kCreated, "{\"status\":\"ok\"}"));
+        });
+    if (!queued) {
+        session->closed = false;  // 已回复 503，稍后可以重试
+    }
+}
+
+void HttpServer::removeUploadSession(const Server::TcpServer::TcpConnectionPtr& conn,
+                                     std::string_view                           id) {
+    const auto session = uploadSessions_.find(id);
+    if (!session || session->closed) {
+        sendResponse(conn, notFound("Upload session not found\n"));
+        return;
+    }
+    // 在途分片写完后发现 closed 即回复 404
+    session->closed = true;
+    const bool queued = offload(
+        conn,
+        [this, session]() { uploadSessions_.discard(*session); },
+        [this, conn, session](ConnectionContext&) {
+            uploadSessions_.erase(session->id);
+            LOG_INFO("fd={} upload session {} discarded", conn->fd(), session->id);
+            sendResponse(conn, jsonResponse(StatusCode::kOk, "{\"status\":\"deleted\"}"));
+        });
+    if (!queued) {
+        session->closed = false;
     }
 }
 
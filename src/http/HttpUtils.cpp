@@ -1,9 +1,11 @@
 #include "http/HttpUtils.hpp"
 
 #include <algorithm>
+#include <cctype>
 #include <cstdio>
 #include <cstdlib>
 #include <filesystem>
+#include <iterator>
 #include <string>
 #include <string_view>
 
@@ -11,16 +13,78 @@ namespace {
 constexpr int           kHexBase             = 16;
 constexpr unsigned char kJsonPrintableFloor  = 0x20;
 constexpr std::size_t   kUnicodeEscapeBufLen = 7;
+
+constexpr const char* kWeekdays[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+constexpr const char* kMonths[]   = {
+    "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+struct MimeEntry {
+    std::string_view extension;
+    std::string_view type;
+};
+constexpr MimeEntry kMimeTypes[] = {
+    {"html", "text/html; charset=utf-8"},
+    {"htm", "text/html; charset=utf-8"},
+    {"css", "text/css; charset=utf-8"},
+    {"js", "text/javascript; charset=utf-8"},
+    {"mjs", "text/javascript; charset=utf-8"},
+    {"json", "application/json; charset=utf-8"},
+    {"map", "application/json; charset=utf-8"},
+    {"txt", "text/plain; charset=utf-8"},
+    {"md", "text/markdown; charset=utf-8"},
+    {"xml", "application/xml"},
+    {"svg", "image/svg+xml"},
+    {"png", "image/png"},
+    {"jpg", "image/jpeg"},
+    {"jpeg", "image/jpeg"},
+    {"gif", "image/gif"},
+    {"webp", "image/webp"},
+    {"avif", "image/avif"},
+    {"ico", "image/x-icon"},
+    {"woff", "font/woff"},
+    {"woff2", "font/woff2"},
+    {"ttf", "font/ttf"},
+    {"wasm", "application/wasm"},
+    {"pdf", "application/pdf"},
+    {"zip", "application/zip"},
+    {"gz", "application/gzip"},
+    {"tar", "application/x-tar"},
+    {"mp4", "video/mp4"},
+    {"webm", "video/webm"},
+    {"mp3", "audio/mpeg"},
+};
+constexpr std::string_view kDefaultMimeType = "application/octet-stream";
+
+char* putTwoDigits(char* out, int value) {
+    out[0] = static_cast<char>('0' + value / 10);
+    out[1] = static_cast<char>('0' + value % 10);
+    return out + 2;
+}
 }  // namespace
 
 namespace Http {
 
-std::string stripQuery(const std::string& path) {
-    auto pos = path.find('?');
-    if (pos == std::string::npos) {
-        return path;
+std::string_view stripQuery(std::string_view path) {
+    return path.substr(0, path.find('?'));
+}
+
+std::optional<std::string> queryParam(std::string_view target, std::string_view name) {
+    const size_t question = target.find('?');
+    if (question == std::string_view::npos) {
+        return std::nullopt;
+    }
+    std::string_view query = target.substr(question + 1);
+    while (!query.empty()) {
+        const size_t           amp   = query.find('&');
+        const std::string_view pair  = query.substr(0, amp);
+        const size_t           equal = pair.find('=');
+        if (pair.substr(0, equal) == name) {
+            return urlDecode(equal == std::string_view::npos ? std::string_view{}
+                                                             : pair.substr(equal + 1));
+        }
+        query = amp == std::string_view::npos ? std::string_view{} : query.substr(amp + 1);
     }
-    return path.substr(0, pos);
+    return std::nullopt;
 }
 
 std::string urlDecode(std::string_view input) {
@@ -90,4 +154,128 @@ std::string sanitizeFilename(std::string_view name) {
     return clean;
 }
 
+std::string_view mimeType(std::string_view path) {
+    const auto dot   = path.rfind('.');
+    const auto slash = path.rfind('/');
+    if (dot == std::string_view::npos || (slash != std::string_view::npos && dot < slash)) {
+        return kDefaultMimeType;
+    }
+    const std::string_view ext = path.substr(dot + 1);
+    for (const auto& entry : kMimeTypes) {
+        if (entry.extension.size() == ext.size() &&
+            std::equal(ext.begin(), ext.end(), entry.extension.begin(), [](char a, char b) {
+                return std::tolower(static_cast<unsigned char>(a)) == b;
+            })) {
+            return entry.type;
+        }
+    }
+    return kDefaultMimeType;
+}
+
+void formatHttpDate(std::time_t t, char (&out)[kHttpDateLength]) {
+    std::tm tm{};
+    ::gmtime_r(&t, &tm);
+    // 手工格式化：strftime 的 %a/%b 受 locale 影响
+    char* p = std::copy_n(kWeekdays[tm.tm_wday], 3, out);
+    *p++    = ',';
+    *p++    = ' ';
+    p       = putTwoDigits(p, tm.tm_mday);
+    *p++    = ' ';
+    p       = std::copy_n(kMonths[tm.tm_mon], 3, p);
+    *p++    = ' ';
+    p       = putTwoDigits(p, (tm.tm_year + 1900) / 100);
+    p       = putTwoDigits(p, (tm.tm_year + 1900) % 100);
+    *p++    = ' ';
+    p       = putTwoDigits(p, tm.tm_hour);
+    *p++    = ':';
+    p       = putTwoDigits(p, tm.tm_min);
+    *p++    = ':';
+    p       = putTwoDigits(p, tm.tm_sec);
+    std::copy_n(" GMT", 4, p);
+}
+
+std::string_view httpDate() {
+    struct Cache {
+        std::time_t second{-1};
+        char        text[kHttpDateLength];
+    };
+    thread_local Cache cache;
+
+    const std::time_t now = std::time(nullptr);
+    if (now != cache.second) {
+        formatHttpDate(now, cache.text);
+        cache.second = now;
+    }
+    return {cache.text, kHttpDateLength};
+}
+
+bool parseHttpDate(std::string_view text, std::time_t& out) {
+    // "Sun, 06 Nov 1994 08:49:37 GMT"
+    if (text.size() != kHttpDateLength || text.substr(3, 2) != ", " ||
+        text.substr(kHttpDateLength - 4) != " GMT") {
+        return false;
+    }
+    auto number = [text](size_t pos, size_t len, int& value) {
+        value = 0;
+        for (size_t i = pos; i < pos + len; ++i) {
+            if (text[i] < '0' || text[i] > '9') {
+                return false;
+            }
+            value = value * 10 + (text[i] - '0');
+        }
+        return true;
+    };
+    std::tm tm{};
+    int     year = 0;
+    if (!number(5, 2, tm.tm_mday) || !number(12, 4, year) || !number(17, 2, tm.tm_hour) ||
+        !number(20, 2, tm.tm_min) || !number(23, 2, tm.tm_sec) || text[7] != ' ' ||
+        text[11] != ' ' || text[16] != ' ' || text[19] != ':' || text[22] != ':') {
+        return false;
+    }
+    const auto month = std::find_if(std::begin(kMonths), std::end(kMonths), [text](const char* m) {
+        return text.substr(8, 3) == m;
+    });
+    if (month == std::end(kMonths)) {
+        return false;
+    }
+    tm.tm_mon  = static_cast<int>(month - std::begin(kMonths));
+    tm.tm_year = year - 1900;
+    out        = ::timegm(&tm);
+    return out != static_cast<std::time_t>(-1);
+}
+
+bool etagListMatches(std::string_view list, std::string_view etag) {
+    auto opaque = [](std::string_view tag) {
+        return tag.substr(0, 2) == "W/" ? tag.substr(2) : tag;
+    };
+    const std::string_view wanted = opaque(etag);
+    while (!list.empty()) {
+        const size_t     comma = list.find(',');
+        std::string_view item  = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+
+        const size_t first = item.find_first_not_of(" \t");
+        if (first == std::string_view::npos) {
+            continue;
+        }
+        item = item.substr(first, item.find_last_not_of(" \t") - first + 1);
+        if (item == "*" || (!wanted.empty() && opaque(item) == wanted)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool notModified(std::string_view ifNoneMatch,
+                 std::string_view ifModifiedSince,
+                 std::string_view etag,
+                 std::time_t      lastModified) {
+    if (!ifNoneMatch.empty()) {
+        return etagListMatches(ifNoneMatch, etag);
+    }
+    std::time_t since = 0;
+    return !ifModifiedSince.empty() && parseHttpDate(ifModifiedSince, since) &&
+           lastModified <= since;
+}
+
 }  // namespace Http
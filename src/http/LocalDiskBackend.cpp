@@ -0,0 +1,205 @@
+#include "http/LocalDiskBackend.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+#include "Log.hpp"
+#include "http/FileETag.hpp"
+
+namespace Http {
+
+namespace {
+void syncDirectory(const std::filesystem::path& dir) {
+    const int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0 || ::fsync(fd) != 0) {
+        LOG_WARN("failed to sync directory {}: {}", dir.string(), strerror(errno));
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+}  // namespace
+
+LocalDiskBackend::LocalDiskBackend(std::filesystem::path          root,
+                                   std::unique_ptr<BlobStore>     blobs,
+                                   std::unique_ptr<MetadataIndex> index)
+    : root_(std::move(root)), blobs_(std::move(blobs)), index_(std::move(index)) {}
+
+bool LocalDiskBackend::open(const std::string& name, Object& object, std::error_code& ec) {
+    MetadataIndex::Entry entry;
+    if (index_ && !index_->find(name, entry)) {
+        ec = std::make_error_code(std::errc::no_such_file_or_directory);
+        return false;
+    }
+    const std::filesystem::path path = index_ ? index_->pathOf(name, entry) : root_ / name;
+    const int                   fd   = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        ec.assign(errno, std::generic_category());
+        return false;
+    }
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ec = std::make_error_code(std::errc::no_such_file_or_directory);
+        ::close(fd);
+        return false;
+    }
+    object.fd         = fd;
+    object.info.size  = static_cast<uint64_t>(st.st_size);
+    object.info.mtime = st.st_mtime;
+    // 索引与文件相符时直接用其中的哈希；否则读取上传时随文件持久化的扩展属性
+    const bool indexed = index_ && entry.size == object.info.size && entry.mtime == st.st_mtime;
+    object.info.etag   = indexed ? formatETag(entry.digest) : fileETag(fd, st);
+    return true;
+}
+
+bool LocalDiskBackend::commit(UploadFile&      file,
+                              Durability       durability,
+                              ObjectInfo&      info,
+                              std::error_code& ec) {
+    const std::string           name   = file.name();
+    const std::filesystem::path target =
+        index_ ? shardedTarget(name, durability, ec) : root_ / name;
+    if (ec || (index_ && !index_->begin(name, durability, ec))) {
+        return false;
+    }
+    // 提交后 file 被重置，先取出大小与哈希
+    const uint64_t digest = file.digest();
+    info.size             = file.written();
+    info.etag             = formatETag(digest);
+    const bool stored     = blobs_ ? blobs_->commit(file, target, durability, ec)
+                                   : file.commit(target, durability, ec);
+    if (!stored) {
+        if (index_) {
+            index_->cancel(name);
+        }
+        return false;
+    }
+    // 去重命中时 mtime 是已有内容的 mtime
+    struct stat st{};
+    info.mtime = ::stat(target.c_str(), &st) == 0 ? st.st_mtime : std::time(nullptr);
+    if (index_) {
+        indexCommitted(name, digest, info);
+    }
+    return true;
+}
+
+bool LocalDiskBackend::place(const std::filesystem::path& source,
+                             const std::string&           name,
+                             Durability                   durability,
+                             ObjectInfo&                  info,
+                             std::error_code&             ec) {
+    const std::filesystem::path target =
+        index_ ? shardedTarget(name, durability, ec) : root_ / name;
+    if (ec || (index_ && !index_->begin(name, durability, ec))) {
+        return false;
+    }
+    const std::filesystem::path previous = blobs_ ? blobs_->referenced(target) : "";
+    std::filesystem::rename(source, target, ec);
+    if (ec) {
+        if (index_) {
+            index_->cancel(name);
+        }
+        return false;
+    }
+    if (durability == Durability::FULL) {
+        syncDirectory(target.parent_path());
+    }
+    // 没有边写边算的哈希：按提交前存入扩展属性的哈希并入去重存储
+    if (blobs_) {
+        blobs_->adopt(target, durability);
+        blobs_->collect(previous);
+    }
+    const int   fd     = ::open(target.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st{};
+    uint64_t    digest = 0;
+    const bool  hashed = fd >= 0 && ::fstat(fd, &st) == 0 && fileHash(fd, st, digest);
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    if (hashed) {
+        info.size  = static_cast<uint64_t>(st.st_size);
+        info.mtime = st.st_mtime;
+        info.etag  = formatETag(digest);
+    }
+    if (index_ && hashed) {
+        indexCommitted(name, digest, info);
+    } else if (index_) {
+        index_->cancel(name);  // 留在日志中的 "?" 让下次启动时核对
+    }
+    return true;
+}
+
+bool LocalDiskBackend::remove(const std::string& name, std::error_code& ec) {
+    MetadataIndex::Entry entry;
+    if (index_ && !index_->find(name, entry)) {
+        ec = std::make_error_code(std::errc::no_such_file_or_directory);
+        return false;
+    }
+    const std::filesystem::path target = index_ ? index_->pathOf(name, entry) : root_ / name;
+    // 删除与目录项一样不单独落盘，"?" 只用于进程崩溃后的核对
+    if (index_ && !index_->begin(name, Durability::NONE, ec)) {
+        return false;
+    }
+    // 去重存储中的内容随最后一个名字一起删除
+    const std::filesystem::path blob = blobs_ ? blobs_->referenced(target) : "";
+    if (::unlink(target.c_str()) != 0) {
+        ec.assign(errno, std::generic_category());
+        if (index_ && ec == std::errc::no_such_file_or_directory) {
+            index_->erase(name);  // 文件已在外部删除，索引随之更正
+        } else if (index_) {
+            index_->cancel(name);
+        }
+        return false;
+    }
+    if (index_) {
+        index_->erase(name);
+    }
+    if (blobs_) {
+        blobs_->collect(blob);
+    }
+    return true;
+}
+
+std::filesystem::path LocalDiskBackend::shardedTarget(const std::string& name,
+                                                      Durability         durability,
+                                                      std::error_code&   ec) const {
+    const std::filesystem::path dir = root_ / MetadataIndex::shardOf(name);
+    // 分片目录在第一次使用时创建，新目录项按持久性要求随上级目录落盘
+    if (std::filesystem::create_directories(dir, ec) && durability == Durability::FULL) {
+        syncDirectory(dir.parent_path());
+        syncDirectory(root_);
+    }
+    return ec ? std::filesystem::path{} : dir / name;
+}
+
+void LocalDiskBackend::indexCommitted(const std::string& name,
+                                      uint64_t           digest,
+                                      const ObjectInfo&  info) {
+    MetadataIndex::Entry previous;
+    const bool           existed = index_->find(name, previous);
+    MetadataIndex::Entry entry{info.size, info.mtime, digest, MetadataIndex::shardOf(name)};
+    const bool           moved = existed && previous.shard != entry.shard;
+    index_->put(name, std::move(entry));
+    // 覆盖启用分片之前的文件：新文件在分片中，根目录中的旧文件不再可见
+    if (moved) {
+        removeStale(index_->pathOf(name, previous));
+    }
+}
+
+void LocalDiskBackend::removeStale(const std::filesystem::path& path) {
+    const std::filesystem::path blob = blobs_ ? blobs_->referenced(path) : "";
+    if (::unlink(path.c_str()) != 0 && errno != ENOENT) {
+        LOG_WARN("failed to remove replaced file {}: {}", path.string(), strerror(errno));
+        return;
+    }
+    if (blobs_) {
+        blobs_->collect(blob);
+    }
+}
+
+}  // namespace Http
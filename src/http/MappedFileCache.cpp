@@ -0,0 +1,143 @@
+#include "http/MappedFileCache.hpp"
+
+#include <sys/mman.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "Log.hpp"
+#include "http/HttpUtils.hpp"
+
+namespace Http {
+
+MappedFileCache::Mapping::~Mapping() {
+    if (mapped && data != nullptr) {
+        ::munmap(const_cast<char*>(data), size);
+    }
+}
+
+MappedFileCache::MappedFileCache(size_t maxBytes) : maxBytes_(maxBytes) {}
+
+bool MappedFileCache::eligible(uint64_t size) const {
+    return size >= kMinBytes && size <= kMaxBytes && size <= maxBytes_ / 4;
+}
+
+MappedFileCache::MappingPtr MappedFileCache::map(int                fd,
+                                                 size_t             size,
+                                                 std::time_t        mtime,
+                                                 std::string        etag,
+                                                 const std::string& name) {
+    void* addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        LOG_WARN("failed to map {} ({} bytes): {}", name, size, strerror(errno));
+        return nullptr;
+    }
+    // 下载总是从前往后读：加大预读，并立即开始把尚未缓存的页读进来
+    if (::madvise(addr, size, MADV_SEQUENTIAL) != 0 || ::madvise(addr, size, MADV_WILLNEED) != 0) {
+        LOG_DEBUG("madvise on {} failed: {}", name, strerror(errno));
+    }
+
+    auto mapping    = std::make_shared<Mapping>();
+    mapping->data   = static_cast<const char*>(addr);
+    mapping->size   = size;
+    mapping->mtime  = mtime;
+    mapping->etag   = std::move(etag);
+    mapping->mapped = true;
+    char lastModified[kHttpDateLength];
+    formatHttpDate(mtime, lastModified);
+    mapping->lastModified.assign(lastModified, kHttpDateLength);
+    return mapping;
+}
+
+MappedFileCache::MappingPtr MappedFileCache::borrow(std::shared_ptr<const void> owner,
+                                                    std::string_view            bytes) {
+    auto mapping   = std::make_shared<Mapping>();
+    mapping->owner = std::move(owner);
+    mapping->data  = bytes.data();
+    mapping->size  = bytes.size();
+    return mapping;
+}
+
+MappedFileCache::MappingPtr MappedFileCache::fromBuffer(std::string bytes,
+                                                        std::time_t mtime,
+                                                        std::string etag) {
+    auto mapping    = std::make_shared<Mapping>();
+    mapping->buffer = std::move(bytes);
+    mapping->data   = mapping->buffer.data();  // 移入之后再取地址：短字符串存放在对象内部
+    mapping->size   = mapping->buffer.size();
+    mapping->mtime  = mtime;
+    mapping->etag   = std::move(etag);
+    char lastModified[kHttpDateLength];
+    formatHttpDate(mtime, lastModified);
+    mapping->lastModified.assign(lastModified, kHttpDateLength);
+    return mapping;
+}
+
+MappedFileCache::MappingPtr MappedFileCache::find(const std::string& name) {
+    auto it = entries_.find(name);
+    if (it == entries_.end()) {
+        ++stats_.misses;
+        return nullptr;
+    }
+    ++stats_.hits;
+    lru_.splice(lru_.begin(), lru_, it->second.lru);
+    return it->second.mapping;
+}
+
+void MappedFileCache::store(const std::string& name, MappingPtr mapping, uint64_t generation) {
+    if (!mapping || generation != generation_ || !eligible(mapping->size)) {
+        return;  // 映射期间文件可能已被替换，这次照常使用但不缓存
+    }
+    erase(name);
+    bytes_ += mapping->size;
+    lru_.push_front(name);
+    entries_[name] = Slot{std::move(mapping), lru_.begin()};
+    evict();
+}
+
+void MappedFileCache::invalidate(const std::string& name) {
+    ++generation_;
+    if (name.empty()) {
+        stats_.invalidations += entries_.size();
+        entries_.clear();
+        lru_.clear();
+        bytes_ = 0;
+        return;
+    }
+    if (entries_.count(name) != 0) {
+        ++stats_.invalidations;
+        erase(name);
+    }
+}
+
+void MappedFileCache::erase(const std::string& name) {
+    auto it = entries_.find(name);
+    if (it == entries_.end()) {
+        return;
+    }
+    bytes_ -= it->second.mapping->size;
+    lru_.erase(it->second.lru);
+    entries_.erase(it);  // 仍在发送的下载持有映射的引用，结束后才 munmap
+}
+
+void MappedFileCache::evict() {
+    while (bytes_ > maxBytes_ && !lru_.empty()) {
+        const std::string victim = lru_.back();
+        erase(victim);
+        ++stats_.evictions;
+    }
+}
+
+void MappedFileCache::setMaxBytes(size_t maxBytes) {
+    maxBytes_ = maxBytes;
+    evict();
+}
+
+MappedFileCache::Stats MappedFileCache::stats() const {
+    Stats out   = stats_;
+    out.entries = entries_.size();
+    out.bytes   = bytes_;
+    return out;
+}
+
+}  // namespace Http
@@ -0,0 +1,249 @@
+#include "http/MemoryBackend.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <ctime>
+
+#include "Log.hpp"
+#include "http/FileETag.hpp"
+#include "http/Hash64.hpp"
+
+namespace Http {
+
+namespace {
+// 读出 fd 的前 size 字节
+bool readAll(int fd, uint64_t size, std::string& out) {
+    out.resize(size);
+    size_t done = 0;
+    while (done < size) {
+        const ssize_t n = ::pread(fd, out.data() + done, size - done, static_cast<off_t>(done));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;  // 读错误，或文件在读取期间被截短
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+StorageBackend::ObjectInfo infoOf(const MappedFileCache::Mapping& object) {
+    return {object.size, object.mtime, object.etag};
+}
+}  // namespace
+
+MemoryBackend::MemoryBackend(size_t                          maxBytes,
+                             std::unique_ptr<StorageBackend> lower,
+                             uint64_t                        maxObjectBytes)
+    : maxBytes_(maxBytes), maxObjectBytes_(maxObjectBytes), lower_(std::move(lower)) {}
+
+bool MemoryBackend::open(const std::string& name, Object& object, std::error_code& ec) {
+    uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto                        it = entries_.find(name);
+        if (it != entries_.end()) {
+            ++stats_.hits;
+            lru_.splice(lru_.begin(), lru_, it->second.lru);
+            object.memory = it->second.object;
+            object.info   = infoOf(*object.memory);
+            return true;
+        }
+        ++stats_.misses;
+        generation = generation_;
+    }
+    if (!lower_) {
+        ec = std::make_error_code(std::errc::no_such_file_or_directory);
+        return false;
+    }
+    if (!lower_->open(name, object, ec)) {
+        return false;
+    }
+    // 大文件与不能独占预算四分之一的文件不提升，照常从 fd 发送
+    if (object.fd < 0 || object.info.size > maxObjectBytes_ || object.info.size > maxBytes_ / 4) {
+        return true;
+    }
+    std::string bytes;
+    if (!readAll(object.fd, object.info.size, bytes)) {
+        return true;
+    }
+    ::close(object.fd);
+    object.fd     = -1;
+    object.memory =
+        MappedFileCache::fromBuffer(std::move(bytes), object.info.mtime, object.info.etag);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (generation == generation_) {  // 读取期间对象可能已被替换：这次照常使用但不保留
+        insertLocked(name, object.memory);
+        ++stats_.promotions;
+        evictLocked();
+    }
+    return true;
+}
+
+bool MemoryBackend::commit(UploadFile&      file,
+                           Durability       durability,
+                           ObjectInfo&      info,
+                           std::error_code& ec) {
+    const std::string name = file.name();
+    if (lower_) {
+        const bool ok = lower_->commit(file, durability, info, ec);
+        invalidate(name);
+        return ok;
+    }
+    // 唯一存储：临时文件读回内存后删除，没有需要落盘的东西
+    const uint64_t digest = file.digest();
+    std::string    bytes;
+    const int      fd = ::open(file.tempPath().c_str(), O_RDONLY | O_CLOEXEC);
+    const bool     ok = fd >= 0 && readAll(fd, file.written(), bytes);
+    ec.assign(ok ? 0 : errno, std::generic_category());
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    file.abort();
+    // 之前的异步写入失败时，读回的内容与边写边算的哈希不符
+    if (!ok || Hash64::of(bytes) != digest) {
+        if (!ec) {
+            ec = std::make_error_code(std::errc::io_error);
+        }
+        return false;
+    }
+    info.size  = bytes.size();
+    info.mtime = std::time(nullptr);
+    info.etag  = formatETag(digest);
+    return store(name, MappedFileCache::fromBuffer(std::move(bytes), info.mtime, info.etag), ec);
+}
+
+bool MemoryBackend::place(const std::filesystem::path& source,
+                          const std::string&           name,
+                          Durability                   durability,
+                          ObjectInfo&                  info,
+                          std::error_code&             ec) {
+    if (lower_) {
+        const bool ok = lower_->place(source, name, durability, info, ec);
+        invalidate(name);
+        return ok;
+    }
+    const int   fd = ::open(source.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st{};
+    std::string bytes;
+    if (fd < 0 || ::fstat(fd, &st) != 0 ||
+        !readAll(fd, static_cast<uint64_t>(st.st_size), bytes)) {
+        ec.assign(errno, std::generic_category());
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return false;
+    }
+    info.size  = bytes.size();
+    info.mtime = st.st_mtime;
+    info.etag  = fileETag(fd, st);  // 续传会话提交前已算好并存入扩展属性
+    ::close(fd);
+    if (!store(name, MappedFileCache::fromBuffer(std::move(bytes), info.mtime, info.etag), ec)) {
+        return false;
+    }
+    ::unlink(source.c_str());
+    return true;
+}
+
+bool MemoryBackend::remove(const std::string& name, std::error_code& ec) {
+    if (lower_) {
+        const bool ok = lower_->remove(name, ec);
+        invalidate(name);
+        return ok;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entries_.count(name) == 0) {
+        ec = std::make_error_code(std::errc::no_such_file_or_directory);
+        return false;
+    }
+    eraseLocked(name);
+    ++generation_;
+    return true;
+}
+
+MappedFileCache::MappingPtr MemoryBackend::cached(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto                        it = entries_.find(name);
+    if (it == entries_.end()) {
+        return nullptr;  // 未命中由随后的 open() 计数
+    }
+    ++stats_.hits;
+    lru_.splice(lru_.begin(), lru_, it->second.lru);
+    return it->second.object;
+}
+
+void MemoryBackend::invalidate(const std::string& name) {
+    if (!lower_) {
+        return;  // 唯一存储中的对象只由提交与删除改变
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++generation_;
+    if (name.empty()) {
+        entries_.clear();
+        lru_.clear();
+        bytes_ = 0;
+        return;
+    }
+    eraseLocked(name);
+}
+
+bool MemoryBackend::store(const std::string&          name,
+                          MappedFileCache::MappingPtr object,
+                          std::error_code&            ec) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto                        it       = entries_.find(name);
+    const size_t                replaced = it == entries_.end() ? 0 : it->second.object->size;
+    if (bytes_ - replaced + object->size > maxBytes_) {
+        ++stats_.rejected;
+        LOG_WARN("memory store full: {} ({} bytes) rejected, {} of {} bytes used",
+                 name,
+                 object->size,
+                 bytes_,
+                 maxBytes_);
+        ec = std::make_error_code(std::errc::no_space_on_device);
+        return false;
+    }
+    insertLocked(name, std::move(object));
+    ++generation_;
+    return true;
+}
+
+void MemoryBackend::insertLocked(const std::string& name, MappedFileCache::MappingPtr object) {
+    eraseLocked(name);
+    bytes_ += object->size;
+    lru_.push_front(name);
+    entries_[name] = Slot{std::move(object), lru_.begin()};
+}
+
+void MemoryBackend::eraseLocked(const std::string& name) {
+    auto it = entries_.find(name);
+    if (it == entries_.end()) {
+        return;
+    }
+    bytes_ -= it->second.object->size;
+    lru_.erase(it->second.lru);
+    entries_.erase(it);
+}
+
+void MemoryBackend::evictLocked() {
+    while (bytes_ > maxBytes_ && !lru_.empty()) {
+        const std::string victim = lru_.back();
+        eraseLocked(victim);
+        ++stats_.evictions;
+    }
+}
+
+MemoryBackend::Stats MemoryBackend::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats                       s = stats_;
+    s.entries                     = entries_.size();
+    s.bytes                       = bytes_;
+    return s;
+}
+
+}  // namespace Http
@@ -0,0 +1,440 @@
+#include "http/MetadataIndex.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <charconv>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <unordered_set>
+#include <vector>
+
+#include "Log.hpp"
+#include "http/FileETag.hpp"
+#include "http/Hash64.hpp"
+
+namespace Http {
+
+namespace {
+constexpr mode_t           kFileMode  = 0644;
+constexpr std::string_view kLogMagic  = "fsindex 1\n";
+constexpr std::string_view kRootShard = ".";
+// 失效记录超过该数量且多于有效条目时才压缩，小规模的存储不会频繁重写
+constexpr uint64_t kCompactSlack  = 64 * 1024;
+constexpr size_t   kSnapshotChunk = 1024 * 1024;
+
+bool writeAll(int fd, std::string_view data) {
+    while (!data.empty()) {
+        const ssize_t n = ::write(fd, data.data(), data.size());
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data.remove_prefix(static_cast<size_t>(n));
+    }
+    return true;
+}
+
+void syncDirectory(const std::filesystem::path& dir) {
+    const int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0 || ::fsync(fd) != 0) {
+        LOG_WARN("failed to sync directory {}: {}", dir.string(), strerror(errno));
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+// 从 text 开头取一个数并跳过其后的一个分隔符
+template <typename T>
+bool takeNumber(std::string_view& text, char separator, T& value, int base = 10) {
+    const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value, base);
+    if (ec != std::errc{} || ptr == text.data() + text.size() || *ptr != separator) {
+        return false;
+    }
+    text.remove_prefix(static_cast<size_t>(ptr - text.data()) + 1);
+    return true;
+}
+
+// "<名字长度> <名字>\n"
+bool takeName(std::string_view& text, std::string& name) {
+    size_t length = 0;
+    if (!takeNumber(text, ' ', length) || text.size() <= length || text[length] != '\n') {
+        return false;
+    }
+    name.assign(text.substr(0, length));
+    text.remove_prefix(length + 1);
+    return !name.empty();
+}
+
+void appendName(std::string& out, const std::string& name) {
+    out.append(std::to_string(name.size())).append(1, ' ').append(name).append(1, '\n');
+}
+
+void appendPut(std::string& out, const std::string& name, const MetadataIndex::Entry& entry) {
+    char head[96];
+    std::snprintf(head,
+                  sizeof(head),
+                  "+ %" PRIu64 " %lld %016" PRIx64 " ",
+                  entry.size,
+                  static_cast<long long>(entry.mtime),
+                  entry.digest);
+    out.append(head);
+    out.append(entry.shard.empty() ? kRootShard : std::string_view{entry.shard}).append(1, ' ');
+    appendName(out, name);
+}
+
+// 三个小写十六进制字符，即 shardOf() 产生的目录名
+bool isShardName(const std::string& name) {
+    auto hex = [](char c) { return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'); };
+    return name.size() == 3 && hex(name[0]) && hex(name[1]) && hex(name[2]);
+}
+
+bool readFile(const std::filesystem::path& path, std::string& content) {
+    const int   fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st{};
+    if (fd < 0 || ::fstat(fd, &st) != 0) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return false;
+    }
+    content.resize(static_cast<size_t>(st.st_size));
+    size_t done = 0;
+    while (done < content.size()) {
+        const ssize_t n = ::read(fd, content.data() + done, content.size() - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        done += static_cast<size_t>(n);
+    }
+    ::close(fd);
+    content.resize(done);
+    return true;
+}
+}  // namespace
+
+MetadataIndex::MetadataIndex(std::filesystem::path root, std::filesystem::path dir)
+    : root_(std::move(root)), dir_(std::move(dir)) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+
+    std::vector<std::string> unresolved;
+    if (!load(unresolved)) {
+        rebuild();
+    }
+    logFd_ = ::open(logPath().c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, kFileMode);
+    if (logFd_ < 0) {
+        LOG_ERROR("failed to open metadata index {}: {}", logPath().string(), strerror(errno));
+    }
+    // 崩溃时进行中的修改：只有这些名字需要访问磁盘
+    for (const auto& name : unresolved) {
+        verify(name);
+    }
+    std::lock_guard<std::mutex> lock(logMutex_);
+    maybeCompactLocked();
+    LOG_INFO("metadata index of {} loaded: {} files, {} interrupted changes checked",
+             root_.string(),
+             entries_.size(),
+             unresolved.size());
+}
+
+MetadataIndex::~MetadataIndex() {
+    if (logFd_ >= 0) {
+        ::close(logFd_);
+    }
+}
+
+std::string MetadataIndex::shardOf(std::string_view name) {
+    const uint64_t hash = Hash64::of(name);
+    char           shard[8];
+    std::snprintf(shard, sizeof(shard), "%03x", static_cast<unsigned>(hash >> 52));
+    return shard;
+}
+
+std::filesystem::path MetadataIndex::logPath() const {
+    return dir_ / "files.log";
+}
+
+std::filesystem::path MetadataIndex::pathOf(const std::string& name, const Entry& entry) const {
+    return entry.shard.empty() ? root_ / name : root_ / entry.shard / name;
+}
+
+bool MetadataIndex::load(std::vector<std::string>& unresolved) {
+    std::string content;
+    if (!readFile(logPath(), content)) {
+        return false;
+    }
+    std::string_view text = content;
+    if (text.substr(0, kLogMagic.size()) != kLogMagic) {
+        LOG_WARN("metadata index {} has a corrupt header, rebuilding", logPath().string());
+        return false;
+    }
+    text.remove_prefix(kLogMagic.size());
+
+    // 最后一条记录为 "?" 的名字；正常情况下为空，"+"、"-" 不必查找
+    std::unordered_set<std::string> changing;
+    std::string                     name;
+    entries_.reserve(content.size() / 64);
+    while (text.size() > 2 && text[1] == ' ') {
+        std::string_view rest = text.substr(2);
+        const char       op   = text[0];
+        if (op == '+') {
+            Entry       entry;
+            std::string shard;
+            size_t      space = 0;
+            if (!takeNumber(rest, ' ', entry.size) || !takeNumber(rest, ' ', entry.mtime) ||
+                !takeNumber(rest, ' ', entry.digest, 16) ||
+                (space = rest.find(' ')) == std::string_view::npos) {
+                break;
+            }
+            shard.assign(rest.substr(0, space));
+            rest.remove_prefix(space + 1);
+            if (!takeName(rest, name)) {
+                break;
+            }
+            entry.shard = shard == kRootShard ? std::string{} : std::move(shard);
+            if (!changing.empty()) {
+                changing.erase(name);
+            }
+            entries_.insert_or_assign(std::move(name), std::move(entry));
+            ++records_;
+        } else if (op == '-' || op == '?') {
+            if (!takeName(rest, name)) {
+                break;
+            }
+            if (op == '?') {
+                changing.insert(name);
+            } else {
+                if (!changing.empty()) {
+                    changing.erase(name);
+                }
+                entries_.erase(name);
+                ++records_;
+            }
+        } else {
+            break;
+        }
+        text = rest;
+    }
+    // 崩溃时可能留下不完整的最后一条记录：截掉，之后的追加从完整记录之后开始
+    if (!text.empty()) {
+        LOG_WARN("metadata index {}: dropping {} bytes of incomplete records",
+                 logPath().string(),
+                 text.size());
+        if (::truncate(logPath().c_str(), static_cast<off_t>(content.size() - text.size())) != 0) {
+            LOG_WARN("failed to truncate {}: {}", logPath().string(), strerror(errno));
+            return false;
+        }
+    }
+    unresolved.assign(changing.begin(), changing.end());
+    return true;
+}
+
+void MetadataIndex::rebuild() {
+    entries_.clear();
+    std::error_code ec;
+    Entry           entry;
+    // 根目录中的文件（启用分片之前上传的）
+    for (const auto& file : std::filesystem::directory_iterator(root_, ec)) {
+        const std::string name = file.path().filename().string();
+        if (probe(name, {}, entry)) {
+            entries_.emplace(name, entry);
+        }
+    }
+    // 分片目录中的文件，与根目录同名时以分片中的为准
+    for (const auto& dir : std::filesystem::directory_iterator(root_, ec)) {
+        const std::string shard = dir.path().filename().string();
+        if (!isShardName(shard) || !dir.is_directory(ec)) {
+            continue;
+        }
+        for (const auto& file : std::filesystem::directory_iterator(dir.path(), ec)) {
+            const std::string name = file.path().filename().string();
+            if (probe(name, shard, entry)) {
+                entries_[name] = entry;
+            }
+        }
+    }
+    LOG_INFO("metadata index of {} rebuilt by scanning: {} files", root_.string(), entries_.size());
+    std::lock_guard<std::mutex> lock(logMutex_);
+    writeSnapshotLocked();
+}
+
+bool MetadataIndex::probe(const std::string& name, const std::string& shard, Entry& entry) const {
+    const std::filesystem::path path = shard.empty() ? root_ / name : root_ / shard / name;
+    const int                   fd   = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st{};
+    const bool  ok = ::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && fileHash(fd, st, entry.digest);
+    ::close(fd);
+    if (!ok) {
+        return false;
+    }
+    entry.size  = static_cast<uint64_t>(st.st_size);
+    entry.mtime = st.st_mtime;
+    entry.shard = shard;
+    return true;
+}
+
+void MetadataIndex::verify(const std::string& name) {
+    // 覆盖根目录中的旧文件时，新文件在分片中；先看新位置
+    Entry       entry;
+    std::string previous;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto                        it = entries_.find(name);
+        if (it != entries_.end()) {
+            previous = it->second.shard;
+        }
+    }
+    const std::string shard = shardOf(name);
+    if (probe(name, shard, entry) || (previous != shard && probe(name, previous, entry))) {
+        put(name, std::move(entry));
+    } else {
+        erase(name);
+    }
+}
+
+bool MetadataIndex::find(const std::string& name, Entry& entry) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto                        it = entries_.find(name);
+    if (it == entries_.end()) {
+        return false;
+    }
+    entry = it->second;
+    return true;
+}
+
+bool MetadataIndex::begin(const std::string& name, Durability durability, std::error_code& ec) {
+    std::string record = "? ";
+    appendName(record, name);
+    std::lock_guard<std::mutex> lock(logMutex_);
+    // 先让 "?" 落盘再动文件：崩溃后这个名字一定会被核对
+    if (logFd_ < 0 || !writeAll(logFd_, record) ||
+        (durability != Durability::NONE && ::fdatasync(logFd_) != 0)) {
+        ec.assign(logFd_ < 0 ? EBADF : errno, std::generic_category());
+        return false;
+    }
+    ++pending_[name];
+    return true;
+}
+
+void MetadataIndex::put(const std::string& name, Entry entry) {
+    std::string record;
+    appendPut(record, name, entry);
+    std::lock_guard<std::mutex> lock(logMutex_);
+    append(record);
+    {
+        std::lock_guard<std::mutex> entriesLock(mutex_);
+        entries_[name] = std::move(entry);
+    }
+    ++records_;
+    finishLocked(name);
+    maybeCompactLocked();
+}
+
+void MetadataIndex::erase(const std::string& name) {
+    std::string record = "- ";
+    appendName(record, name);
+    std::lock_guard<std::mutex> lock(logMutex_);
+    append(record);
+    {
+        std::lock_guard<std::mutex> entriesLock(mutex_);
+        entries_.erase(name);
+    }
+    ++records_;
+    finishLocked(name);
+    maybeCompactLocked();
+}
+
+void MetadataIndex::cancel(const std::string& name) {
+    // 日志中留下的 "?" 无害：崩溃后多核对一次，下次压缩时消失
+    std::lock_guard<std::mutex> lock(logMutex_);
+    finishLocked(name);
+}
+
+size_t MetadataIndex::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+void MetadataIndex::forEach(
+    const std::function<void(const std::string&, const Entry&)>& fn) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [name, entry] : entries_) {
+        fn(name, entry);
+    }
+}
+
+void MetadataIndex::append(const std::string& record) {
+    // 结果记录不单独落盘：丢失时前面的 "?" 让启动时核对这个名字
+    if (logFd_ < 0 || !writeAll(logFd_, record)) {
+        LOG_WARN("failed to append to metadata index {}: {}",
+                 logPath().string(),
+                 strerror(logFd_ < 0 ? EBADF : errno));
+    }
+}
+
+void MetadataIndex::finishLocked(const std::string& name) {
+    auto it = pending_.find(name);
+    if (it != pending_.end() && --it->second == 0) {
+        pending_.erase(it);
+    }
+}
+
+void MetadataIndex::maybeCompactLocked() {
+    if (records_ >= 2 * entries_.size() + kCompactSlack) {
+        writeSnapshotLocked();
+    }
+}
+
+bool MetadataIndex::writeSnapshotLocked() {
+    // 持有 logMutex_ 时条目不会变化，遍历无需 mutex_，查找不受影响
+    const std::filesystem::path tmp = dir_ / "files.log.tmp";
+    const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, kFileMode);
+    bool      ok = fd >= 0;
+    std::string buf{kLogMagic};
+    for (const auto& [name, entry] : entries_) {
+        appendPut(buf, name, entry);
+        if (buf.size() >= kSnapshotChunk) {
+            ok = ok && writeAll(fd, buf);
+            buf.clear();
+        }
+    }
+    for (const auto& [name, count] : pending_) {
+        buf.append("? ");
+        appendName(buf, name);
+    }
+    ok = ok && writeAll(fd, buf) && ::fdatasync(fd) == 0;
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    if (!ok || ::rename(tmp.c_str(), logPath().c_str()) != 0) {
+        LOG_WARN("failed to write metadata index snapshot {}: {}", tmp.string(), strerror(errno));
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    syncDirectory(dir_);
+    if (logFd_ >= 0) {
+        ::close(logFd_);
+        logFd_ = ::open(logPath().c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    }
+    LOG_INFO("metadata index {} compacted: {} records -> {} files",
+             logPath().string(),
+             records_,
+             entries_.size());
+    records_ = entries_.size();
+    return true;
+}
+
+}  // namespace Http
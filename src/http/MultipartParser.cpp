@@ -0,0 +1,283 @@
+#include "http/MultipartParser.hpp"
+
+#include <cstring>
+
+#include "http/HttpHeaders.hpp"
+
+namespace Http {
+
+namespace {
+constexpr std::string_view kFormData        = "multipart/form-data";
+constexpr size_t           kMaxBoundarySize = 70;  // RFC 2046
+constexpr std::string_view kCrlf            = "\r\n";
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+// 取 "type; key=value; key2="quoted"" 中 key 的值（参数名不区分大小写）；不存在时返回 false
+bool headerParam(std::string_view header, std::string_view key, std::string& out) {
+    size_t pos = header.find(';');
+    while (pos != std::string_view::npos && pos < header.size()) {
+        ++pos;  // 跳过 ';'
+        const size_t eq   = header.find('=', pos);
+        const size_t semi = header.find(';', pos);
+        if (eq == std::string_view::npos || (semi != std::string_view::npos && semi < eq)) {
+            pos = semi;  // 没有值的参数
+            continue;
+        }
+        const std::string_view name = trim(header.substr(pos, eq - pos));
+        std::string            value;
+        size_t                 i = eq + 1;
+        while (i < header.size() && (header[i] == ' ' || header[i] == '\t')) {
+            ++i;
+        }
+        if (i < header.size() && header[i] == '"') {
+            // 引号字符串：反斜杠转义下一个字符
+            for (++i; i < header.size() && header[i] != '"'; ++i) {
+                if (header[i] == '\\' && i + 1 < header.size()) {
+                    ++i;
+                }
+                value.push_back(header[i]);
+            }
+            pos = header.find(';', i);
+        } else {
+            const size_t end = header.find(';', i);
+            value.assign(trim(header.substr(i, end == std::string_view::npos ? end : end - i)));
+            pos = end;
+        }
+        if (detail::iequals(name, key)) {
+            out = std::move(value);
+            return true;
+        }
+    }
+    return false;
+}
+
+// 浏览器（HTML 表单编码规则）把名字中的 '"'、CR、LF 写成 %22、%0D、%0A，其余字节原样发送
+std::string unescapeFormName(std::string_view name) {
+    std::string out;
+    out.reserve(name.size());
+    for (size_t i = 0; i < name.size(); ++i) {
+        const std::string_view escape = name.substr(i, 3);
+        if (escape == "%22") {
+            out.push_back('"');
+        } else if (escape == "%0D") {
+            out.push_back('\r');
+        } else if (escape == "%0A") {
+            out.push_back('\n');
+        } else {
+            out.push_back(name[i]);
+            continue;
+        }
+        i += 2;
+    }
+    return out;
+}
+}  // namespace
+
+std::string MultipartParser::boundaryOf(std::string_view contentType) {
+    const std::string_view type = trim(contentType.substr(0, contentType.find(';')));
+    std::string            boundary;
+    if (!detail::iequals(type, kFormData) || !headerParam(contentType, "boundary", boundary) ||
+        boundary.empty() || boundary.size() > kMaxBoundarySize) {
+        return {};
+    }
+    return boundary;
+}
+
+MultipartParser::MultipartParser(std::string_view boundary)
+    : delimiter_(std::string{kCrlf} + "--" + std::string{boundary})
+    , pending_(kCrlf) {  // 第一个分隔符前没有 CRLF，补上后与其余分隔符统一查找
+    const size_t m = delimiter_.size();
+    for (auto& skip : skip_) {
+        skip = m;
+    }
+    for (size_t i = 0; i + 1 < m; ++i) {
+        skip_[static_cast<unsigned char>(delimiter_[i])] = m - 1 - i;
+    }
+}
+
+size_t MultipartParser::findDelimiter(std::string_view data) const {
+    const size_t m = delimiter_.size();
+    if (data.size() < m) {
+        return std::string_view::npos;
+    }
+    // Horspool：比较窗口末字节，不匹配时按坏字符表跳过，随机数据上每次约跳过整个分隔符长度
+    const char last = delimiter_[m - 1];
+    for (size_t pos = 0; pos + m <= data.size();) {
+        const char c = data[pos + m - 1];
+        if (c == last && std::memcmp(data.data() + pos, delimiter_.data(), m - 1) == 0) {
+            return pos;
+        }
+        pos += skip_[static_cast<unsigned char>(c)];
+    }
+    return std::string_view::npos;
+}
+
+size_t MultipartParser::partialDelimiter(std::string_view data) const {
+    const size_t m     = delimiter_.size();
+    size_t       start = data.size() >= m ? data.size() - m + 1 : 0;
+    while (start < data.size()) {
+        const void* cr = std::memchr(data.data() + start, '\r', data.size() - start);
+        if (cr == nullptr) {
+            break;
+        }
+        start = static_cast<size_t>(static_cast<const char*>(cr) - data.data());
+        if (delimiter_.compare(0, data.size() - start, data.substr(start)) == 0) {
+            return start;
+        }
+        ++start;
+    }
+    return data.size();
+}
+
+bool MultipartParser::feed(std::string_view data) {
+    if (state_ == State::FAILED) {
+        return false;
+    }
+    if (pending_.empty()) {
+        // 常见情况：上次没有剩余，直接处理调用方的数据，只复制未消费的尾部
+        const size_t consumed = process(data);
+        pending_.assign(data.substr(consumed));
+    } else {
+        pending_.append(data);
+        const size_t consumed = process(pending_);
+        pending_.erase(0, consumed);
+    }
+    if (state_ == State::DONE) {
+        pending_.clear();  // 尾声
+    }
+    return state_ != State::FAILED;
+}
+
+size_t MultipartParser::process(std::string_view data) {
+    const size_t m        = delimiter_.size();
+    size_t       consumed = 0;
+    while (true) {
+        const std::string_view rest = data.substr(consumed);
+        switch (state_) {
+            case State::PREAMBLE: {
+                const size_t pos = findDelimiter(rest);
+                if (pos == std::string_view::npos) {
+                    return consumed + partialDelimiter(rest);  // 前言直接丢弃
+                }
+                consumed += pos + m;
+                state_ = State::AFTER_DELIMITER;
+                break;
+            }
+            case State::AFTER_DELIMITER: {
+                if (rest.size() < 2) {
+                    return consumed;
+                }
+                if (rest.substr(0, 2) == "--") {
+                    state_ = State::DONE;
+                    return data.size();
+                }
+                const size_t eol = rest.find(kCrlf);
+                if (eol == std::string_view::npos) {
+                    if (rest.size() > kMaxHeaderBytes) {
+                        state_ = State::FAILED;
+                    }
+                    return consumed;
+                }
+                // 分隔符与换行之间只允许空白
+                if (!trim(rest.substr(0, eol)).empty()) {
+                    state_ = State::FAILED;
+                    return consumed;
+                }
+                consumed += eol + kCrlf.size();
+                part_        = Part{};
+                headerBytes_ = 0;
+                state_       = State::HEADERS;
+                break;
+            }
+            case State::HEADERS: {
+                const size_t eol = rest.find(kCrlf);
+                if (eol == std::string_view::npos) {
+                    if (headerBytes_ + rest.size() > kMaxHeaderBytes) {
+                        state_ = State::FAILED;
+                    }
+                    return consumed;
+                }
+                headerBytes_ += eol + kCrlf.size();
+                if (headerBytes_ > kMaxHeaderBytes) {
+                    state_ = State::FAILED;
+                    return consumed;
+                }
+                const std::string_view line = rest.substr(0, eol);
+                consumed += eol + kCrlf.size();
+                if (!line.empty()) {
+                    if (!parseHeaderLine(line)) {
+                        state_ = State::FAILED;
+                        return consumed;
+                    }
+                    break;
+                }
+                // 空行：头部结束
+                if (onPartBegin_ && !onPartBegin_(part_)) {
+                    state_ = State::FAILED;
+                    return consumed;
+                }
+                state_ = State::BODY;
+                break;
+            }
+            case State::BODY: {
+                const size_t pos = findDelimiter(rest);
+                if (pos == std::string_view::npos) {
+                    // 除了可能是分隔符开头的尾部，其余内容立即交出
+                    const size_t n = partialDelimiter(rest);
+                    if (n > 0 && onPartData_ && !onPartData_(rest.substr(0, n))) {
+                        state_ = State::FAILED;
+                    }
+                    return consumed + n;
+                }
+                if ((pos > 0 && onPartData_ && !onPartData_(rest.substr(0, pos))) ||
+                    (onPartEnd_ && !onPartEnd_())) {
+                    state_ = State::FAILED;
+                    return consumed;
+                }
+                consumed += pos + m;
+                state_ = State::AFTER_DELIMITER;
+                break;
+            }
+            case State::DONE:
+                return data.size();
+            case State::FAILED:
+                return consumed;
+        }
+    }
+}
+
+bool MultipartParser::parseHeaderLine(std::string_view line) {
+    const size_t colon = line.find(':');
+    if (colon == std::string_view::npos || colon == 0) {
+        return false;
+    }
+    const std::string_view name  = trim(line.substr(0, colon));
+    const std::string_view value = trim(line.substr(colon + 1));
+    switch (headerId(name)) {
+        case HeaderId::CONTENT_DISPOSITION:
+            if (headerParam(value, "name", part_.name)) {
+                part_.name = unescapeFormName(part_.name);
+            }
+            if (headerParam(value, "filename", part_.filename)) {
+                part_.filename = unescapeFormName(part_.filename);
+            }
+            break;
+        case HeaderId::CONTENT_TYPE:
+            part_.contentType.assign(value);
+            break;
+        default:
+            break;  // 其他头部（如 Content-Transfer-Encoding）不影响落盘
+    }
+    return true;
+}
+
+}  // namespace Http
@@ -0,0 +1,177 @@
+#include "http/Router.hpp"
+
+#include <stdexcept>
+
+namespace Http {
+
+struct Router::Node {
+    enum class Kind { STATIC, PARAM, CATCH_ALL };
+
+    Kind        kind{Kind::STATIC};
+    std::string prefix;     // STATIC：本节点匹配的字面量
+    std::string paramName;  // PARAM / CATCH_ALL
+
+    std::string                        indices;   // 各静态子节点 prefix 的首字符，与 children 对齐
+    std::vector<std::unique_ptr<Node>> children;  // 静态子节点，首字符互不相同
+    std::unique_ptr<Node>              param;
+    std::unique_ptr<Node>              catchAll;
+
+    std::vector<std::pair<std::string, Handler>> handlers;  // 方法 → 处理函数
+    std::string                                  allow;
+};
+
+namespace {
+
+size_t commonPrefix(std::string_view a, std::string_view b) {
+    size_t i = 0;
+    while (i < a.size() && i < b.size() && a[i] == b[i]) {
+        ++i;
+    }
+    return i;
+}
+
+}  // namespace
+
+std::string_view RouteParams::get(std::string_view name) const {
+    for (size_t i = 0; i < count_; ++i) {
+        if (items_[i].first == name) {
+            return items_[i].second;
+        }
+    }
+    return {};
+}
+
+Router::Router() : root_(std::make_unique<Node>()) {}
+
+Router::~Router() = default;
+
+void Router::add(std::string_view method, std::string_view pattern, Handler handler) {
+    if (method.empty() || pattern.empty() || pattern.front() != '/') {
+        throw std::invalid_argument("Router: pattern must start with '/': " + std::string{pattern});
+    }
+
+    Node*  node       = root_.get();
+    size_t paramCount = 0;
+    for (std::string_view rest = pattern; !rest.empty();) {
+        if (rest.front() == ':' || rest.front() == '*') {
+            const bool  catchAll = rest.front() == '*';
+            const auto  end      = catchAll ? rest.size() : rest.find('/');
+            std::string name{rest.substr(1, end == std::string_view::npos ? end : end - 1)};
+            if (name.empty() || ++paramCount > RouteParams::kMaxParams) {
+                throw std::invalid_argument("Router: bad parameter in " + std::string{pattern});
+            }
+            auto& slot = catchAll ? node->catchAll : node->param;
+            if (!slot) {
+                slot            = std::make_unique<Node>();
+                slot->kind      = catchAll ? Node::Kind::CATCH_ALL : Node::Kind::PARAM;
+                slot->paramName = std::move(name);
+            } else if (slot->paramName != name) {
+                throw std::invalid_argument("Router: conflicting parameter name in " +
+                                            std::string{pattern});
+            }
+            node = slot.get();
+            rest = (end == std::string_view::npos) ? std::string_view{} : rest.substr(end);
+            continue;
+        }
+        const auto end = rest.find_first_of(":*");
+        node           = insertStatic(node, rest.substr(0, end));
+        rest           = (end == std::string_view::npos) ? std::string_view{} : rest.substr(end);
+    }
+
+    for (const auto& [registered, ignored] : node->handlers) {
+        if (registered == method) {
+            throw std::invalid_argument("Router: duplicate route " + std::string{method} + " " +
+                                        std::string{pattern});
+        }
+    }
+    node->handlers.emplace_back(std::string{method}, std::move(handler));
+    if (!node->allow.empty()) {
+        node->allow.append(", ");
+    }
+    node->allow.append(method);
+}
+
+Router::Node* Router::insertStatic(Node* node, std::string_view text) {
+    while (!text.empty()) {
+        const auto pos = node->indices.find(text.front());
+        if (pos == std::string::npos) {
+            auto child    = std::make_unique<Node>();
+            child->prefix = std::string{text};
+            Node* raw     = child.get();
+            node->indices.push_back(text.front());
+            node->children.push_back(std::move(child));
+            return raw;
+        }
+
+        auto&        child = node->children[pos];
+        const size_t len   = commonPrefix(child->prefix, text);
+        if (len < child->prefix.size()) {
+            // 拆分：公共部分成为新的中间节点，原节点挂在其下
+            auto mid    = std::make_unique<Node>();
+            mid->prefix = child->prefix.substr(0, len);
+            child->prefix.erase(0, len);
+            mid->indices.push_back(child->prefix.front());
+            mid->children.push_back(std::move(child));
+            child = std::move(mid);
+        }
+        node = child.get();
+        text.remove_prefix(len);
+    }
+    return node;
+}
+
+Router::Match Router::match(std::string_view method, std::string_view path) const {
+    Match       result;
+    const Node* node = lookup(*root_, path, result.params);
+    if (node == nullptr) {
+        return result;
+    }
+    result.pathFound = true;
+    result.allow     = node->allow;
+    for (const auto& [registered, handler] : node->handlers) {
+        if (registered == method) {
+            result.handler = &handler;
+            break;
+        }
+    }
+    return result;
+}
+
+// path 为 node 自身匹配之后剩余的部分
+const Router::Node* Router::lookup(const Node&      node,
+                                   std::string_view path,
+                                   RouteParams&     params) const {
+    if (path.empty()) {
+        return node.handlers.empty() ? nullptr : &node;
+    }
+
+    const auto pos = node.indices.find(path.front());
+    if (pos != std::string::npos) {
+        const Node& child = *node.children[pos];
+        if (path.compare(0, child.prefix.size(), child.prefix) == 0) {
+            if (const Node* found = lookup(child, path.substr(child.prefix.size()), params)) {
+                return found;
+            }
+        }
+    }
+
+    if (node.param) {
+        const auto segment = path.substr(0, path.find('/'));
+        if (!segment.empty()) {
+            const size_t saved              = params.count_;
+            params.items_[params.count_++] = {node.param->paramName, segment};
+            if (const Node* found = lookup(*node.param, path.substr(segment.size()), params)) {
+                return found;
+            }
+            params.count_ = saved;
+        }
+    }
+
+    if (node.catchAll && !node.catchAll->handlers.empty()) {
+        params.items_[params.count_++] = {node.catchAll->paramName, path};
+        return node.catchAll.get();
+    }
+    return nullptr;
+}
+
+}  // namespace Http
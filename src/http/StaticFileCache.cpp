@@ -0,0 +1,432 @@
+#include "http/StaticFileCache.hpp"
+
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+
+#include "Log.hpp"
+#include "http/FileETag.hpp"
+#include "http/Hash64.hpp"
+#include "http/HttpStatus.hpp"
+#include "http/HttpUtils.hpp"
+
+namespace Http {
+
+namespace {
+constexpr uint32_t kWatchMask = IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE |
+                                IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+// 单个缓存项最多占总上限的比例（倒数）
+constexpr size_t kMaxEntryShare = 4;
+constexpr size_t kEventBufSize  = 4096;
+// 页面每次使用前重新验证；其余资源（脚本、样式、图片）允许浏览器直接复用一小时，
+// 之后凭 ETag 验证，未变化时只需一个 304
+constexpr std::string_view kHtmlCacheControl  = "no-cache";
+constexpr std::string_view kAssetCacheControl = "public, max-age=3600";
+// 预压缩的旁路文件：style.css → style.css.gz
+constexpr std::string_view kSidecarSuffix    = ".gz";
+constexpr ContentCoding    kVariantCodings[] = {ContentCoding::GZIP, ContentCoding::DEFLATE};
+
+// 规范化相对路径：拒绝绝对路径与任何 ".." 分量，返回空表示非法
+std::string normalizeKey(std::string_view relPath) {
+    const auto normal = std::filesystem::path{relPath}.lexically_normal().relative_path();
+    if (normal.empty() || normal == ".") {
+        return {};
+    }
+    for (const auto& part : normal) {
+        if (part == "..") {
+            return {};
+        }
+    }
+    return normal.generic_string();
+}
+
+size_t footprint(const StaticFileCache::Entry& entry) {
+    return entry.body.size() + entry.head.size() + entry.notModifiedHead.size();
+}
+
+// 压缩变体与原文件共用 LRU 与失效逻辑，键为 "<相对路径>\0<编码名>"
+std::string variantKey(std::string_view key, ContentCoding coding) {
+    std::string out{key};
+    out.push_back('\0');
+    out.append(codingName(coding));
+    return out;
+}
+
+bool readAll(int fd, std::string& out, size_t size) {
+    out.resize(size);
+    size_t done = 0;
+    while (done < size) {
+        const ssize_t n = ::read(fd, out.data() + done, size - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// 读取普通文件的全部内容；不存在、不是普通文件或读取失败时返回 false
+bool readRegularFile(const std::filesystem::path& path, struct stat& st, std::string& out) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    const bool ok = ::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+                    readAll(fd, out, static_cast<size_t>(st.st_size));
+    ::close(fd);
+    return ok;
+}
+
+// 按 body 生成 ETag 以及 200/304 两套响应头
+void renderHeads(StaticFileCache::Entry& entry, std::string_view type) {
+    entry.etag = formatETag(Hash64::of(entry.body));
+    char lastModified[kHttpDateLength];
+    formatHttpDate(entry.mtime, lastModified);
+
+    std::string validators;
+    validators.append("ETag: ").append(entry.etag);
+    validators.append("\r\nLast-Modified: ").append(lastModified, kHttpDateLength);
+    validators.append("\r\nCache-Control: ");
+    validators.append(type.rfind("text/html", 0) == 0 ? kHtmlCacheControl : kAssetCacheControl);
+    validators.append("\r\n");
+    if (entry.negotiable) {
+        validators.append("Vary: Accept-Encoding\r\n");
+    }
+
+    char       length[24];
+    const auto result = std::to_chars(length, length + sizeof(length), entry.body.size());
+    entry.head.append(statusLine(StatusCode::kOk));
+    entry.head.append("Content-Type: ");
+    entry.head.append(type);
+    entry.head.append("\r\nContent-Length: ");
+    entry.head.append(length, result.ptr);
+    entry.head.append("\r\n");
+    if (entry.coding != ContentCoding::IDENTITY) {
+        entry.head.append("Content-Encoding: ").append(codingName(entry.coding)).append("\r\n");
+    }
+    entry.head.append(validators);
+    entry.notModifiedHead.append(statusLine(StatusCode::kNotModified));
+    entry.notModifiedHead.append(validators);
+}
+}  // namespace
+
+StaticFileCache::StaticFileCache(Server::EventLoop*    loop,
+                                 std::filesystem::path root,
+                                 size_t                maxBytes)
+    : loop_(loop), root_(std::move(root)), maxBytes_(maxBytes) {
+    inotifyFd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd_ < 0) {
+        LOG_WARN("inotify unavailable ({}), static cache entries expire after {}s",
+                 strerror(errno),
+                 kRecheckInterval.count());
+        return;
+    }
+    inotifyChannel_ = std::make_unique<Server::Channel>(loop_, inotifyFd_);
+    inotifyChannel_->setReadCallback([this]() { this->handleInotify(); });
+    inotifyChannel_->enableReading();
+}
+
+StaticFileCache::~StaticFileCache() {
+    if (inotifyChannel_) {
+        inotifyChannel_->disableAll();
+        inotifyChannel_->remove();
+    }
+    if (inotifyFd_ >= 0) {
+        ::close(inotifyFd_);
+    }
+}
+
+std::shared_ptr<const StaticFileCache::Entry> StaticFileCache::find(std::string_view relPath,
+                                                                    ContentCoding    accept) {
+    const std::string key = normalizeKey(relPath);
+    if (key.empty()) {
+        return nullptr;
+    }
+    auto identity = findIdentity(key);
+    if (identity && (!identity->negotiable || accept == ContentCoding::IDENTITY ||
+                     noVariant_.count(variantKey(key, accept)) != 0)) {
+        ++stats_.hits;
+        return identity;
+    }
+    if (identity) {
+        const std::string vkey = variantKey(key, accept);
+        auto              it   = entries_.find(vkey);
+        if (it != entries_.end()) {
+            // 原文件已由 findIdentity 验证过；变体记录的原文件版本不同即已过期
+            const Entry& cached = *it->second.entry;
+            if (cached.mtime == identity->mtime && cached.size == identity->size) {
+                ++stats_.hits;
+                lru_.splice(lru_.begin(), lru_, it->second.lru);
+                return it->second.entry;
+            }
+            ++stats_.invalidations;
+            erase(vkey);
+        }
+    }
+    ++stats_.misses;
+    return nullptr;
+}
+
+std::shared_ptr<const StaticFileCache::Entry> StaticFileCache::findIdentity(
+    const std::string& key) {
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        return nullptr;
+    }
+    // 没有 inotify 时不在 loop 线程 stat：到期的项按未命中处理，由线程池重新读取
+    if (inotifyFd_ < 0 &&
+        std::chrono::steady_clock::now() - it->second.stored >= kRecheckInterval) {
+        invalidate(key);
+        return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second.lru);
+    return it->second.entry;
+}
+
+StaticFileCache::Loaded StaticFileCache::load(std::string_view relPath,
+                                              ContentCoding    accept) const {
+    Loaded loaded;
+    loaded.key = normalizeKey(relPath);
+    if (loaded.key.empty()) {
+        return loaded;
+    }
+    const std::filesystem::path target = root_ / loaded.key;
+
+    // 先监视目录再读取：读取之后的任何变化都会产生事件，由 store() 或 handleInotify() 处理
+    if (inotifyFd_ >= 0) {
+        loaded.watch = ::inotify_add_watch(inotifyFd_, target.parent_path().c_str(), kWatchMask);
+        if (loaded.watch < 0) {
+            LOG_WARN("inotify_add_watch {} failed: {}",
+                     target.parent_path().string(),
+                     strerror(errno));
+        }
+    }
+
+    struct stat st{};
+    auto        entry = std::make_shared<Entry>();
+    if (!readRegularFile(target, st, entry->body)) {
+        if (S_ISREG(st.st_mode)) {
+            LOG_WARN("failed to read static file {}", target.string());
+        }
+        return loaded;
+    }
+    entry->mtime = st.st_mtime;
+    entry->size  = st.st_size;
+
+    // 文本类资源有旁路文件或足够大（且会被缓存）时才协商编码
+    const std::string_view type = mimeType(loaded.key);
+    if (isCompressible(type)) {
+        struct stat sidecar{};
+        entry->negotiable =
+            (compression_.level > 0 && entry->body.size() >= compression_.minBytes &&
+             cacheable(*entry)) ||
+            ::stat((target.string() + std::string{kSidecarSuffix}).c_str(), &sidecar) == 0;
+    }
+    renderHeads(*entry, type);
+    loaded.identity = entry;
+    if (!entry->negotiable || accept == ContentCoding::IDENTITY) {
+        return loaded;
+    }
+
+    auto variant        = std::make_shared<Entry>();
+    variant->mtime      = entry->mtime;
+    variant->size       = entry->size;
+    variant->coding     = accept;
+    variant->negotiable = true;
+    // 比原文件旧的旁路文件视为过期，改为现场压缩
+    if (accept == ContentCoding::GZIP &&
+        readRegularFile(target.string() + std::string{kSidecarSuffix}, st, variant->body) &&
+        st.st_mtime >= entry->mtime) {
+        LOG_DEBUG("static file {} served from precompressed sidecar", loaded.key);
+    } else {
+        // 不进缓存的大文件不现场压缩，否则每次请求都要重新压缩
+        variant->body.clear();
+        if (compression_.level <= 0 || entry->body.size() < compression_.minBytes ||
+            !cacheable(*entry) ||
+            !compress(entry->body, accept, compression_.level, variant->body) ||
+            variant->body.size() >= entry->body.size()) {
+            return loaded;  // 没有值得使用的变体
+        }
+        loaded.compressed = true;
+    }
+    renderHeads(*variant, type);
+    loaded.variant = variant;
+    return loaded;
+}
+
+std::shared_ptr<const StaticFileCache::Entry> StaticFileCache::store(const Loaded& loaded,
+                                                                     ContentCoding accept,
+                                                                     uint64_t      generation) {
+    if (loaded.watch >= 0) {
+        const auto slash         = loaded.key.rfind('/');
+        watchDirs_[loaded.watch] = slash == std::string::npos ? std::string{}
+                                                              : loaded.key.substr(0, slash);
+    }
+    if (loaded.key.empty() || !loaded.identity) {
+        return nullptr;
+    }
+    const Entry& identity = *loaded.identity;
+    if (loaded.compressed) {
+        ++stats_.compressions;
+    }
+    if (!cacheable(identity)) {
+        return loaded.variant ? loaded.variant : loaded.identity;
+    }
+
+    // 读取期间已处理过 inotify 事件（文件可能在读取后变化），或目录没能监视：
+    // 这次照常使用但不缓存。之后才到达的事件会使刚放入的项失效
+    if (generation != generation_ || (inotifyFd_ >= 0 && loaded.watch < 0)) {
+        return loaded.variant ? loaded.variant : loaded.identity;
+    }
+
+    // 同一文件可能被并发加载，后完成的覆盖先完成的
+    erase(loaded.key);
+    insert(loaded.key, loaded.identity);
+    if (identity.negotiable && accept != ContentCoding::IDENTITY) {
+        const std::string vkey = variantKey(loaded.key, accept);
+        erase(vkey);
+        if (!loaded.variant) {
+            noVariant_.insert(vkey);
+        } else if (cacheable(*loaded.variant)) {
+            insert(vkey, loaded.variant);
+        }
+    }
+    return loaded.variant ? loaded.variant : loaded.identity;
+}
+
+std::shared_ptr<const StaticFileCache::Entry> StaticFileCache::get(std::string_view relPath,
+                                                                   ContentCoding    accept) {
+    if (auto entry = find(relPath, accept)) {
+        return entry;
+    }
+    const uint64_t generation = generation_;
+    return store(load(relPath, accept), accept, generation);
+}
+
+bool StaticFileCache::cacheable(const Entry& entry) const {
+    return entry.body.size() <= maxBytes_ / kMaxEntryShare;
+}
+
+void StaticFileCache::insert(std::string key, std::shared_ptr<const Entry> entry) {
+    bytes_ += footprint(*entry);
+    lru_.push_front(key);
+    entries_[std::move(key)] =
+        Slot{std::move(entry), lru_.begin(), std::chrono::steady_clock::now()};
+    evict();
+}
+
+void StaticFileCache::erase(const std::string& key) {
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        return;
+    }
+    bytes_ -= footprint(*it->second.entry);
+    lru_.erase(it->second.lru);
+    entries_.erase(it);
+}
+
+void StaticFileCache::invalidate(const std::string& key) {
+    if (entries_.count(key) != 0) {
+        LOG_DEBUG("static file {} changed, invalidating cache", key);
+        ++stats_.invalidations;
+        erase(key);
+    }
+    for (const ContentCoding coding : kVariantCodings) {
+        const std::string vkey = variantKey(key, coding);
+        noVariant_.erase(vkey);
+        if (entries_.count(vkey) != 0) {
+            ++stats_.invalidations;
+            erase(vkey);
+        }
+    }
+}
+
+void StaticFileCache::evict() {
+    while (bytes_ > maxBytes_ && !lru_.empty()) {
+        const std::string victim = lru_.back();
+        erase(victim);
+        ++stats_.evictions;
+    }
+}
+
+void StaticFileCache::setMaxBytes(size_t maxBytes) {
+    maxBytes_ = maxBytes;
+    evict();
+}
+
+StaticFileCache::Stats StaticFileCache::stats() const {
+    Stats out   = stats_;
+    out.entries = entries_.size();
+    out.bytes   = bytes_;
+    return out;
+}
+
+void StaticFileCache::handleInotify() {
+    alignas(inotify_event) char buf[kEventBufSize];
+    for (;;) {
+        const ssize_t n = ::read(inotifyFd_, buf, sizeof(buf));
+        if (n <= 0) {
+            break;  // EAGAIN：事件已读完
+        }
+        for (ssize_t off = 0; off < n;) {
+            const auto* ev = reinterpret_cast<const inotify_event*>(buf + off);
+            off += static_cast<ssize_t>(sizeof(inotify_event) + ev->len);
+            ++generation_;  // 包括尚未登记的目录上的事件：对应的 load() 结果不再缓存
+
+            if ((ev->mask & IN_Q_OVERFLOW) != 0) {
+                // 事件丢失，无法判断哪些文件变化，整体清空
+                LOG_WARN("inotify queue overflow, dropping static cache");
+                stats_.invalidations += entries_.size();
+                entries_.clear();
+                noVariant_.clear();
+                lru_.clear();
+                bytes_ = 0;
+                continue;
+            }
+            auto dirIt = watchDirs_.find(ev->wd);
+            if (dirIt == watchDirs_.end()) {
+                continue;
+            }
+            const std::string& dir = dirIt->second;
+            if ((ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) != 0) {
+                // 目录本身消失：清掉其下的所有缓存项，之后按需重新监视
+                const std::string prefix = dir.empty() ? dir : dir + "/";
+                for (auto it = entries_.begin(); it != entries_.end();) {
+                    const std::string key = (it++)->first;
+                    if (key.rfind(prefix, 0) == 0) {
+                        ++stats_.invalidations;
+                        erase(key);
+                    }
+                }
+                noVariant_.clear();
+                if ((ev->mask & IN_MOVE_SELF) != 0) {
+                    ::inotify_rm_watch(inotifyFd_, ev->wd);  // 改名后的目录不再关心
+                }
+                watchDirs_.erase(dirIt);
+                continue;
+            }
+            if (ev->len > 0) {
+                const std::string name{ev->name};
+                const std::string key = dir.empty() ? name : dir + "/" + name;
+                invalidate(key);
+                // 旁路文件出现、变化或删除：原文件是否可协商以及压缩变体都要重新确定
+                if (key.size() > kSidecarSuffix.size() &&
+                    key.compare(key.size() - kSidecarSuffix.size(),
+                                kSidecarSuffix.size(),
+                                kSidecarSuffix) == 0) {
+                    invalidate(key.substr(0, key.size() - kSidecarSuffix.size()));
+                }
+            }
+        }
+    }
+}
+
+}  // namespace Http
@@ -0,0 +1,92 @@
+#include "http/TarFormat.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Http {
+
+namespace {
+constexpr size_t   kNameLength  = 100;
+constexpr uint64_t kMaxOctal11  = 077777777777ULL;  // 大小与 mtime 字段的上限
+constexpr char     kRegularFile = '0';
+constexpr char     kPaxHeader   = 'x';
+
+// 以 width - 1 位八进制（高位补零）加结尾 NUL 写入字段
+void putOctal(char* field, size_t width, uint64_t value) {
+    field[width - 1] = '\0';
+    for (size_t i = width - 1; i > 0; --i) {
+        field[i - 1] = static_cast<char>('0' + (value & 7));
+        value >>= 3;
+    }
+}
+
+void appendBlock(std::string&     out,
+                 std::string_view name,
+                 uint64_t         size,
+                 uint64_t         mtime,
+                 char             type) {
+    char block[kTarBlockSize] = {};
+    std::memcpy(block, name.data(), std::min(name.size(), kNameLength));
+    putOctal(block + 100, 8, 0644);                           // mode
+    putOctal(block + 108, 8, 0);                              // uid
+    putOctal(block + 116, 8, 0);                              // gid
+    putOctal(block + 124, 12, std::min(size, kMaxOctal11));   // 超出时以 pax 的 size 为准
+    putOctal(block + 136, 12, std::min(mtime, kMaxOctal11));  // mtime
+    block[156] = type;
+    std::memcpy(block + 257, "ustar", 6);  // magic，含结尾 NUL
+    std::memcpy(block + 263, "00", 2);     // version
+    // 校验和按校验和字段全为空格计算，写成 6 位八进制、NUL 与空格
+    std::memset(block + 148, ' ', 8);
+    uint32_t sum = 0;
+    for (const char c : block) {
+        sum += static_cast<unsigned char>(c);
+    }
+    putOctal(block + 148, 7, sum);
+    out.append(block, sizeof(block));
+}
+
+size_t digits(size_t value) {
+    size_t n = 1;
+    while (value >= 10) {
+        value /= 10;
+        ++n;
+    }
+    return n;
+}
+
+// pax 记录 "<长度> <键>=<值>\n"，长度是整条记录的字节数，包括长度本身的位数
+void appendPaxRecord(std::string& out, std::string_view key, std::string_view value) {
+    const size_t base   = key.size() + value.size() + 3;  // 空格、'=' 与换行
+    size_t       length = base + digits(base);
+    if (digits(length) != digits(base)) {
+        length = base + digits(length);  // 加上自身的位数后进位
+    }
+    out.append(std::to_string(length)).append(" ");
+    out.append(key).append("=").append(value).append("\n");
+}
+}  // namespace
+
+void appendTarHeader(std::string& out, std::string_view name, uint64_t size, std::time_t mtime) {
+    const uint64_t seconds = mtime > 0 ? static_cast<uint64_t>(mtime) : 0;
+    std::string    records;
+    if (name.size() > kNameLength) {
+        appendPaxRecord(records, "path", name);
+    }
+    if (size > kMaxOctal11) {
+        appendPaxRecord(records, "size", std::to_string(size));
+    }
+    if (!records.empty()) {
+        std::string paxName{"PaxHeaders/"};
+        paxName.append(name.substr(0, kNameLength - paxName.size()));
+        appendBlock(out, paxName, records.size(), seconds, kPaxHeader);
+        out.append(records);
+        out.append(tarPadding(records.size()), '\0');
+    }
+    appendBlock(out, name, size, seconds, kRegularFile);
+}
+
+void appendTarTrailer(std::string& out) {
+    out.append(2 * kTarBlockSize, '\0');
+}
+
+}  // namespace Http
@@ -0,0 +1,303 @@
+#include "http/UploadFile.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include "Log.hpp"
+#include "http/FileETag.hpp"
+
+namespace Http {
+
+namespace {
+constexpr mode_t kFileMode = 0644;
+}  // namespace
+
+UploadFile::~UploadFile() {
+    abort();
+}
+
+UploadFile::UploadFile(UploadFile&& other) noexcept
+    : fd_(other.fd_)
+    , tempPath_(std::move(other.tempPath_))
+    , name_(std::move(other.name_))
+    , base_(other.base_)
+    , written_(other.written_)
+    , preallocated_(other.preallocated_)
+    , error_(other.error_)
+    , hash_(other.hash_)
+    , engine_(other.engine_)
+    , buffer_(std::move(other.buffer_))
+    , pending_(std::move(other.pending_)) {
+    other.reset();
+}
+
+UploadFile& UploadFile::operator=(UploadFile&& other) noexcept {
+    if (this != &other) {
+        abort();
+        fd_           = other.fd_;
+        tempPath_     = std::move(other.tempPath_);
+        name_         = std::move(other.name_);
+        base_         = other.base_;
+        written_      = other.written_;
+        preallocated_ = other.preallocated_;
+        error_        = other.error_;
+        hash_         = other.hash_;
+        engine_       = other.engine_;
+        buffer_       = std::move(other.buffer_);
+        pending_      = std::move(other.pending_);
+        other.reset();
+    }
+    return *this;
+}
+
+void UploadFile::reset() {
+    fd_ = -1;
+    tempPath_.clear();
+    name_.clear();
+    base_         = 0;
+    written_      = 0;
+    preallocated_ = 0;
+    hash_         = Hash64{};
+    engine_       = nullptr;
+    buffer_.clear();
+    pending_.reset();
+}
+
+void UploadFile::Pending::settle() {
+    if (onDrain && bytes <= kMaxPending / 2) {
+        auto cb = std::move(onDrain);
+        onDrain = nullptr;
+        cb();
+    }
+    if (bytes != 0) {
+        return;
+    }
+    if (closeFd >= 0) {
+        ::close(closeFd);
+        closeFd = -1;
+    }
+    if (onIdle) {
+        auto cb = std::move(onIdle);
+        onIdle  = nullptr;
+        cb();
+    }
+}
+
+bool UploadFile::open(const std::filesystem::path& tempDir,
+                      std::string                  name,
+                      Server::StorageEngine*       engine,
+                      uint64_t                     expectedSize) {
+    abort();
+    error_              = 0;
+    std::string pattern = (tempDir / ".upload-XXXXXX").string();
+    const int   fd      = ::mkostemp(pattern.data(), O_CLOEXEC);
+    if (fd < 0) {
+        error_ = errno;
+        LOG_ERROR("failed to create upload temp file in {}: {}", tempDir.string(), strerror(errno));
+        return false;
+    }
+    // mkostemp 固定创建 0600，与之前 ofstream 写出的文件权限保持一致
+    ::fchmod(fd, kFileMode);
+    // 一次分配全部空间：文件尽量连续，空间不足时在接收 body 之前就失败。
+    // 文件系统不支持时照常逐块分配
+    if (expectedSize > 0 && ::fallocate(fd, 0, 0, static_cast<off_t>(expectedSize)) != 0) {
+        const int err = errno;
+        if (err == ENOSPC || err == EFBIG) {
+            LOG_ERROR("cannot reserve {} bytes for upload of {}: {}",
+                      expectedSize,
+                      name,
+                      strerror(err));
+            ::close(fd);
+            ::unlink(pattern.c_str());
+            error_ = err;
+            return false;
+        }
+        LOG_DEBUG("fallocate unsupported for {}: {}", pattern, strerror(err));
+        expectedSize = 0;
+    }
+    fd_           = fd;
+    tempPath_     = pattern;
+    name_         = std::move(name);
+    base_         = 0;
+    written_      = 0;
+    preallocated_ = expectedSize;
+    hash_         = Hash64{};
+    engine_       = engine;
+    if (engine_ != nullptr) {
+        pending_ = std::make_shared<Pending>();
+        buffer_.reserve(kWriteChunk);
+    }
+    LOG_DEBUG("upload temp file {} opened for {}", tempPath_.string(), name_);
+    return true;
+}
+
+bool UploadFile::openRange(int fd, uint64_t offset, Server::StorageEngine* engine) {
+    abort();
+    error_        = 0;
+    const int dup = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (dup < 0) {
+        error_ = errno;
+        LOG_ERROR("failed to duplicate fd {}: {}", fd, strerror(errno));
+        return false;
+    }
+    fd_     = dup;
+    base_   = offset;
+    engine_ = engine;
+    if (engine_ != nullptr) {
+        pending_ = std::make_shared<Pending>();
+        buffer_.reserve(kWriteChunk);
+    }
+    return true;
+}
+
+bool UploadFile::write(std::string_view data) {
+    hash_.update(data);
+    if (engine_ != nullptr) {
+        if (pending_->err != 0) {
+            return false;
+        }
+        buffer_.append(data);
+        written_ += data.size();
+        if (buffer_.size() >= kWriteChunk) {
+            submitBuffer();
+        }
+        return true;
+    }
+    while (!data.empty()) {
+        // 与 openRange() 的调用方共享文件偏移，总是按位置写
+        const ssize_t n =
+            ::pwrite(fd_, data.data(), data.size(), static_cast<off_t>(base_ + written_));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("write to {} failed: {}", tempPath_.string(), strerror(errno));
+            return false;
+        }
+        data.remove_prefix(static_cast<size_t>(n));
+        written_ += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void UploadFile::submitBuffer() {
+    const size_t   size   = buffer_.size();
+    const uint64_t offset = base_ + written_ - size;
+    pending_->bytes += size;
+    engine_->write(fd_,
+                   offset,
+                   std::move(buffer_),
+                   [pending = pending_, size, path = tempPath_.string()](int err) {
+                       pending->bytes -= size;
+                       if (err != 0 && pending->err == 0) {
+                           LOG_ERROR("write to {} failed: {}", path, strerror(err));
+                           pending->err = err;
+                       }
+                       pending->settle();
+                   });
+    buffer_.clear();
+    buffer_.reserve(kWriteChunk);
+}
+
+void UploadFile::flush(std::function<void(bool ok)> done) {
+    if (engine_ == nullptr || !pending_) {
+        done(true);  // 同步写入，write() 返回时数据已交给内核
+        return;
+    }
+    if (!buffer_.empty() && pending_->err == 0) {
+        submitBuffer();
+    }
+    if (pending_->bytes == 0) {
+        done(pending_->err == 0);
+        return;
+    }
+    // onIdle 由 pending_ 自身调用，捕获裸指针避免循环引用
+    pending_->onIdle = [pending = pending_.get(), done = std::move(done)]() {
+        done(pending->err == 0);
+    };
+}
+
+bool UploadFile::backlogged() const {
+    return pending_ && pending_->bytes > kMaxPending;
+}
+
+void UploadFile::onDrain(std::function<void()> cb) {
+    if (!pending_ || pending_->bytes <= kMaxPending / 2) {
+        cb();
+        return;
+    }
+    pending_->onDrain = std::move(cb);
+}
+
+bool UploadFile::commit(const std::filesystem::path& target,
+                        Durability                   durability,
+                        std::error_code&             ec) {
+    if (pending_ && pending_->err != 0) {
+        ec.assign(pending_->err, std::generic_category());
+        abort();
+        return false;
+    }
+    // 实际写入少于预分配（如客户端提前结束）时截掉尾部未写入的空间
+    if (preallocated_ > written_ && ::ftruncate(fd_, static_cast<off_t>(written_)) != 0) {
+        ec.assign(errno, std::generic_category());
+        abort();
+        return false;
+    }
+    storeFileHash(fd_, hash_.digest());
+    if (durability != Durability::NONE && ::fdatasync(fd_) != 0) {
+        ec.assign(errno, std::generic_category());
+        abort();
+        return false;
+    }
+    if (::close(fd_) != 0) {
+        ec.assign(errno, std::generic_category());
+        fd_ = -1;
+        abort();
+        return false;
+    }
+    fd_ = -1;
+    std::filesystem::rename(tempPath_, target, ec);
+    if (ec) {
+        abort();
+        return false;
+    }
+    if (durability == Durability::FULL) {
+        // 目录项随目录的 fsync 落盘；此时文件已经就位，失败只记录不回滚
+        const int dir = ::open(target.parent_path().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dir < 0 || ::fsync(dir) != 0) {
+            LOG_WARN("failed to sync directory of {}: {}", target.string(), strerror(errno));
+        }
+        if (dir >= 0) {
+            ::close(dir);
+        }
+    }
+    reset();
+    return true;
+}
+
+void UploadFile::abort() {
+    if (pending_) {
+        pending_->onIdle  = nullptr;
+        pending_->onDrain = nullptr;
+    }
+    if (fd_ >= 0) {
+        if (pending_ && pending_->bytes > 0) {
+            pending_->closeFd = fd_;  // 内核/线程池仍在写这个 fd，写完再关闭
+        } else {
+            ::close(fd_);
+        }
+    }
+    if (!tempPath_.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(tempPath_, ec);
+        LOG_DEBUG("upload temp file {} discarded", tempPath_.string());
+    }
+    reset();
+}
+
+}  // namespace Http
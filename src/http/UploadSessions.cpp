@@ -0,0 +1,355 @@
+#include "http/UploadSessions.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "Log.hpp"
+#include "http/FileETag.hpp"
+#include "http/HttpUtils.hpp"
+
+namespace Http {
+
+namespace {
+constexpr mode_t           kFileMode   = 0644;
+constexpr std::string_view kMetaMagic  = "fsupload ";
+constexpr std::string_view kPartSuffix = ".part";
+constexpr std::string_view kMetaSuffix = ".meta";
+
+std::string makeId() {
+    thread_local std::mt19937_64 rng{std::random_device{}()};
+    char                         hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(rng()));
+    return hex;
+}
+
+bool writeAll(int fd, std::string_view data) {
+    while (!data.empty()) {
+        const ssize_t n = ::write(fd, data.data(), data.size());
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data.remove_prefix(static_cast<size_t>(n));
+    }
+    return true;
+}
+
+void syncDirectory(const std::filesystem::path& dir) {
+    const int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0 || ::fsync(fd) != 0) {
+        LOG_WARN("failed to sync directory {}: {}", dir.string(), strerror(errno));
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+// 从 text 开头取一个十进制数并跳过其后的一个分隔符
+bool takeNumber(std::string_view& text, char separator, uint64_t& value) {
+    const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc{} || ptr == text.data() + text.size() || *ptr != separator) {
+        return false;
+    }
+    text.remove_prefix(static_cast<size_t>(ptr - text.data()) + 1);
+    return true;
+}
+}  // namespace
+
+UploadSessions::Session::~Session() {
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+uint64_t UploadSessions::Session::received() const {
+    uint64_t total = 0;
+    for (const auto& [first, end] : ranges) {
+        total += end - first;
+    }
+    return total;
+}
+
+void UploadSessions::Session::add(uint64_t first, uint64_t end) {
+    if (first >= end) {
+        return;
+    }
+    // 与前一个区间相接或重叠时并入
+    auto it = ranges.upper_bound(first);
+    if (it != ranges.begin() && std::prev(it)->second >= first) {
+        --it;
+        first = it->first;
+        end   = std::max(end, it->second);
+        it    = ranges.erase(it);
+    }
+    // 吞并后面所有与之相接或重叠的区间
+    while (it != ranges.end() && it->first <= end) {
+        end = std::max(end, it->second);
+        it  = ranges.erase(it);
+    }
+    ranges.emplace(first, end);
+}
+
+std::string UploadSessions::Session::json() const {
+    std::ostringstream out;
+    out << "{\"id\":\"" << id << "\",\"name\":\"" << escapeJson(name) << "\",\"size\":" << size
+        << ",\"received\":" << received() << ",\"ranges\":[";
+    bool firstRange = true;
+    for (const auto& [first, end] : ranges) {
+        out << (firstRange ? "" : ",") << '[' << first << ',' << end << ']';
+        firstRange = false;
+    }
+    out << "]}";
+    return out.str();
+}
+
+UploadSessions::Writer::Writer(SessionPtr s, uint64_t f, uint64_t e)
+    : session(std::move(s)), first(f), end(e) {
+    ++session->writers;
+}
+
+UploadSessions::Writer::~Writer() {
+    --session->writers;
+}
+
+UploadSessions::UploadSessions(std::filesystem::path dir) : dir_(std::move(dir)) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+    if (ec) {
+        LOG_WARN("failed to ensure upload session dir {}: {}", dir_.string(), ec.message());
+        return;
+    }
+    load();
+}
+
+std::filesystem::path UploadSessions::partPath(const std::string& id) const {
+    return dir_ / (id + std::string{kPartSuffix});
+}
+
+std::filesystem::path UploadSessions::metaPath(const std::string& id) const {
+    return dir_ / (id + std::string{kMetaSuffix});
+}
+
+void UploadSessions::load() {
+    std::vector<std::string> metas;
+    std::vector<std::string> parts;
+    std::error_code          ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir_, ec)) {
+        const std::string file = entry.path().filename().string();
+        if (entry.path().extension() == kMetaSuffix) {
+            metas.push_back(file.substr(0, file.size() - kMetaSuffix.size()));
+        } else if (entry.path().extension() == kPartSuffix) {
+            parts.push_back(file.substr(0, file.size() - kPartSuffix.size()));
+        }
+    }
+    for (const auto& id : metas) {
+        if (auto session = loadOne(id)) {
+            sessions_.emplace(id, std::move(session));
+        } else {
+            std::filesystem::remove(metaPath(id), ec);
+            std::filesystem::remove(partPath(id), ec);
+        }
+    }
+    // 创建时先建数据文件：只有数据文件说明元数据还没写好就退出了
+    for (const auto& id : parts) {
+        if (sessions_.count(id) == 0) {
+            std::filesystem::remove(partPath(id), ec);
+        }
+    }
+    if (!sessions_.empty()) {
+        LOG_INFO("restored {} upload sessions from {}", sessions_.size(), dir_.string());
+    }
+}
+
+UploadSessions::SessionPtr UploadSessions::loadOne(const std::string& id) {
+    const std::filesystem::path meta = metaPath(id);
+    struct stat                 st{};
+    if (::stat(meta.c_str(), &st) != 0) {
+        return nullptr;
+    }
+    if (std::time(nullptr) - st.st_mtime > std::chrono::seconds{kExpiry}.count()) {
+        LOG_INFO("upload session {} expired, discarding", id);
+        return nullptr;
+    }
+    std::ifstream     in(meta, std::ios::binary);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    const std::string content = buffer.str();
+    std::string_view  text    = content;
+
+    // 首行 "fsupload <size> <名字长度> <名字>\n"：名字按长度截取，可以包含任意字符
+    uint64_t size       = 0;
+    uint64_t nameLength = 0;
+    if (text.substr(0, kMetaMagic.size()) != kMetaMagic) {
+        LOG_WARN("upload session {} has a corrupt header, discarding", id);
+        return nullptr;
+    }
+    text.remove_prefix(kMetaMagic.size());
+    if (!takeNumber(text, ' ', size) || !takeNumber(text, ' ', nameLength) ||
+        text.size() <= nameLength || text[nameLength] != '\n') {
+        LOG_WARN("upload session {} has a corrupt header, discarding", id);
+        return nullptr;
+    }
+
+    auto session  = std::make_shared<Session>();
+    session->id   = id;
+    session->name = sanitizeFilename(text.substr(0, nameLength));
+    session->size = size;
+    text.remove_prefix(nameLength + 1);
+    if (session->name.empty()) {
+        return nullptr;
+    }
+    // 进度行；崩溃时可能留下不完整的最后一行，忽略它（该分片需要重传）
+    while (!text.empty()) {
+        uint64_t first = 0;
+        uint64_t end   = 0;
+        if (!takeNumber(text, ' ', first) || !takeNumber(text, '\n', end) || end > size) {
+            break;
+        }
+        session->add(first, end);
+    }
+
+    session->fd = ::open(partPath(id).c_str(), O_RDWR | O_CLOEXEC);
+    if (session->fd < 0) {
+        LOG_WARN("upload session {} lost its data file: {}", id, strerror(errno));
+        return nullptr;
+    }
+    LOG_DEBUG(
+        "upload session {} for {}: {}/{} bytes", id, session->name, session->received(), size);
+    return session;
+}
+
+UploadSessions::SessionPtr UploadSessions::create(const std::string& name,
+                                                  uint64_t           size,
+                                                  Durability         durability,
+                                                  std::error_code&   ec) const {
+    auto session  = std::make_shared<Session>();
+    session->id   = makeId();
+    session->name = name;
+    session->size = size;
+
+    const std::filesystem::path part = partPath(session->id);
+    session->fd = ::open(part.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, kFileMode);
+    if (session->fd < 0) {
+        ec.assign(errno, std::generic_category());
+        return nullptr;
+    }
+    // 与 UploadFile 相同：一次预分配全部空间，空间不足时在接收任何分片之前失败
+    if (size > 0 && ::fallocate(session->fd, 0, 0, static_cast<off_t>(size)) != 0) {
+        const int err = errno;
+        if (err == ENOSPC || err == EFBIG) {
+            ec.assign(err, std::generic_category());
+            ::unlink(part.c_str());
+            return nullptr;
+        }
+        LOG_DEBUG("fallocate unsupported for {}: {}", part.string(), strerror(err));
+    }
+
+    const std::filesystem::path meta = metaPath(session->id);
+    const int                   fd =
+        ::open(meta.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_APPEND | O_CLOEXEC, kFileMode);
+    const std::string header = std::string{kMetaMagic} + std::to_string(size) + ' ' +
+                               std::to_string(name.size()) + ' ' + name + '\n';
+    if (fd < 0 || !writeAll(fd, header) ||
+        (durability != Durability::NONE && ::fdatasync(fd) != 0)) {
+        ec.assign(errno, std::generic_category());
+        if (fd >= 0) {
+            ::close(fd);
+            ::unlink(meta.c_str());
+        }
+        ::unlink(part.c_str());
+        return nullptr;
+    }
+    ::close(fd);
+    if (durability == Durability::FULL) {
+        syncDirectory(dir_);
+    }
+    return session;
+}
+
+bool UploadSessions::record(const Session&   session,
+                            uint64_t         first,
+                            uint64_t         end,
+                            Durability       durability,
+                            std::error_code& ec) const {
+    // 先让数据落盘再记录进度：重启后记录过的区间一定可读
+    if (durability != Durability::NONE && ::fdatasync(session.fd) != 0) {
+        ec.assign(errno, std::generic_category());
+        return false;
+    }
+    const int fd = ::open(metaPath(session.id).c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    const std::string line = std::to_string(first) + ' ' + std::to_string(end) + '\n';
+    if (fd < 0 || !writeAll(fd, line) ||
+        (durability != Durability::NONE && ::fdatasync(fd) != 0)) {
+        ec.assign(errno, std::generic_category());
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return false;
+    }
+    ::close(fd);
+    return true;
+}
+
+bool UploadSessions::commit(const Session&              session,
+                            StorageBackend&             backend,
+                            Durability                  durability,
+                            StorageBackend::ObjectInfo& info,
+                            std::error_code&            ec) const {
+    if (durability != Durability::NONE && ::fdatasync(session.fd) != 0) {
+        ec.assign(errno, std::generic_category());
+        return false;
+    }
+    // 分片乱序到达，无法边写边算哈希：提交时读一遍算出 ETag 并存入扩展属性
+    struct stat st{};
+    if (::fstat(session.fd, &st) == 0) {
+        fileETag(session.fd, st);
+    }
+    if (!backend.place(partPath(session.id), session.name, durability, info, ec)) {
+        return false;
+    }
+    std::error_code ignored;
+    std::filesystem::remove(metaPath(session.id), ignored);
+    return true;
+}
+
+void UploadSessions::discard(const Session& session) const {
+    std::error_code ec;
+    std::filesystem::remove(partPath(session.id), ec);
+    std::filesystem::remove(metaPath(session.id), ec);
+}
+
+void UploadSessions::insert(SessionPtr session) {
+    const std::string id = session->id;
+    sessions_.emplace(id, std::move(session));
+}
+
+UploadSessions::SessionPtr UploadSessions::find(std::string_view id) const {
+    auto it = sessions_.find(std::string{id});
+    return it == sessions_.end() ? nullptr : it->second;
+}
+
+void UploadSessions::erase(const std::string& id) {
+    auto it = sessions_.find(id);
+    if (it == sessions_.end()) {
+        return;
+    }
+    it->second->closed = true;
+    sessions_.erase(it);
+}
+
+}  // namespace Http
@@ -0,0 +1,332 @@
+// HttpParser 吞吐基准：使用接近浏览器/SDK 的真实请求头集合，
+// 分别测试整包投喂、小片段投喂（验证不会重复扫描）以及流水线批量投喂。
+// 另测单个请求的头部存储与查找开销，以及小响应序列化的耗时与分配次数。
+// 启动时先用随机输入校验各 SIMD 扫描内核与标量实现的结果逐一相同，不一致则退出码为 1。
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "http/HttpHeaders.hpp"
+#include "http/HttpParser.hpp"
+#include "http/HttpResponse.hpp"
+#include "http/HttpStatus.hpp"
+#include "http/HttpScan.hpp"
+
+using namespace Http;
+
+namespace {
+size_t gAllocations = 0;
+}  // namespace
+
+// 统计堆分配次数，用于确认响应序列化路径不分配内存
+void* operator new(size_t size) {
+    ++gAllocations;
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+const std::string kBrowserRequest =
+    "GET /api/files/report-2024.pdf?download=1 HTTP/1.1\r\n"
+    "Host: files.example.internal:9200\r\n"
+    "Connection: keep-alive\r\n"
+    "sec-ch-ua: \"Chromium\";v=\"124\", \"Google Chrome\";v=\"124\", \"Not-A.Brand\";v=\"99\"\r\n"
+    "sec-ch-ua-mobile: ?0\r\n"
+    "sec-ch-ua-platform: \"Linux\"\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) "
+    "Chrome/124.0.0.0 Safari/537.36\r\n"
+    "Accept: "
+    "text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+    "Sec-Fetch-Site: same-origin\r\n"
+    "Sec-Fetch-Mode: navigate\r\n"
+    "Sec-Fetch-User: ?1\r\n"
+    "Sec-Fetch-Dest: document\r\n"
+    "Referer: http://files.example.internal:9200/\r\n"
+    "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+    "Accept-Language: en-US,en;q=0.9,zh-CN;q=0.8\r\n"
+    "Cookie: session=4f6c1b2a9d; theme=dark; _ga=GA1.1.123456789.1700000000\r\n"
+    "Range: bytes=0-\r\n"
+    "\r\n";
+
+const std::string kUploadRequest =
+    "POST /api/files HTTP/1.1\r\n"
+    "Host: files.example.internal:9200\r\n"
+    "User-Agent: curl/8.5.0\r\n"
+    "Accept: */*\r\n"
+    "X-Filename: build-artifact.tar\r\n"
+    "Content-Type: application/octet-stream\r\n"
+    "Content-Length: 256\r\n"
+    "\r\n" +
+    std::string(256, 'x');
+
+struct Result {
+    size_t requests{0};
+    double seconds{0};
+    size_t bytes{0};
+};
+
+void report(const char* name, const Result& r) {
+    std::printf("%-28s %10.0f req/s %9.1f MB/s\n",
+                name,
+                static_cast<double>(r.requests) / r.seconds,
+                static_cast<double>(r.bytes) / r.seconds / 1e6);
+}
+
+// 每次投喂 chunk 字节（0 表示一次投喂整个请求）
+Result runSingle(const std::string& request, size_t iterations, size_t chunk) {
+    HttpParser parser;
+    size_t     completed = 0;
+    const auto start     = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        const std::string_view data{request};
+        const size_t           step = chunk == 0 ? data.size() : chunk;
+        for (size_t off = 0; off < data.size(); off += step) {
+            auto state = parser.feed(data.substr(off, step));
+            if (state == HttpParser::FeedState::HEADERS_COMPLETE) {
+                state = parser.feed("");
+            }
+            if (state == HttpParser::FeedState::COMPLETE) {
+                ++completed;
+                parser.resetParser(true);
+            } else if (state == HttpParser::FeedState::ERROR) {
+                std::fprintf(stderr, "parse error\n");
+                std::exit(1);
+            }
+        }
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return {completed, elapsed.count(), request.size() * iterations};
+}
+
+// 一次投喂 depth 个流水线请求，然后逐个取出
+Result runPipelined(const std::string& request, size_t iterations, size_t depth) {
+    std::string batch;
+    for (size_t i = 0; i < depth; ++i) {
+        batch += request;
+    }
+    HttpParser parser;
+    size_t     completed = 0;
+    const auto start     = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        auto state = parser.feed(batch);
+        while (state == HttpParser::FeedState::COMPLETE ||
+               state == HttpParser::FeedState::HEADERS_COMPLETE) {
+            if (state == HttpParser::FeedState::COMPLETE) {
+                ++completed;
+                parser.resetParser(true);
+            }
+            state = parser.feed("");
+        }
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return {completed, elapsed.count(), batch.size() * iterations};
+}
+
+constexpr scan::Kernel kAllKernels[] = {scan::Kernel::SCALAR, scan::Kernel::SSE42, scan::Kernel::AVX2};
+
+struct ScanResults {
+    size_t crlf;
+    size_t colon;
+    size_t nonToken;
+    size_t ctl;
+};
+
+ScanResults scanAll(std::string_view data, size_t from) {
+    return {scan::findCrlf(data, from),
+            scan::findChar(data, ':'),
+            scan::findNonToken(data),
+            scan::findCtl(data)};
+}
+
+// 随机输入偏向分隔符与边界字节，覆盖块内/跨块/尾部等情况
+bool verifyKernels() {
+    static constexpr char kAlphabet[] = "abcXYZ09-_.!~:; \t\r\n\r\n\x01\x7f\x80\xff\"(),/";
+    std::mt19937          rng(42);
+    std::uniform_int_distribution<size_t> lenDist(0, 200);
+    std::uniform_int_distribution<size_t> charDist(0, sizeof(kAlphabet) - 2);
+    std::uniform_int_distribution<int>    denseDist(0, 3);
+
+    for (int round = 0; round < 20000; ++round) {
+        std::string data(lenDist(rng), 'a');
+        const bool  dense = denseDist(rng) == 0;  // 多数样本是长串 token 中夹少量分隔符
+        for (auto& ch : data) {
+            if (dense || charDist(rng) < 3) {
+                ch = kAlphabet[charDist(rng)];
+            }
+        }
+        const size_t from = data.empty() ? 0 : lenDist(rng) % (data.size() + 1);
+
+        scan::setKernel(scan::Kernel::SCALAR);
+        const ScanResults expected = scanAll(data, from);
+        for (auto kernel : kAllKernels) {
+            if (!scan::setKernel(kernel)) {
+                continue;
+            }
+            const ScanResults got = scanAll(data, from);
+            if (got.crlf != expected.crlf || got.colon != expected.colon ||
+                got.nonToken != expected.nonToken || got.ctl != expected.ctl) {
+                std::fprintf(stderr,
+                             "kernel %s mismatch on round %d (len=%zu from=%zu)\n",
+                             scan::kernelName(kernel),
+                             round,
+                             data.size(),
+                             from);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// 扫描内核微基准：在整块请求头上逐行查找 CRLF，并校验每行的头部名与值
+void benchKernel(scan::Kernel kernel, size_t iterations) {
+    const std::string_view data{kBrowserRequest};
+    size_t                 checksum = 0;
+    const auto             start    = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        size_t line = 0;
+        for (size_t end = scan::findCrlf(data, line); end != std::string_view::npos && end > line;
+             end        = scan::findCrlf(data, line)) {
+            const auto text = data.substr(line, end - line);
+            checksum += scan::findNonToken(text) + scan::findCtl(text);
+            line = end + 2;
+        }
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("scan kernel %-16s %9.1f MB/s (checksum %zu)\n",
+                scan::kernelName(kernel),
+                static_cast<double>(data.size() * iterations) / elapsed.count() / 1e6,
+                checksum);
+}
+
+// 单个请求的头部存储 + 查找开销：旧做法（小写化 + unordered_map<string, string>）
+// 与 HeaderList（编号索引的扁平视图）对比，查找的是解析器/处理函数实际用到的几个头部
+void benchHeaders(size_t iterations) {
+    std::vector<std::pair<std::string_view, std::string_view>> fields;
+    const std::string_view                                     data{kBrowserRequest};
+    size_t line = data.find("\r\n") + 2;  // 跳过请求行
+    for (size_t end = data.find("\r\n", line); end != line; end = data.find("\r\n", line)) {
+        const auto text  = data.substr(line, end - line);
+        const auto colon = text.find(':');
+        fields.emplace_back(text.substr(0, colon), text.substr(colon + 2));
+        line = end + 2;
+    }
+
+    size_t checksum = 0;
+    auto   start    = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        std::unordered_map<std::string, std::string> headers;
+        for (const auto& [name, value] : fields) {
+            std::string key{name};
+            std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) {
+                return static_cast<char>(std::tolower(c));
+            });
+            headers[std::move(key)] = std::string{value};
+        }
+        for (const char* name : {"connection", "content-length", "transfer-encoding", "range"}) {
+            auto it = headers.find(name);
+            checksum += it == headers.end() ? 0 : it->second.size();
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("headers unordered_map        %8.1f ns/req (checksum %zu)\n",
+                elapsed.count() * 1e9 / static_cast<double>(iterations),
+                checksum);
+
+    checksum = 0;
+    start    = std::chrono::steady_clock::now();
+    HeaderList headers;  // 与解析器一样跨请求复用
+    for (size_t i = 0; i < iterations; ++i) {
+        headers.clear();
+        for (const auto& [name, value] : fields) {
+            headers.add(name, value);
+        }
+        for (HeaderId id : {HeaderId::CONNECTION,
+                            HeaderId::CONTENT_LENGTH,
+                            HeaderId::TRANSFER_ENCODING,
+                            HeaderId::RANGE}) {
+            checksum += headers.get(id).size();
+        }
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("headers HeaderList           %8.1f ns/req (checksum %zu)\n",
+                elapsed.count() * 1e9 / static_cast<double>(iterations),
+                checksum);
+}
+
+// 小响应序列化：追加到复用的输出缓冲（与 HttpServer 的输出批次相同）
+void benchSerialize(size_t iterations) {
+    HttpResponse resp;
+    resp.setStatus(StatusCode::kNotFound);
+    resp.setContentType("application/json; charset=utf-8");
+    resp.setBody("{\"status\":\"missing\"}");
+
+    std::string out;
+    resp.serializeTo(out, true);  // 预热：缓冲容量与 Date 缓存
+    const size_t allocationsBefore = gAllocations;
+    const auto   start             = std::chrono::steady_clock::now();
+    size_t       bytes             = 0;
+    for (size_t i = 0; i < iterations; ++i) {
+        out.clear();
+        resp.serializeTo(out, true);
+        bytes += out.size();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("serialize 404 json           %8.1f ns/resp, %.2f allocs/resp (%zu bytes)\n",
+                elapsed.count() * 1e9 / static_cast<double>(iterations),
+                static_cast<double>(gAllocations - allocationsBefore) /
+                    static_cast<double>(iterations),
+                bytes / iterations);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const size_t iterations = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 200000;
+
+    const scan::Kernel detected = scan::activeKernel();
+    if (!verifyKernels()) {
+        return 1;
+    }
+    std::printf("scan kernels match scalar path (detected: %s)\n", scan::kernelName(detected));
+
+    for (auto kernel : kAllKernels) {
+        if (scan::setKernel(kernel)) {
+            benchKernel(kernel, iterations);
+        }
+    }
+    benchHeaders(iterations);
+    benchSerialize(iterations);
+
+    for (auto kernel : kAllKernels) {
+        if (!scan::setKernel(kernel)) {
+            continue;
+        }
+        std::printf("-- parser with %s kernel\n", scan::kernelName(kernel));
+        report("browser GET (whole)", runSingle(kBrowserRequest, iterations, 0));
+        report("browser GET (64B pieces)", runSingle(kBrowserRequest, iterations, 64));
+        report("browser GET (1B pieces)", runSingle(kBrowserRequest, iterations / 20, 1));
+        report("upload POST 256B (whole)", runSingle(kUploadRequest, iterations, 0));
+        report("browser GET (pipelined x16)", runPipelined(kBrowserRequest, iterations / 16, 16));
+    }
+    return 0;
+}
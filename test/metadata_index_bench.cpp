@@ -0,0 +1,172 @@
+// 存储布局基准：同一组小文件分别放进平铺目录与分片布局，比较
+//   启动：平铺目录逐项 stat 扫描（同 FileIndex::rescan），分片布局读入元数据索引的日志；
+//   打开：按名字 open 全部文件，取得大小、mtime 与 ETag；
+//   删除：按名字删除全部文件。
+// 用法：metadata_index_bench [文件数=100000]
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "http/LocalDiskBackend.hpp"
+
+using namespace Http;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void report(const char* label, double seconds, size_t ops) {
+    std::printf("%-34s %9.3f s %9.0f ns/op\n", label, seconds, seconds * 1e9 / ops);
+}
+
+// 写一个临时文件交给 backend.place()，与续传会话提交的路径相同
+bool put(StorageBackend&              backend,
+         const std::filesystem::path& staging,
+         const std::string&           name,
+         const std::string&           content) {
+    const std::filesystem::path source = staging / name;
+    const int fd = ::open(source.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    const bool written =
+        fd >= 0 && ::write(fd, content.data(), content.size()) ==
+                       static_cast<ssize_t>(content.size());
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    StorageBackend::ObjectInfo info;
+    std::error_code            ec;
+    if (!written || !backend.place(source, name, Durability::NONE, info, ec)) {
+        std::fprintf(stderr, "place %s failed: %s\n", name.c_str(), ec.message().c_str());
+        return false;
+    }
+    return true;
+}
+
+// 平铺目录的启动扫描：逐项 stat，只保留普通文件
+size_t scan(const std::filesystem::path& dir) {
+    size_t          files = 0;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        struct stat st{};
+        if (::stat(entry.path().c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+            ++files;
+        }
+    }
+    return files;
+}
+
+bool openAll(StorageBackend& backend, const std::vector<std::string>& names) {
+    for (const auto& name : names) {
+        StorageBackend::Object object;
+        std::error_code        ec;
+        if (!backend.open(name, object, ec) || object.info.etag.empty()) {
+            std::fprintf(stderr, "open %s failed: %s\n", name.c_str(), ec.message().c_str());
+            return false;
+        }
+        ::close(object.fd);
+    }
+    return true;
+}
+
+bool removeAll(StorageBackend& backend, const std::vector<std::string>& names) {
+    for (const auto& name : names) {
+        std::error_code ec;
+        if (!backend.remove(name, ec)) {
+            std::fprintf(stderr, "remove %s failed: %s\n", name.c_str(), ec.message().c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const size_t count = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 100000;
+
+    char dirTemplate[] = "/tmp/metadata_index_bench.XXXXXX";
+    if (::mkdtemp(dirTemplate) == nullptr) {
+        std::perror("mkdtemp");
+        return 1;
+    }
+    const std::filesystem::path dir{dirTemplate};
+    const std::filesystem::path flatRoot    = dir / "flat";
+    const std::filesystem::path shardedRoot = dir / "sharded";
+    const std::filesystem::path staging     = dir / "staging";
+    std::filesystem::create_directories(flatRoot);
+    std::filesystem::create_directories(shardedRoot);
+    std::filesystem::create_directories(staging);
+
+    std::vector<std::string> names;
+    std::mt19937_64          rng(7);
+    bool                     ok = true;
+    {
+        LocalDiskBackend flat(flatRoot);
+        LocalDiskBackend sharded(
+            shardedRoot,
+            nullptr,
+            std::make_unique<MetadataIndex>(shardedRoot, shardedRoot / ".index"));
+        const auto start = Clock::now();
+        for (size_t i = 0; i < count && ok; ++i) {
+            names.push_back("file-" + std::to_string(i) + ".bin");
+            const std::string content = std::to_string(rng());
+            ok = put(flat, staging, names.back(), content) &&
+                 put(sharded, staging, names.back(), content);
+        }
+        std::printf("%zu files placed in %.1f s\n", count, secondsSince(start));
+    }
+    if (!ok) {
+        std::filesystem::remove_all(dir);
+        return 1;
+    }
+    std::shuffle(names.begin(), names.end(), rng);
+
+    auto         start   = Clock::now();
+    const size_t scanned = scan(flatRoot);
+    report("startup, flat directory scan", secondsSince(start), count);
+    start = Clock::now();
+    LocalDiskBackend sharded(shardedRoot,
+                             nullptr,
+                             std::make_unique<MetadataIndex>(shardedRoot, shardedRoot / ".index"));
+    report("startup, sharded index load", secondsSince(start), count);
+    if (scanned != count || sharded.index()->size() != count) {
+        std::fprintf(stderr,
+                     "expected %zu files, scanned %zu, indexed %zu\n",
+                     count,
+                     scanned,
+                     sharded.index()->size());
+        std::filesystem::remove_all(dir);
+        return 1;
+    }
+
+    LocalDiskBackend flat(flatRoot);
+    start = Clock::now();
+    ok    = openAll(flat, names);
+    report("open, flat", secondsSince(start), count);
+    start = Clock::now();
+    ok    = ok && openAll(sharded, names);
+    report("open, sharded", secondsSince(start), count);
+
+    start = Clock::now();
+    ok    = ok && removeAll(flat, names);
+    report("delete, flat", secondsSince(start), count);
+    start = Clock::now();
+    ok    = ok && removeAll(sharded, names);
+    report("delete, sharded", secondsSince(start), count);
+
+    std::filesystem::remove_all(dir);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+// 存储后端读取基准：同一组小文件分别放在本地目录、纯内存存储与“内存热层 + 本地目录”中，
+// 按下载路径的方式反复 open 并读出全部内容，比较每次读取的耗时。
+// 热层另测预算只有数据量四分之一的情形，观察 LRU 淘汰下的命中率。
+// 用法：storage_backend_bench [文件数=2000] [文件大小=4096] [轮数=20]
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "http/LocalDiskBackend.hpp"
+#include "http/MemoryBackend.hpp"
+
+using namespace Http;
+
+namespace {
+
+struct Result {
+    double   nsPerOp{0};
+    double   mibPerSec{0};
+    uint64_t checksum{0};  // 防止读取被优化掉
+    bool     ok{true};
+};
+
+// 写一个临时文件交给 backend.place()，与续传会话提交的路径相同
+bool put(StorageBackend&              backend,
+         const std::filesystem::path& staging,
+         const std::string&           name,
+         const std::string&           content) {
+    const std::filesystem::path source = staging / name;
+    const int fd = ::open(source.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    const bool written =
+        fd >= 0 && ::write(fd, content.data(), content.size()) ==
+                       static_cast<ssize_t>(content.size());
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    if (!written) {
+        std::perror("write");
+        return false;
+    }
+    StorageBackend::ObjectInfo info;
+    std::error_code            ec;
+    if (!backend.place(source, name, Durability::NONE, info, ec)) {
+        std::fprintf(stderr, "place %s: %s\n", name.c_str(), ec.message().c_str());
+        return false;
+    }
+    return true;
+}
+
+// 读出对象的全部内容：磁盘对象 pread 后关闭 fd，内存对象直接访问
+bool consume(StorageBackend::Object& object, std::string& buf, uint64_t& checksum) {
+    if (object.memory) {
+        const auto& memory = *object.memory;
+        for (size_t i = 0; i < memory.size; i += 512) {
+            checksum += static_cast<unsigned char>(memory.data[i]);
+        }
+        return true;
+    }
+    buf.resize(object.info.size);
+    const ssize_t n = ::pread(object.fd, buf.data(), buf.size(), 0);
+    ::close(object.fd);
+    if (n != static_cast<ssize_t>(buf.size())) {
+        return false;
+    }
+    for (size_t i = 0; i < buf.size(); i += 512) {
+        checksum += static_cast<unsigned char>(buf[i]);
+    }
+    return true;
+}
+
+Result run(StorageBackend&                 backend,
+           const std::vector<std::string>& names,
+           size_t                          rounds,
+           size_t                          size) {
+    Result      result;
+    std::string buf;
+    // 每轮打乱顺序，避免按插入顺序访问让 LRU 显得过于理想
+    std::vector<std::string> order = names;
+    std::mt19937             rng(42);
+    const auto               start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < rounds; ++round) {
+        std::shuffle(order.begin(), order.end(), rng);
+        for (const auto& name : order) {
+            StorageBackend::Object object;
+            std::error_code        ec;
+            if (!backend.open(name, object, ec) || !consume(object, buf, result.checksum)) {
+                std::fprintf(stderr, "read %s failed: %s\n", name.c_str(), ec.message().c_str());
+                result.ok = false;
+                return result;
+            }
+        }
+    }
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double ops = static_cast<double>(rounds * names.size());
+    result.nsPerOp   = seconds * 1e9 / ops;
+    result.mibPerSec = ops * static_cast<double>(size) / seconds / (1024.0 * 1024.0);
+    return result;
+}
+
+void report(const char* label, const Result& result) {
+    std::printf("%-34s %9.0f ns/read %10.1f MiB/s\n", label, result.nsPerOp, result.mibPerSec);
+}
+
+void reportTier(const MemoryBackend& tier) {
+    const MemoryBackend::Stats s = tier.stats();
+    const double hitRate = s.hits + s.misses == 0 ? 0.0 : 100.0 * s.hits / (s.hits + s.misses);
+    std::printf("%-34s %9.1f%% hits, %zu entries, %llu promotions, %llu evictions\n",
+                "",
+                hitRate,
+                s.entries,
+                static_cast<unsigned long long>(s.promotions),
+                static_cast<unsigned long long>(s.evictions));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const size_t count  = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    const size_t size   = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 4096;
+    const size_t rounds = (argc > 3) ? std::strtoul(argv[3], nullptr, 10) : 20;
+
+    char dirTemplate[] = "/tmp/storage_backend_bench.XXXXXX";
+    if (::mkdtemp(dirTemplate) == nullptr) {
+        std::perror("mkdtemp");
+        return 1;
+    }
+    const std::filesystem::path dir{dirTemplate};
+    const std::filesystem::path root    = dir / "files";
+    const std::filesystem::path staging = dir / "staging";
+    std::filesystem::create_directories(root);
+    std::filesystem::create_directories(staging);
+
+    // 热层默认只提升不超过 64 KiB 的对象，这里放宽到文件大小，让每个文件都可以提升
+    const size_t             total     = count * size;
+    const uint64_t           maxObject = size;
+    std::vector<std::string> names;
+    std::mt19937_64          rng(7);
+    LocalDiskBackend         disk(root);
+    MemoryBackend            memory(total);
+    bool                     ok = true;
+    for (size_t i = 0; i < count && ok; ++i) {
+        std::string content(size, '\0');
+        for (auto& c : content) {
+            c = static_cast<char>(rng());
+        }
+        names.push_back("file-" + std::to_string(i) + ".bin");
+        ok = put(disk, staging, names.back(), content) &&
+             put(memory, staging, names.back(), content);
+    }
+    if (!ok) {
+        std::filesystem::remove_all(dir);
+        return 1;
+    }
+    std::printf("%zu files x %zu bytes, %zu rounds\n", count, size, rounds);
+
+    const Result onDisk = run(disk, names, rounds, size);
+    report("local disk (page cache)", onDisk);
+    const Result inMemory = run(memory, names, rounds, size);
+    report("memory (primary)", inMemory);
+
+    MemoryBackend hot(total, std::make_unique<LocalDiskBackend>(root), maxObject);
+    const Result  tiered = run(hot, names, rounds, size);
+    report("memory hot tier over disk", tiered);
+    reportTier(hot);
+
+    MemoryBackend small(total / 4, std::make_unique<LocalDiskBackend>(root), maxObject);
+    const Result  thrash = run(small, names, rounds, size);
+    report("hot tier, budget = 1/4 of data", thrash);
+    reportTier(small);
+
+    std::filesystem::remove_all(dir);
+    const bool consistent = onDisk.checksum == inMemory.checksum &&
+                            onDisk.checksum == tiered.checksum &&
+                            onDisk.checksum == thrash.checksum;
+    if (!onDisk.ok || !inMemory.ok || !tiered.ok || !thrash.ok || !consistent) {
+        std::fprintf(stderr, "backends returned different content\n");
+        return 1;
+    }
+    return 0;
+}